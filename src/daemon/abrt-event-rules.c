@@ -0,0 +1,622 @@
+/*
+    Copyright (C) 2016  RedHat inc.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include <glob.h>
+#include <poll.h>
+#include <regex.h>
+#include "libabrt.h"
+#include "abrt-event-rules.h"
+
+#define MAX_INCLUDE_DEPTH 10
+
+#define OUTPUTS_DECLARATION "@outputs:"
+#define INPUTS_DECLARATION "@inputs:"
+
+struct event_rule
+{
+    char *origin;       ///< file:line for log messages
+    GList *conditions;  ///< "VAR=VAL", "VAR!=VAL", "VAR~=REGEX", "VAR!~=REGEX"
+    struct strbuf *command;
+    GList *inputs;      ///< element names read by the rule
+    GList *outputs;     ///< element names written by the rule
+};
+
+struct abrt_event_rules
+{
+    char *event_name;
+    GPtrArray *rules;
+};
+
+enum rule_status
+{
+    RULE_WAITING,
+    RULE_RUNNING,
+    RULE_DONE,
+};
+
+struct rule_job
+{
+    struct event_rule *rule;
+    unsigned index;     ///< index of the rule
+    pid_t pid;
+    int fd;
+    struct strbuf *output;
+};
+
+static void event_rule_free(struct event_rule *rule)
+{
+    if (rule == NULL)
+        return;
+
+    free(rule->origin);
+    list_free_with_free(rule->conditions);
+    strbuf_free(rule->command);
+    list_free_with_free(rule->inputs);
+    list_free_with_free(rule->outputs);
+    free(rule);
+}
+
+/* Rules without declared outputs can read and write anything. */
+static bool event_rule_is_barrier(const struct event_rule *rule)
+{
+    return rule->outputs == NULL;
+}
+
+static bool lists_intersect(GList *a, GList *b)
+{
+    for (; a != NULL; a = g_list_next(a))
+        if (g_list_find_custom(b, a->data, (GCompareFunc)strcmp) != NULL)
+            return true;
+
+    return false;
+}
+
+/* Returns true if 'later' must not start before 'earlier' finishes. */
+static bool event_rule_depends_on(const struct event_rule *later, const struct event_rule *earlier)
+{
+    if (event_rule_is_barrier(later) || event_rule_is_barrier(earlier))
+        return true;
+
+    return lists_intersect(earlier->outputs, later->inputs)
+        || lists_intersect(earlier->outputs, later->outputs)
+        || lists_intersect(earlier->inputs, later->outputs);
+}
+
+static GList *parse_element_names(GList *list, const char *names)
+{
+    char *copy = xstrdup(names);
+    char *saveptr = NULL;
+    for (char *name = strtok_r(copy, " \t,", &saveptr);
+         name != NULL;
+         name = strtok_r(NULL, " \t,", &saveptr))
+    {
+        list = g_list_append(list, xstrdup(name));
+    }
+    free(copy);
+    return list;
+}
+
+static void event_rule_add_command_line(struct event_rule *rule, const char *line)
+{
+    const char *text = skip_whitespace(line);
+    if (text[0] == '#')
+    {
+        text = skip_whitespace(text + 1);
+        if (prefixcmp(text, OUTPUTS_DECLARATION) == 0)
+            rule->outputs = parse_element_names(rule->outputs, text + strlen(OUTPUTS_DECLARATION));
+        else if (prefixcmp(text, INPUTS_DECLARATION) == 0)
+            rule->inputs = parse_element_names(rule->inputs, text + strlen(INPUTS_DECLARATION));
+    }
+
+    strbuf_append_strf(rule->command, "%s\n", line);
+}
+
+enum condition_parse_result
+{
+    CONDITION_PARSED,
+    CONDITION_NONE,     ///< the word is not a condition, the command starts here
+    CONDITION_INVALID,
+};
+
+/* Parses the condition at *pp the same way libreport does: conditions are
+ * separated by white space, a value can be enclosed in double quotes to
+ * include white space and \" and \\ are escape sequences within the quotes.
+ * The condition is stored with the quotes removed and *pp is moved behind
+ * the condition.
+ */
+static enum condition_parse_result parse_condition(const char **pp, char **condition)
+{
+    const char *p = *pp;
+    const char *eq = p;
+    while (*eq != '\0' && *eq != '=' && *eq != '"' && !isspace(*eq))
+        ++eq;
+
+    if (*eq != '=')
+        return CONDITION_NONE;
+
+    if (eq == p)
+        return CONDITION_INVALID;
+
+    struct strbuf *cond = strbuf_new();
+    strbuf_append_strf(cond, "%.*s=", (int)(eq - p), p);
+
+    bool quoted = false;
+    for (p = eq + 1; *p != '\0' && (quoted || !isspace(*p)); ++p)
+    {
+        if (*p == '"')
+        {
+            quoted = !quoted;
+            continue;
+        }
+
+        if (quoted && *p == '\\' && (p[1] == '"' || p[1] == '\\'))
+            ++p;
+
+        strbuf_append_char(cond, *p);
+    }
+
+    if (quoted)
+    {
+        strbuf_free(cond);
+        return CONDITION_INVALID;
+    }
+
+    *condition = strbuf_free_nobuf(cond);
+    *pp = skip_whitespace(p);
+    return CONDITION_PARSED;
+}
+
+/* Returns a new rule or NULL if the rule does not belong to the event. */
+static struct event_rule *event_rule_new(const char *line, const char *event_name, const char *origin)
+{
+    struct event_rule *rule = xzalloc(sizeof(*rule));
+    rule->origin = xstrdup(origin);
+    rule->command = strbuf_new();
+
+    const char *p = skip_whitespace(line);
+    while (*p != '\0')
+    {
+        char *cond = NULL;
+        const enum condition_parse_result r = parse_condition(&p, &cond);
+        if (r == CONDITION_NONE)
+        {
+            /* The rest of the line is the first line of the command */
+            event_rule_add_command_line(rule, p);
+            break;
+        }
+
+        if (r == CONDITION_INVALID)
+        {
+            error_msg("%s: invalid condition '%s', ignoring the rule", origin, p);
+            goto skip;
+        }
+
+        char *eq = strchr(cond, '=');
+        if (prefixcmp(cond, "EVENT=") == 0)
+        {
+            const bool other_event = strcmp(eq + 1, event_name) != 0;
+            free(cond);
+            if (other_event)
+                goto skip;
+            continue;
+        }
+
+        rule->conditions = g_list_append(rule->conditions, cond);
+
+        char *name_end = eq;
+        while (name_end > cond && (name_end[-1] == '!' || name_end[-1] == '~'))
+            --name_end;
+        rule->inputs = g_list_append(rule->inputs, xstrndup(cond, name_end - cond));
+    }
+
+    return rule;
+
+ skip:
+    event_rule_free(rule);
+    return NULL;
+}
+
+static void load_rule_file(struct abrt_event_rules *rules, const char *conf_file_name, unsigned depth);
+
+static void include_rule_files(struct abrt_event_rules *rules, const char *conf_file_name,
+                               const char *pattern, unsigned depth)
+{
+    char *path = NULL;
+    if (pattern[0] != '/')
+    {
+        /* Relative paths are relative to the including file */
+        const char *slash = strrchr(conf_file_name, '/');
+        if (slash != NULL)
+        {
+            char *dir = xstrndup(conf_file_name, slash - conf_file_name);
+            path = concat_path_file(dir, pattern);
+            free(dir);
+        }
+    }
+
+    glob_t globbuf;
+    memset(&globbuf, 0, sizeof(globbuf));
+    if (glob(path ? path : pattern, 0, NULL, &globbuf) == 0)
+    {
+        for (size_t i = 0; i < globbuf.gl_pathc; ++i)
+            load_rule_file(rules, globbuf.gl_pathv[i], depth + 1);
+    }
+    globfree(&globbuf);
+    free(path);
+}
+
+static void load_rule_file(struct abrt_event_rules *rules, const char *conf_file_name, unsigned depth)
+{
+    if (depth > MAX_INCLUDE_DEPTH)
+    {
+        error_msg("Too deep include nesting in '%s'", conf_file_name);
+        return;
+    }
+
+    FILE *fp = fopen(conf_file_name, "r");
+    if (fp == NULL)
+    {
+        perror_msg("Can't open '%s'", conf_file_name);
+        return;
+    }
+
+    /* NULL if the current rule is commented out or belongs to another event */
+    struct event_rule *cur_rule = NULL;
+    unsigned lineno = 0;
+    char *line;
+    while ((line = xmalloc_fgetline(fp)) != NULL)
+    {
+        ++lineno;
+
+        if (line[0] == ' ' || line[0] == '\t')
+        {
+            if (cur_rule != NULL)
+                event_rule_add_command_line(cur_rule, line);
+            goto next_line;
+        }
+
+        if (line[0] == '\0')
+            goto next_line;
+
+        cur_rule = NULL;
+
+        /* One # is sufficient to comment out even a multi-line rule */
+        if (line[0] == '#')
+            goto next_line;
+
+        if (prefixcmp(line, "include") == 0 && isspace(line[strlen("include")]))
+        {
+            include_rule_files(rules, conf_file_name, skip_whitespace(line + strlen("include")), depth);
+            goto next_line;
+        }
+
+        char *origin = xasprintf("%s:%u", conf_file_name, lineno);
+        cur_rule = event_rule_new(line, rules->event_name, origin);
+        free(origin);
+        if (cur_rule != NULL)
+            g_ptr_array_add(rules->rules, cur_rule);
+
+ next_line:
+        free(line);
+    }
+
+    fclose(fp);
+}
+
+struct abrt_event_rules *abrt_event_rules_load(const char *conf_file_name, const char *event_name)
+{
+    struct abrt_event_rules *rules = xzalloc(sizeof(*rules));
+    rules->event_name = xstrdup(event_name);
+    rules->rules = g_ptr_array_new_with_free_func((GDestroyNotify)event_rule_free);
+
+    load_rule_file(rules, conf_file_name, /*depth*/0);
+
+    log_debug("Loaded %u rules for event '%s'", rules->rules->len, event_name);
+    return rules;
+}
+
+void abrt_event_rules_free(struct abrt_event_rules *rules)
+{
+    if (rules == NULL)
+        return;
+
+    g_ptr_array_free(rules->rules, TRUE);
+    free(rules->event_name);
+    free(rules);
+}
+
+/* A copy of libreport's regcmp_lines(): the value matches if any of its
+ * lines matches the basic regular expression. Returns 0 on match. */
+static int regcmp_lines(char *val, const char *regex)
+{
+    regex_t rx;
+    int r = regcomp(&rx, regex, REG_NOSUB);
+    if (r)
+    {
+        error_msg("Bad regexp '%s'", regex);
+        return r;
+    }
+
+    /* Check every line */
+    while (1)
+    {
+        char *eol = strchr(val, '\n');
+        if (eol)
+            *eol = '\0';
+        r = regexec(&rx, val, 0, NULL, /*eflags:*/ 0);
+        if (eol)
+            *eol = '\n';
+        if (r == 0 || !eol)
+            break;
+        val = eol + 1;
+    }
+    /* Here, r == 0 if match was found */
+    regfree(&rx);
+    return r;
+}
+
+static bool event_rule_condition_matches(const char *cond, struct dump_dir *dd)
+{
+    const char *eq = strchr(cond, '=');
+    const char *name_end = eq;
+    bool regex = false;
+    bool negate = false;
+    if (name_end > cond && name_end[-1] == '~')
+    {
+        regex = true;
+        --name_end;
+    }
+    if (name_end > cond && name_end[-1] == '!')
+    {
+        negate = true;
+        --name_end;
+    }
+
+    char *name = xstrndup(cond, name_end - cond);
+    char *value = dd_load_text_ext(dd, name,
+                                   DD_FAIL_QUIETLY_ENOENT | DD_FAIL_QUIETLY_EACCES);
+    free(name);
+
+    bool matches;
+    if (regex)
+        matches = regcmp_lines(value, eq + 1) == 0;
+    else
+        matches = strcmp(value, eq + 1) == 0;
+
+    free(value);
+    return matches != negate;
+}
+
+static bool event_rule_matches(const struct event_rule *rule, const char *dump_dir_name)
+{
+    if (rule->conditions == NULL)
+        return true;
+
+    struct dump_dir *dd = dd_opendir(dump_dir_name, DD_OPEN_READONLY);
+    if (dd == NULL)
+        return false;
+
+    bool matches = true;
+    for (GList *iter = rule->conditions; matches && iter != NULL; iter = g_list_next(iter))
+        matches = event_rule_condition_matches(iter->data, dd);
+
+    dd_close(dd);
+    return matches;
+}
+
+static bool event_rule_start(struct rule_job *job, struct event_rule *rule,
+                             const char *dump_dir_name, const char *event_name)
+{
+    char *argv[4];
+    argv[0] = (char *)"/bin/sh";
+    argv[1] = (char *)"-c";
+    argv[2] = rule->command->buf;
+    argv[3] = NULL;
+
+    char *env_vec[3];
+    env_vec[0] = xasprintf("DUMP_DIR=%s", dump_dir_name);
+    env_vec[1] = xasprintf("EVENT=%s", event_name);
+    env_vec[2] = NULL;
+
+    int pipeout[2];
+    int flags = EXECFLG_INPUT_NUL | EXECFLG_OUTPUT | EXECFLG_ERR2OUT | EXECFLG_QUIET;
+    VERB1 flags &= ~EXECFLG_QUIET;
+
+    log_debug("Running rule %s", rule->origin);
+    job->rule = rule;
+    job->pid = fork_execv_on_steroids(flags, argv, pipeout, env_vec, dump_dir_name, /*uid(unused):*/0);
+    job->fd = pipeout[0];
+    job->output = strbuf_new();
+    ndelay_on(job->fd);
+
+    free(env_vec[0]);
+    free(env_vec[1]);
+    return job->pid > 0;
+}
+
+static void rule_job_log_lines(struct rule_job *job, struct run_event_state *state, bool flush)
+{
+    char *start = job->output->buf;
+    char *end;
+    while ((end = strchr(start, '\n')) != NULL || (flush && start[0] != '\0'))
+    {
+        char *line = end ? xstrndup(start, end - start) : xstrdup(start);
+        start = end ? end + 1 : start + strlen(start);
+
+        if (state->logging_callback)
+            line = state->logging_callback(line, state->logging_param);
+        free(line);
+    }
+
+    /* Keep the incomplete line */
+    char *rest = xstrdup(start);
+    strbuf_clear(job->output);
+    strbuf_append_str(job->output, rest);
+    free(rest);
+}
+
+/* Reads output of the job, returns false on EOF */
+static bool rule_job_read(struct rule_job *job, struct run_event_state *state)
+{
+    char buf[4096];
+    ssize_t r = safe_read(job->fd, buf, sizeof(buf) - 1);
+    if (r < 0 && errno == EAGAIN)
+        return true;
+
+    if (r <= 0)
+    {
+        rule_job_log_lines(job, state, /*flush*/true);
+        return false;
+    }
+
+    buf[r] = '\0';
+    strbuf_append_str(job->output, buf);
+    rule_job_log_lines(job, state, /*flush*/false);
+    return true;
+}
+
+/* Waits for the job and returns the exit code in the same form as
+ * run_event_on_dir_name() does. */
+static int rule_job_finish(struct rule_job *job)
+{
+    close(job->fd);
+    strbuf_free(job->output);
+
+    int status;
+    safe_waitpid(job->pid, &status, 0);
+
+    int retval = WEXITSTATUS(status);
+    if (WIFSIGNALED(status))
+        retval = WTERMSIG(status) + 128;
+
+    if (retval != 0)
+        log_notice("Rule %s exited with %d", job->rule->origin, retval);
+    return retval;
+}
+
+int abrt_event_rules_run(struct abrt_event_rules *rules,
+                         struct run_event_state *state,
+                         const char *dump_dir_name,
+                         unsigned max_jobs)
+{
+    if (max_jobs == 0)
+        max_jobs = 1;
+
+    const unsigned rules_count = rules->rules->len;
+    enum rule_status *status = xzalloc(rules_count * sizeof(status[0]));
+    struct rule_job *jobs = xzalloc(max_jobs * sizeof(jobs[0]));
+    struct pollfd *pfds = xzalloc(max_jobs * sizeof(pfds[0]));
+    unsigned running = 0;
+    /* Rules before this index are done */
+    unsigned first_waiting = 0;
+    bool stop = false;
+    int retval = 0;
+
+    while (true)
+    {
+        /* Start all rules whose predecessors have finished */
+        for (unsigned i = first_waiting; !stop && running < max_jobs && i < rules_count; ++i)
+        {
+            if (status[i] != RULE_WAITING)
+                continue;
+
+            struct event_rule *rule = g_ptr_array_index(rules->rules, i);
+            bool ready = true;
+            for (unsigned j = first_waiting; ready && j < i; ++j)
+                ready = status[j] == RULE_DONE
+                        || !event_rule_depends_on(rule, g_ptr_array_index(rules->rules, j));
+
+            if (!ready)
+            {
+                /* Nothing can overtake a barrier */
+                if (event_rule_is_barrier(rule))
+                    break;
+                continue;
+            }
+
+            /* Conditions are checked right before the start, so they see
+             * outputs of all rules the rule depends on */
+            if (!event_rule_matches(rule, dump_dir_name))
+            {
+                status[i] = RULE_DONE;
+                continue;
+            }
+
+            if (!event_rule_start(&jobs[running], rule, dump_dir_name, rules->event_name))
+            {
+                retval = 1;
+                stop = true;
+                break;
+            }
+
+            jobs[running].index = i;
+            status[i] = RULE_RUNNING;
+            state->children_count++;
+            ++running;
+        }
+
+        while (first_waiting < rules_count && status[first_waiting] == RULE_DONE)
+            ++first_waiting;
+
+        if (running == 0)
+            break;
+
+        for (unsigned i = 0; i < running; ++i)
+        {
+            pfds[i].fd = jobs[i].fd;
+            pfds[i].events = POLLIN;
+            pfds[i].revents = 0;
+        }
+
+        if (poll(pfds, running, -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            perror_msg_and_die("poll");
+        }
+
+        for (unsigned i = running; i-- > 0;)
+        {
+            if (pfds[i].revents == 0 || rule_job_read(&jobs[i], state))
+                continue;
+
+            const int r = rule_job_finish(&jobs[i]);
+            status[jobs[i].index] = RULE_DONE;
+
+            /* Keep the running jobs packed at the beginning of the array */
+            jobs[i] = jobs[--running];
+
+            if (r != 0 && retval == 0)
+            {
+                retval = r;
+                stop = true;
+            }
+
+            /* Nobody is writing the dump directory now */
+            if (!stop && running == 0 && state->post_run_callback
+                && state->post_run_callback(dump_dir_name, state->post_run_param) != 0)
+            {
+                stop = true;
+            }
+        }
+    }
+
+    free(pfds);
+    free(jobs);
+    free(status);
+    return retval;
+}
@@ -0,0 +1,64 @@
+/*
+    Copyright (C) 2016  RedHat inc.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef _ABRT_EVENT_RULES_H_
+#define _ABRT_EVENT_RULES_H_
+
+#include <libreport/run_event.h>
+
+/* Event rules read from the libreport's event configuration files
+ * (see abrt_event.conf for description of the format). Conditions are parsed
+ * and evaluated the same way libreport does it, including values in double
+ * quotes and "~=" matching any line of the value against a basic regular
+ * expression.
+ *
+ * A rule can declare the problem elements it writes on a line
+ * "# @outputs: element ..." and the problem elements it reads, in addition to
+ * the elements used in its conditions, on a line "# @inputs: element ...".
+ * Such rules are run concurrently with other rules unless one of them writes
+ * an element the other one reads or writes. Rules without the declaration
+ * wait until all previous rules finish and no subsequent rule is started
+ * before they finish.
+ */
+struct abrt_event_rules;
+
+/* Loads rules of the event 'event_name' from the configuration file
+ * 'conf_file_name' and the files it includes.
+ */
+struct abrt_event_rules *
+abrt_event_rules_load(const char *conf_file_name, const char *event_name);
+
+void
+abrt_event_rules_free(struct abrt_event_rules *rules);
+
+/* Runs the rules on the dump directory, at most 'max_jobs' of them at the
+ * same time.
+ *
+ * The members children_count, post_run_callback and logging_callback of
+ * 'state' are used in the same way as run_event_on_dir_name() does, but
+ * post_run_callback is called only at the moments when no rule is running.
+ *
+ * Returns the exit code of the first failed rule or 0.
+ */
+int
+abrt_event_rules_run(struct abrt_event_rules *rules,
+                     struct run_event_state *state,
+                     const char *dump_dir_name,
+                     unsigned max_jobs);
+
+#endif /*_ABRT_EVENT_RULES_H_*/
@@ -21,12 +21,23 @@
 #include <satyr/distance.h>
 #include <satyr/abrt.h>
 
+#include <sys/un.h>
+#include <glib-unix.h>
 #include "libabrt.h"
+#include "abrt_glib.h"
+#include "abrt-inotify.h"
+#include "abrt-event-rules.h"
 #include <libreport/run_event.h>
 
 /* 70 % similarity */
 #define BACKTRACE_DUP_THRESHOLD 0.3
 
+/* Maximal size of an event server request */
+#define MAX_REQUEST_SIZE (8*1024)
+/* Event server children exit after this many seconds if the request is not
+ * received */
+#define REQUEST_TIMEOUT 10
+
 static char *uid = NULL;
 static char *uuid = NULL;
 static struct sr_stacktrace *corebt = NULL;
@@ -34,6 +45,10 @@ static char *type = NULL;
 static char *executable = NULL;
 static char *crash_dump_dup_name = NULL;
 
+/* Event server: event name -> struct abrt_event_rules, the forked request
+ * handlers inherit the parsed rules. NULL outside the server. */
+static GHashTable *s_event_rules = NULL;
+
 static void dup_corebt_fini(void);
 
 static char* load_backtrace(const struct dump_dir *dd)
@@ -334,6 +349,457 @@ static char *do_log(char *log_line, void *param)
     return log_line;
 }
 
+/* Saves the cached host facts before post-create rules run, so the rules do
+ * not need to generate them for every problem.
+ */
+static void save_host_facts(const char *dump_dir_name)
+{
+    struct dump_dir *dd = dd_opendir(dump_dir_name, /*flags:*/ 0);
+    if (!dd)
+        return;
+
+    /* Uploaded problems come from another host */
+    if (!dd_exist(dd, FILENAME_REMOTE) && !dd_exist(dd, "cpuinfo"))
+        dd_save_host_fact(dd, HOST_FACT_CPUINFO, "cpuinfo");
+
+    dd_close(dd);
+}
+
+/* Runs the event on the dump directory. Dies with "DUP_OF_DIR: " message if
+ * the dump directory is a duplicate of an existing one.
+ */
+static int handle_event_on_dump_dir(const char *event_name, char *dump_dir_name, int interactive)
+{
+    int i = strlen(dump_dir_name);
+    while (--i >= 0)
+        if (dump_dir_name[i] != '/')
+            break;
+    dump_dir_name[++i] = '\0';
+
+    struct dump_dir *dd = dd_opendir(dump_dir_name, /*flags:*/ DD_OPEN_READONLY);
+    if (!dd)
+        return 1;
+
+    uid = dd_load_text_ext(dd, FILENAME_UID, DD_FAIL_QUIETLY_ENOENT);
+    dd_close(dd);
+
+    struct run_event_state *run_state = new_run_event_state();
+    if (!interactive)
+        make_run_event_state_forwarding(run_state);
+    run_state->logging_callback = do_log;
+    if (strcmp(event_name, "post-create") == 0)
+    {
+        save_host_facts(dump_dir_name);
+        run_state->post_run_callback = is_crash_a_dup;
+    }
+
+    int r;
+    struct abrt_event_rules *cached = s_event_rules != NULL
+                                      ? g_hash_table_lookup(s_event_rules, event_name)
+                                      : NULL;
+    if (run_state->post_run_callback != NULL || cached != NULL)
+    {
+        /* Independent post-create rules can run concurrently. The rules
+         * are run by the same code whatever the parallelism is, so they
+         * always match the same way. */
+        struct abrt_event_rules *rules = cached != NULL ? cached
+                                                        : abrt_event_rules_load(REPORT_EVENT_CONF, event_name);
+        const unsigned max_jobs = run_state->post_run_callback != NULL
+                                  ? g_settings_post_create_parallelism
+                                  : 1;
+        r = abrt_event_rules_run(rules, run_state, dump_dir_name, max_jobs);
+        if (rules != cached)
+            abrt_event_rules_free(rules);
+    }
+    else
+        r = run_event_on_dir_name(run_state, dump_dir_name, event_name);
+
+    const bool no_action_for_event = (r == 0 && run_state->children_count == 0);
+
+    free_run_event_state(run_state);
+    /* Needed only if is_crash_a_dup() was called, but harmless
+     * even if it wasn't:
+     */
+    dup_uuid_fini();
+    dup_corebt_fini();
+    free(uid);
+    uid = NULL;
+
+    if (no_action_for_event)
+        error_msg_and_die("No actions are found for event '%s'", event_name);
+
+//TODO: consider this case:
+// new dump is created, post-create detects that it is a dup,
+// but then load_crash_info(dup_name) *FAILS*.
+// In this case, we later delete damaged dup_name (right?)
+// but new dump never gets its FILENAME_COUNT set!
+
+    /* Is crash a dup? (In this case, is_crash_a_dup() should have
+     * aborted "post-create" event processing as soon as it saw uuid
+     * and determined that there is another crash with same uuid.
+     * In this case it sets crash_dump_dup_name)
+     */
+    if (crash_dump_dup_name)
+        error_msg_and_die("DUP_OF_DIR: %s", crash_dump_dup_name);
+
+    return r;
+}
+
+static void set_nice_increment(int nice_incr)
+{
+    const char *const opt_env_nice = getenv("ABRT_EVENT_NICE");
+    if (opt_env_nice != NULL && opt_env_nice[0] != '\0')
+    {
+        log_debug("Using ABRT_EVENT_NICE=%s to increment the nice value", opt_env_nice);
+        nice_incr = xatoi(opt_env_nice);
+    }
+
+    if (nice_incr != 0)
+    {
+        log_debug("Incrementing the nice value by %d", nice_incr);
+        const int ret = nice(nice_incr);
+        if (ret == -1)
+            perror_msg_and_die("Failed to increment the nice value");
+    }
+}
+
+/*
+Event server
+
+abrtd starts 'abrt-handle-event --server' which listens on
+ABRT_EVENT_SOCKET_FILE. The server has libreport, satyr and abrt.conf loaded
+and keeps the parsed rules of the events requested by abrt-server
+(post-create, notify and notify-dup). The request handlers are forked from
+the server and use its rules, so neither exec() nor parsing of the event
+configuration is repeated for every problem. abrt.conf is reloaded and the
+rules are dropped and parsed again when their files change.
+
+** Protocol
+
+The client (abrt-server) sends "KEY=value\0" items terminated by an empty
+item "\0":
+-> "EVENT="
+   string
+-> "DIR="
+   string (path to a problem directory)
+-> "NICE="
+   number (optional)
+
+The client passes the write end of a pipe in SCM_RIGHTS ancillary data along
+with the request. The server streams the output of the event to the client
+over the socket and writes the exit status of the event handler, an int as
+returned by waitpid(), to the pipe. The status is never a part of the stream,
+thus the scripts cannot forge it.
+*/
+
+/* Reads a part of the request and picks up the file descriptor passed along
+ * with it */
+static ssize_t read_request(int sockfd, char *buf, size_t size, int *passed_fd)
+{
+    char control[CMSG_SPACE(sizeof(int))];
+    struct iovec iov = { .iov_base = buf, .iov_len = size };
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t r;
+    do
+        r = recvmsg(sockfd, &msg, MSG_CMSG_CLOEXEC);
+    while (r < 0 && errno == EINTR);
+
+    if (r < 0)
+        return r;
+
+    if (msg.msg_flags & MSG_CTRUNC)
+        error_msg_and_die("Too many file descriptors passed with the request");
+
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+            continue;
+
+        if (*passed_fd >= 0 || cmsg->cmsg_len != CMSG_LEN(sizeof(int)))
+            error_msg_and_die("Unexpected file descriptors passed with the request");
+
+        memcpy(passed_fd, CMSG_DATA(cmsg), sizeof(int));
+    }
+
+    return r;
+}
+
+static void NORETURN serve_event_request(int sockfd, pid_t client_pid)
+{
+    /* We are the forked child of the server */
+    signal(SIGCHLD, SIG_DFL);
+    alarm(REQUEST_TIMEOUT);
+
+    char *event_name = NULL;
+    char *dump_dir_name = NULL;
+    int nice_incr = 0;
+    int status_fd = -1;
+
+    char buf[MAX_REQUEST_SIZE];
+    size_t len = 0;
+    size_t item = 0;
+    for (;;)
+    {
+        /* Parse all complete items in the buffer */
+        char *end;
+        while ((end = memchr(buf + item, '\0', len - item)) != NULL)
+        {
+            const char *value = buf + item;
+            if (value[0] == '\0')
+                goto request_done;
+
+            if (prefixcmp(value, "EVENT=") == 0)
+                event_name = xstrdup(value + strlen("EVENT="));
+            else if (prefixcmp(value, "DIR=") == 0)
+                dump_dir_name = xstrdup(value + strlen("DIR="));
+            else if (prefixcmp(value, "NICE=") == 0)
+                nice_incr = xatoi(value + strlen("NICE="));
+            else
+                error_msg_and_die("Unrecognized request item '%s'", value);
+
+            item = end - buf + 1;
+        }
+
+        if (len == sizeof(buf))
+            error_msg_and_die("Request is too long");
+
+        const ssize_t r = read_request(sockfd, buf + len, sizeof(buf) - len, &status_fd);
+        if (r <= 0)
+            error_msg_and_die("Incomplete request");
+        len += r;
+    }
+
+ request_done:
+    alarm(0);
+    if (event_name == NULL || dump_dir_name == NULL)
+        error_msg_and_die("Both EVENT and DIR must be specified");
+
+    if (status_fd < 0)
+        error_msg_and_die("The request does not carry the exit status pipe");
+
+    log_debug("Running event '%s' on '%s' for %d", event_name, dump_dir_name, client_pid);
+
+    fflush(NULL); /* paranoia */
+    const pid_t pid = fork();
+    if (pid < 0)
+        perror_msg_and_die("fork");
+
+    if (pid == 0)
+    {
+        close(status_fd);
+
+        xmove_fd(xopen("/dev/null", O_RDONLY), STDIN_FILENO);
+        xdup2(sockfd, STDOUT_FILENO);
+        xdup2(sockfd, STDERR_FILENO);
+        close(sockfd);
+
+        /* Intercept ASK_* messages in Client API -> don't wait for user response */
+        xsetenv("REPORT_CLIENT_NONINTERACTIVE", "1");
+        char *pid_str = xasprintf("%d", client_pid);
+        xsetenv(ABRT_SERVER_EVENT_ENV, pid_str);
+        free(pid_str);
+
+        set_nice_increment(nice_incr);
+
+        /* Do not forward ASK_* messages to parent */
+        exit(handle_event_on_dump_dir(event_name, dump_dir_name, /*interactive*/1));
+    }
+
+    /* The output stream ends once the handler and its scripts close it */
+    close(sockfd);
+
+    int status;
+    if (safe_waitpid(pid, &status, 0) <= 0)
+    {
+        perror_msg("waitpid(%d)", pid);
+        /* Pretend the handler was killed */
+        status = SIGKILL;
+    }
+
+    log_debug("Event handler (%d) finished with status %d", pid, status);
+    if (full_write(status_fd, &status, sizeof(status)) != sizeof(status))
+        perror_msg("Can't send exit status of event handler (%d)", pid);
+
+    exit(0);
+}
+
+/* Events run by abrt-server */
+static const char *const s_served_events[] = {
+    "post-create",
+    "notify",
+    "notify-dup",
+};
+
+static void event_rules_cache_fill(void)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(s_served_events); ++i)
+    {
+        if (g_hash_table_contains(s_event_rules, s_served_events[i]))
+            continue;
+
+        g_hash_table_insert(s_event_rules,
+                            (gpointer)s_served_events[i],
+                            abrt_event_rules_load(REPORT_EVENT_CONF, s_served_events[i]));
+    }
+}
+
+static void event_request_finished_cb(GPid pid, gint status, gpointer user_data)
+{
+    log_debug("Event request (%d) finished with status %d", pid, status);
+    g_spawn_close_pid(pid);
+}
+
+static gboolean event_server_socket_cb(GIOChannel *source, GIOCondition condition, gpointer user_data)
+{
+    const int sockfd = accept4(g_io_channel_unix_get_fd(source), NULL, NULL, SOCK_CLOEXEC);
+    if (sockfd < 0)
+    {
+        perror_msg("accept");
+        return TRUE;
+    }
+
+    struct ucred cr;
+    socklen_t crlen = sizeof(cr);
+    if (getsockopt(sockfd, SOL_SOCKET, SO_PEERCRED, &cr, &crlen) != 0 || crlen != sizeof(cr))
+    {
+        perror_msg("Can't get peer credentials");
+        close(sockfd);
+        return TRUE;
+    }
+
+    if (cr.uid != 0)
+    {
+        error_msg("Refusing request from non-root process %d", cr.pid);
+        close(sockfd);
+        return TRUE;
+    }
+
+    /* The child inherits the rules */
+    event_rules_cache_fill();
+
+    fflush(NULL); /* paranoia */
+    const pid_t pid = fork();
+    if (pid < 0)
+    {
+        perror_msg("fork");
+        close(sockfd);
+        return TRUE;
+    }
+
+    if (pid == 0)
+        serve_event_request(sockfd, cr.pid);
+
+    /* The request process owns the connection. The server keeps no client
+     * sockets, hence children of other requests cannot inherit them. */
+    close(sockfd);
+    g_child_watch_add(pid, event_request_finished_cb, NULL);
+    return TRUE;
+}
+
+static void conf_changed_cb(struct abrt_inotify_watch *watch, struct inotify_event *event, gpointer user_data)
+{
+    if (event->len > 0 && strcmp(event->name, "abrt.conf") != 0)
+        return;
+
+    log_info("Reloading configuration");
+    load_abrt_conf();
+}
+
+static void event_rules_changed_cb(struct abrt_inotify_watch *watch, struct inotify_event *event, gpointer user_data)
+{
+    if (g_hash_table_size(s_event_rules) == 0)
+        return;
+
+    /* The rules are parsed again for the next request */
+    log_info("Event configuration has changed");
+    g_hash_table_remove_all(s_event_rules);
+}
+
+/* The event configuration directories need not exist */
+static struct abrt_inotify_watch *watch_event_rules_dir(const char *path)
+{
+    struct stat st;
+    if (stat(path, &st) != 0 || !S_ISDIR(st.st_mode))
+    {
+        log_notice("Not watching '%s': not a directory", path);
+        return NULL;
+    }
+
+    return abrt_inotify_watch_init(path,
+            IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_CREATE,
+            event_rules_changed_cb, /*user data*/NULL);
+}
+
+static gboolean event_server_quit_cb(gpointer user_data)
+{
+    g_main_loop_quit((GMainLoop *)user_data);
+    return FALSE;
+}
+
+static int run_event_server(void)
+{
+    unlink(ABRT_EVENT_SOCKET_FILE); /* not caring about the result */
+
+    const int socketfd = xsocket(AF_UNIX, SOCK_STREAM, 0);
+    close_on_exec_on(socketfd);
+
+    struct sockaddr_un local;
+    memset(&local, 0, sizeof(local));
+    local.sun_family = AF_UNIX;
+    strcpy(local.sun_path, ABRT_EVENT_SOCKET_FILE);
+    xbind(socketfd, (struct sockaddr*)&local, sizeof(local));
+    xlisten(socketfd, 10);
+
+    if (chmod(ABRT_EVENT_SOCKET_FILE, 0600) != 0)
+        perror_msg_and_die("chmod '%s'", ABRT_EVENT_SOCKET_FILE);
+
+    GMainLoop *main_loop = g_main_loop_new(NULL, FALSE);
+
+    GIOChannel *channel_socket = abrt_gio_channel_unix_new(socketfd);
+    g_io_channel_set_buffered(channel_socket, FALSE);
+    g_io_add_watch(channel_socket, G_IO_IN | G_IO_PRI | G_IO_HUP, event_server_socket_cb, NULL);
+
+    struct abrt_inotify_watch *conf_watch = abrt_inotify_watch_init(CONF_DIR,
+            IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE, conf_changed_cb, /*user data*/NULL);
+
+    s_event_rules = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                          NULL, (GDestroyNotify)abrt_event_rules_free);
+    event_rules_cache_fill();
+
+    /* report_event.conf includes the rules from events.d */
+    char *report_event_conf_dir = xstrdup(REPORT_EVENT_CONF);
+    *strrchr(report_event_conf_dir, '/') = '\0';
+    struct abrt_inotify_watch *report_event_conf_watch = watch_event_rules_dir(report_event_conf_dir);
+    free(report_event_conf_dir);
+    struct abrt_inotify_watch *events_watch = watch_event_rules_dir(EVENTS_DIR);
+    struct abrt_inotify_watch *events_conf_watch = watch_event_rules_dir(EVENTS_CONF_DIR);
+
+    g_unix_signal_add(SIGTERM, event_server_quit_cb, main_loop);
+    g_unix_signal_add(SIGINT, event_server_quit_cb, main_loop);
+
+    log_notice("Event server is listening on '%s'", ABRT_EVENT_SOCKET_FILE);
+    g_main_loop_run(main_loop);
+
+    unlink(ABRT_EVENT_SOCKET_FILE);
+    abrt_inotify_watch_destroy(conf_watch);
+    abrt_inotify_watch_destroy(report_event_conf_watch);
+    abrt_inotify_watch_destroy(events_watch);
+    abrt_inotify_watch_destroy(events_conf_watch);
+    g_hash_table_destroy(s_event_rules);
+    s_event_rules = NULL;
+    g_io_channel_unref(channel_socket);
+    g_main_loop_unref(main_loop);
+    free_abrt_conf_data();
+
+    return 0;
+}
+
 int main(int argc, char **argv)
 {
     /* I18n */
@@ -346,95 +812,49 @@ int main(int argc, char **argv)
     abrt_init(argv);
 
     const char *program_usage_string = _(
-        "& [-v -i -n INCREMENT] -e|--event EVENT DIR..."
+        "& [-v -i -n INCREMENT] -e|--event EVENT DIR...\n"
+        "or:\n"
+        "& [-v] --server"
         );
 
     char *event_name = NULL;
     int interactive = 0; /* must be _int_, OPT_BOOL expects that! */
     int nice_incr = 0;
+    int server = 0;
 
     struct options program_options[] = {
         OPT__VERBOSE(&g_verbose),
         OPT_STRING('e', "event" , &event_name, "EVENT",  _("Run EVENT on DIR")),
         OPT_BOOL('i', "interactive" , &interactive, _("Communicate directly to the user")),
         OPT_INTEGER('n',     "nice" , &nice_incr,   _("Increment the nice value by INCREMENT")),
+        OPT_BOOL('s', "server" , &server, _("Handle requests from abrt-server received over a socket")),
         OPT_END()
     };
 
     parse_opts(argc, argv, program_options, program_usage_string);
     argv += optind;
+    if (server)
+    {
+        if (*argv || event_name)
+            show_usage_and_die(program_usage_string, program_options);
+
+        load_abrt_conf();
+        return run_event_server();
+    }
+
     if (!*argv || !event_name)
         show_usage_and_die(program_usage_string, program_options);
 
     load_abrt_conf();
 
-    const char *const opt_env_nice = getenv("ABRT_EVENT_NICE");
-    if (opt_env_nice != NULL && opt_env_nice[0] != '\0')
-    {
-        log_debug("Using ABRT_EVENT_NICE=%s to increment the nice value", opt_env_nice);
-        nice_incr = xatoi(opt_env_nice);
-    }
-
-    if (nice_incr != 0)
-    {
-        log_debug("Incrementing the nice value by %d", nice_incr);
-        const int ret = nice(nice_incr);
-        if (ret == -1)
-            perror_msg_and_die("Failed to increment the nice value");
-    }
+    set_nice_increment(nice_incr);
 
-    bool post_create = (strcmp(event_name, "post-create") == 0);
     char *dump_dir_name = NULL;
     while (*argv)
     {
         dump_dir_name = xstrdup(*argv++);
-        int i = strlen(dump_dir_name);
-        while (--i >= 0)
-            if (dump_dir_name[i] != '/')
-                break;
-        dump_dir_name[++i] = '\0';
-
-        struct dump_dir *dd = dd_opendir(dump_dir_name, /*flags:*/ DD_OPEN_READONLY);
-        if (!dd)
-            return 1;
-
-        uid = dd_load_text_ext(dd, FILENAME_UID, DD_FAIL_QUIETLY_ENOENT);
-        dd_close(dd);
-
-        struct run_event_state *run_state = new_run_event_state();
-        if (!interactive)
-            make_run_event_state_forwarding(run_state);
-        run_state->logging_callback = do_log;
-        if (post_create)
-            run_state->post_run_callback = is_crash_a_dup;
-
-        int r = run_event_on_dir_name(run_state, dump_dir_name, event_name);
-
-        const bool no_action_for_event = (r == 0 && run_state->children_count == 0);
-
-        free_run_event_state(run_state);
-        /* Needed only if is_crash_a_dup() was called, but harmless
-         * even if it wasn't:
-         */
-        dup_uuid_fini();
-        dup_corebt_fini();
-
-        if (no_action_for_event)
-            error_msg_and_die("No actions are found for event '%s'", event_name);
-
-//TODO: consider this case:
-// new dump is created, post-create detects that it is a dup,
-// but then load_crash_info(dup_name) *FAILS*.
-// In this case, we later delete damaged dup_name (right?)
-// but new dump never gets its FILENAME_COUNT set!
 
-        /* Is crash a dup? (In this case, is_crash_a_dup() should have
-         * aborted "post-create" event processing as soon as it saw uuid
-         * and determined that there is another crash with same uuid.
-         * In this case it sets crash_dump_dup_name)
-         */
-        if (crash_dump_dup_name)
-            error_msg_and_die("DUP_OF_DIR: %s", crash_dump_dup_name);
+        int r = handle_event_on_dump_dir(event_name, dump_dir_name, interactive);
 
         /* Was there error on one of processing steps in run_event? */
         if (r != 0)
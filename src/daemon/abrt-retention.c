@@ -0,0 +1,602 @@
+/*
+    Copyright (C) 2016  RedHat inc.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include <math.h>
+#include "abrt-retention.h"
+#include "libabrt.h"
+
+/* Problem directories without the type element */
+#define UNKNOWN_CLASS "unknown"
+
+/* Problem directories grow after they were measured (reporting adds
+ * reported_to, abrt-dbus saves new elements, ...) and nothing notifies abrtd
+ * about it. The dump location is measured again before concluding that it
+ * fits into the limits if the tracked size is close to a limit or if the
+ * last measurement is too old. */
+#define REMEASURE_MARGIN 0.9
+#define REMEASURE_INTERVAL (10 * 60)
+
+struct retention_policy
+{
+    unsigned size_weight;
+    unsigned age_weight;
+    unsigned count_weight;
+    unsigned reported_weight;
+    unsigned system_weight;
+    /* type -> weight */
+    GHashTable *type_weights;
+    /* type -> quota in bytes */
+    GHashTable *type_quotas;
+};
+
+struct retention_class
+{
+    char *type;
+    /* Max-heap of struct retention_entry ordered by badness */
+    GPtrArray *heap;
+    double size;
+    double quota;
+};
+
+struct retention_entry
+{
+    char *name;
+    struct retention_class *klass;
+    guint heap_index;
+
+    double size;
+    time_t mtime;
+    unsigned long count;
+    bool reported;
+    bool system;
+
+    double badness;
+    /* The round in which the entry was verified against the disk */
+    unsigned long checked;
+};
+
+struct abrt_retention
+{
+    char *dump_location;
+    struct retention_policy policy;
+    /* type -> struct retention_class */
+    GHashTable *classes;
+    /* name -> struct retention_entry */
+    GHashTable *entries;
+    double size;
+    unsigned long round;
+    /* The time of the last scan of the dump location */
+    time_t measured;
+};
+
+/* Parses "Type:Number, Type:Number, ..." */
+static GHashTable *parse_type_values(const char *value, const char *setting, double multiplier)
+{
+    GHashTable *result = g_hash_table_new_full(g_str_hash, g_str_equal, free, free);
+    if (value == NULL)
+        return result;
+
+    GList *items = parse_list(value);
+    for (GList *iter = items; iter != NULL; iter = g_list_next(iter))
+    {
+        char *item = (char *)iter->data;
+        char *colon = strrchr(item, ':');
+        char *end = NULL;
+        unsigned long ul = 0;
+        if (colon != NULL)
+        {
+            errno = 0;
+            ul = strtoul(colon + 1, &end, 10);
+        }
+
+        if (colon == NULL || colon == item || errno || end == colon + 1 || *end != '\0')
+        {
+            error_msg("Error parsing %s setting: '%s'", setting, item);
+            continue;
+        }
+
+        double *v = xmalloc(sizeof(*v));
+        *v = ul * multiplier;
+        g_hash_table_replace(result, xstrndup(item, colon - item), v);
+    }
+    list_free_with_free(items);
+
+    return result;
+}
+
+static bool type_values_equal(GHashTable *lhs, GHashTable *rhs)
+{
+    if (g_hash_table_size(lhs) != g_hash_table_size(rhs))
+        return false;
+
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, lhs);
+    while (g_hash_table_iter_next(&iter, &key, &value))
+    {
+        double *other = g_hash_table_lookup(rhs, key);
+        if (other == NULL || *other != *(double *)value)
+            return false;
+    }
+
+    return true;
+}
+
+static void retention_policy_destroy(struct retention_policy *policy)
+{
+    if (policy->type_weights)
+        g_hash_table_destroy(policy->type_weights);
+    if (policy->type_quotas)
+        g_hash_table_destroy(policy->type_quotas);
+}
+
+/* The bigger badness the sooner the problem directory gets deleted.
+ *
+ * The age is accounted linearly (per day), so the badness of all entries
+ * grows at the same pace and the ordering of the queues remains valid.
+ * Hence the age is represented by the negative modification time.
+ */
+static double retention_entry_badness(const struct retention_policy *policy, const struct retention_entry *entry)
+{
+    double badness = 0;
+
+    const double kbytes = entry->size / 1024;
+    if (kbytes > 1)
+        badness += policy->size_weight * log2(kbytes);
+
+    badness -= policy->age_weight * ((double)entry->mtime / (24 * 60 * 60));
+
+    if (entry->count > 1)
+        badness += policy->count_weight * log2(entry->count);
+
+    if (entry->reported)
+        badness += policy->reported_weight;
+
+    if (entry->system)
+        badness -= policy->system_weight;
+
+    const double *type_weight = g_hash_table_lookup(policy->type_weights, entry->klass->type);
+    if (type_weight)
+        badness -= *type_weight;
+
+    return badness;
+}
+
+/* Binary max-heap */
+
+static void heap_swap(GPtrArray *heap, guint i, guint j)
+{
+    struct retention_entry *a = g_ptr_array_index(heap, i);
+    struct retention_entry *b = g_ptr_array_index(heap, j);
+    g_ptr_array_index(heap, i) = b;
+    g_ptr_array_index(heap, j) = a;
+    b->heap_index = i;
+    a->heap_index = j;
+}
+
+static double heap_badness(GPtrArray *heap, guint i)
+{
+    return ((struct retention_entry *)g_ptr_array_index(heap, i))->badness;
+}
+
+static void heap_sift_up(GPtrArray *heap, guint i)
+{
+    while (i > 0)
+    {
+        const guint parent = (i - 1) / 2;
+        if (heap_badness(heap, parent) >= heap_badness(heap, i))
+            break;
+
+        heap_swap(heap, parent, i);
+        i = parent;
+    }
+}
+
+static void heap_sift_down(GPtrArray *heap, guint i)
+{
+    for (;;)
+    {
+        guint largest = i;
+        const guint left = 2 * i + 1;
+        const guint right = left + 1;
+
+        if (left < heap->len && heap_badness(heap, left) > heap_badness(heap, largest))
+            largest = left;
+        if (right < heap->len && heap_badness(heap, right) > heap_badness(heap, largest))
+            largest = right;
+        if (largest == i)
+            break;
+
+        heap_swap(heap, largest, i);
+        i = largest;
+    }
+}
+
+static void heap_push(GPtrArray *heap, struct retention_entry *entry)
+{
+    entry->heap_index = heap->len;
+    g_ptr_array_add(heap, entry);
+    heap_sift_up(heap, entry->heap_index);
+}
+
+static void heap_remove(GPtrArray *heap, struct retention_entry *entry)
+{
+    const guint i = entry->heap_index;
+    const guint last = heap->len - 1;
+    if (i != last)
+        heap_swap(heap, i, last);
+    g_ptr_array_remove_index(heap, last);
+
+    if (i < heap->len)
+    {
+        heap_sift_up(heap, i);
+        heap_sift_down(heap, i);
+    }
+}
+
+/* Returns the worst entry in the heap which is not the excluded one */
+static struct retention_entry *heap_top(GPtrArray *heap, const char *excluded)
+{
+    if (heap->len == 0)
+        return NULL;
+
+    struct retention_entry *top = g_ptr_array_index(heap, 0);
+    if (excluded == NULL || strcmp(top->name, excluded) != 0)
+        return top;
+
+    /* The second worst entry is one of the root's children */
+    struct retention_entry *second = NULL;
+    for (guint i = 1; i <= 2 && i < heap->len; ++i)
+    {
+        struct retention_entry *child = g_ptr_array_index(heap, i);
+        if (second == NULL || child->badness > second->badness)
+            second = child;
+    }
+
+    return second;
+}
+
+static void retention_class_free(struct retention_class *klass)
+{
+    g_ptr_array_free(klass->heap, TRUE);
+    free(klass->type);
+    free(klass);
+}
+
+static void retention_entry_free(struct retention_entry *entry)
+{
+    free(entry->name);
+    free(entry);
+}
+
+static struct retention_class *retention_get_class(struct abrt_retention *retention, const char *type)
+{
+    struct retention_class *klass = g_hash_table_lookup(retention->classes, type);
+    if (klass != NULL)
+        return klass;
+
+    klass = xzalloc(sizeof(*klass));
+    klass->type = xstrdup(type);
+    klass->heap = g_ptr_array_new();
+
+    const double *quota = g_hash_table_lookup(retention->policy.type_quotas, type);
+    klass->quota = quota ? *quota : 0;
+
+    g_hash_table_insert(retention->classes, klass->type, klass);
+    return klass;
+}
+
+static void retention_unlink_entry(struct abrt_retention *retention, struct retention_entry *entry)
+{
+    heap_remove(entry->klass->heap, entry);
+    entry->klass->size -= entry->size;
+    retention->size -= entry->size;
+}
+
+static void retention_link_entry(struct abrt_retention *retention, struct retention_entry *entry)
+{
+    entry->badness = retention_entry_badness(&retention->policy, entry);
+    heap_push(entry->klass->heap, entry);
+    entry->klass->size += entry->size;
+    retention->size += entry->size;
+}
+
+/* Fills the entry with data from the disk. Returns false if the directory
+ * does not exist.
+ */
+static bool retention_load_entry(struct abrt_retention *retention, struct retention_entry *entry)
+{
+    char *path = concat_path_file(retention->dump_location, entry->name);
+
+    struct stat statbuf;
+    if (lstat(path, &statbuf) != 0 || !S_ISDIR(statbuf.st_mode))
+    {
+        free(path);
+        return false;
+    }
+
+    entry->size = get_dirsize(path);
+    entry->mtime = statbuf.st_mtime;
+    entry->count = 1;
+    entry->reported = false;
+    entry->system = statbuf.st_uid == 0;
+
+    char *type = NULL;
+    /* We run in the main loop of abrtd, never wait for the lock */
+    const int sv_logmode = logmode;
+    logmode = g_verbose == 0 ? 0 : sv_logmode;
+    struct dump_dir *dd = dd_opendir(path, DD_OPEN_READONLY | DD_DONT_WAIT_FOR_LOCK | DD_FAIL_QUIETLY_ENOENT | DD_FAIL_QUIETLY_EACCES);
+    logmode = sv_logmode;
+    if (dd != NULL)
+    {
+        const int flags = DD_FAIL_QUIETLY_ENOENT | DD_LOAD_TEXT_RETURN_NULL_ON_FAILURE;
+        type = dd_load_text_ext(dd, FILENAME_TYPE, flags);
+
+        char *count = dd_load_text_ext(dd, FILENAME_COUNT, flags);
+        if (count != NULL)
+        {
+            const unsigned long ul = strtoul(count, NULL, 10);
+            entry->count = ul > 0 ? ul : 1;
+            free(count);
+        }
+
+        char *uid = dd_load_text_ext(dd, FILENAME_UID, flags);
+        if (uid != NULL)
+        {
+            entry->system = strcmp(uid, "0") == 0;
+            free(uid);
+        }
+
+        entry->reported = dd_exist(dd, FILENAME_REPORTED_TO);
+        dd_close(dd);
+    }
+
+    entry->klass = retention_get_class(retention, type != NULL ? type : UNKNOWN_CLASS);
+    free(type);
+    free(path);
+
+    return true;
+}
+
+struct abrt_retention *abrt_retention_new(const char *dump_location)
+{
+    struct abrt_retention *retention = xzalloc(sizeof(*retention));
+    retention->classes = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)retention_class_free);
+    retention->entries = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)retention_entry_free);
+
+    abrt_retention_load_policy(retention);
+    abrt_retention_rescan(retention, dump_location);
+
+    return retention;
+}
+
+void abrt_retention_free(struct abrt_retention *retention)
+{
+    if (retention == NULL)
+        return;
+
+    g_hash_table_destroy(retention->entries);
+    g_hash_table_destroy(retention->classes);
+    retention_policy_destroy(&retention->policy);
+    free(retention->dump_location);
+    free(retention);
+}
+
+void abrt_retention_load_policy(struct abrt_retention *retention)
+{
+    struct retention_policy policy = {
+        .size_weight = g_settings_retention_size_weight,
+        .age_weight = g_settings_retention_age_weight,
+        .count_weight = g_settings_retention_count_weight,
+        .reported_weight = g_settings_retention_reported_weight,
+        .system_weight = g_settings_retention_system_weight,
+        .type_weights = parse_type_values(g_settings_retention_type_weights, "RetentionTypeWeights", 1),
+        .type_quotas = parse_type_values(g_settings_retention_type_quotas, "RetentionTypeQuotas", 1024 * 1024),
+    };
+
+    struct retention_policy *old = &retention->policy;
+    if (old->type_weights != NULL
+        && old->size_weight == policy.size_weight
+        && old->age_weight == policy.age_weight
+        && old->count_weight == policy.count_weight
+        && old->reported_weight == policy.reported_weight
+        && old->system_weight == policy.system_weight
+        && type_values_equal(old->type_weights, policy.type_weights)
+        && type_values_equal(old->type_quotas, policy.type_quotas))
+    {
+        retention_policy_destroy(&policy);
+        return;
+    }
+
+    log_debug("Retention policy has changed, re-ordering problem directories");
+    retention_policy_destroy(old);
+    *old = policy;
+
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, retention->classes);
+    while (g_hash_table_iter_next(&iter, &key, &value))
+    {
+        struct retention_class *klass = (struct retention_class *)value;
+        const double *quota = g_hash_table_lookup(policy.type_quotas, klass->type);
+        klass->quota = quota ? *quota : 0;
+
+        for (guint i = 0; i < klass->heap->len; ++i)
+        {
+            struct retention_entry *entry = g_ptr_array_index(klass->heap, i);
+            entry->badness = retention_entry_badness(&policy, entry);
+        }
+
+        /* Floyd's heap construction */
+        for (guint i = klass->heap->len / 2; i-- > 0; )
+            heap_sift_down(klass->heap, i);
+    }
+}
+
+void abrt_retention_rescan(struct abrt_retention *retention, const char *dump_location)
+{
+    g_hash_table_remove_all(retention->entries);
+    g_hash_table_remove_all(retention->classes);
+    retention->size = 0;
+    retention->measured = time(NULL);
+
+    /* dump_location can be retention->dump_location */
+    char *location = xstrdup(dump_location);
+    free(retention->dump_location);
+    retention->dump_location = location;
+    dump_location = location;
+
+    DIR *dp = opendir(dump_location);
+    if (dp == NULL)
+    {
+        perror_msg("Can't open directory '%s'", dump_location);
+        return;
+    }
+
+    struct dirent *dent;
+    while ((dent = readdir(dp)) != NULL)
+    {
+        if (dot_or_dotdot(dent->d_name) || strcmp(dent->d_name, ABRT_TRASH_DIR_NAME) == 0)
+            continue;
+
+        abrt_retention_update(retention, dent->d_name);
+    }
+    closedir(dp);
+
+    log_info("Retention: %u problem directories, %.0f bytes in '%s'",
+             g_hash_table_size(retention->entries), retention->size, dump_location);
+}
+
+void abrt_retention_update(struct abrt_retention *retention, const char *name)
+{
+    struct retention_entry *entry = g_hash_table_lookup(retention->entries, name);
+    const bool known = entry != NULL;
+    if (known)
+        retention_unlink_entry(retention, entry);
+    else
+    {
+        entry = xzalloc(sizeof(*entry));
+        entry->name = xstrdup(name);
+    }
+
+    if (!retention_load_entry(retention, entry))
+    {
+        if (known)
+            g_hash_table_remove(retention->entries, name);
+        else
+            retention_entry_free(entry);
+        return;
+    }
+
+    if (!known)
+        g_hash_table_insert(retention->entries, entry->name, entry);
+
+    entry->checked = retention->round;
+    retention_link_entry(retention, entry);
+}
+
+void abrt_retention_remove(struct abrt_retention *retention, const char *name)
+{
+    struct retention_entry *entry = g_hash_table_lookup(retention->entries, name);
+    if (entry == NULL)
+        return;
+
+    retention_unlink_entry(retention, entry);
+    g_hash_table_remove(retention->entries, name);
+}
+
+/* Returns the worst entry of the first class exceeding its quota, or the worst
+ * entry of all classes if the dump location exceeds max_size.
+ */
+static struct retention_entry *retention_pick(struct abrt_retention *retention, double max_size, const char *excluded)
+{
+    struct retention_entry *worst = NULL;
+    const bool over_limit = max_size > 0 && retention->size >= max_size;
+
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, retention->classes);
+    while (g_hash_table_iter_next(&iter, &key, &value))
+    {
+        struct retention_class *klass = (struct retention_class *)value;
+        struct retention_entry *top = heap_top(klass->heap, excluded);
+        if (top == NULL)
+            continue;
+
+        if (klass->quota > 0 && klass->size >= klass->quota)
+            return top;
+
+        if (over_limit && (worst == NULL || top->badness > worst->badness))
+            worst = top;
+    }
+
+    return worst;
+}
+
+static bool retention_needs_remeasure(struct abrt_retention *retention, double max_size)
+{
+    if (time(NULL) - retention->measured >= REMEASURE_INTERVAL)
+        return true;
+
+    if (max_size > 0 && retention->size >= max_size * REMEASURE_MARGIN)
+        return true;
+
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, retention->classes);
+    while (g_hash_table_iter_next(&iter, &key, &value))
+    {
+        struct retention_class *klass = (struct retention_class *)value;
+        if (klass->quota > 0 && klass->size >= klass->quota * REMEASURE_MARGIN)
+            return true;
+    }
+
+    return false;
+}
+
+char *abrt_retention_find_victim(struct abrt_retention *retention, double max_size, const char *excluded)
+{
+    /* Entries are updated only when abrtd is notified about them, so their
+     * data might be outdated (e.g. the problem was reported or its count was
+     * incremented). Verify the picked entry and pick again if it has moved.
+     */
+    ++retention->round;
+    bool remeasured = false;
+    for (;;)
+    {
+        struct retention_entry *entry = retention_pick(retention, max_size, excluded);
+        if (entry == NULL)
+        {
+            if (remeasured || !retention_needs_remeasure(retention, max_size))
+                return NULL;
+
+            /* The scan verifies all entries in this round */
+            log_debug("Retention: measuring '%s' again", retention->dump_location);
+            abrt_retention_rescan(retention, retention->dump_location);
+            remeasured = true;
+            continue;
+        }
+
+        if (entry->checked == retention->round)
+            return xstrdup(entry->name);
+
+        log_debug("Retention: verifying '%s'", entry->name);
+        char *name = xstrdup(entry->name);
+        abrt_retention_update(retention, name);
+        free(name);
+    }
+}
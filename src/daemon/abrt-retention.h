@@ -0,0 +1,68 @@
+/*
+    Copyright (C) 2016  RedHat inc.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef _ABRT_RETENTION_H_
+#define _ABRT_RETENTION_H_
+
+/* Retention engine keeps track of problem directories in the dump location
+ * and decides which of them should be deleted first when the dump location
+ * exceeds MaxCrashReportsSize or a problem type exceeds its quota.
+ *
+ * Problem directories are ordered in per-type priority queues by their
+ * "badness" computed from the weights configured in abrt.conf. The dump
+ * location is scanned once, afterwards the engine is updated incrementally.
+ * Directories can grow without abrtd noticing, so the dump location is scanned
+ * again before a victim search concludes that everything fits if the tracked
+ * size is close to a limit or the last scan is older than 10 minutes.
+ */
+struct abrt_retention;
+
+struct abrt_retention *
+abrt_retention_new(const char *dump_location);
+
+void
+abrt_retention_free(struct abrt_retention *retention);
+
+/* Re-reads the weights and quotas from the global settings and re-orders the
+ * queues if they have changed.
+ */
+void
+abrt_retention_load_policy(struct abrt_retention *retention);
+
+/* Drops all data and scans the dump location again.
+ */
+void
+abrt_retention_rescan(struct abrt_retention *retention, const char *dump_location);
+
+/* Loads or reloads data of the problem directory 'name' placed in the dump
+ * location.
+ */
+void
+abrt_retention_update(struct abrt_retention *retention, const char *name);
+
+void
+abrt_retention_remove(struct abrt_retention *retention, const char *name);
+
+/* Returns malloced base name of the problem directory which should be deleted
+ * or NULL if the dump location fits into the max_size (0 for unlimited) and
+ * all quotas. The directory 'excluded' is never returned.
+ */
+char *
+abrt_retention_find_victim(struct abrt_retention *retention, double max_size, const char *excluded);
+
+#endif /*_ABRT_RETENTION_H_*/
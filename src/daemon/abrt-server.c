@@ -15,6 +15,7 @@
   with this program; if not, write to the Free Software Foundation, Inc.,
   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 */
+#include <sys/un.h>
 #include "problem_api.h"
 #include "abrt_glib.h"
 #include "libabrt.h"
@@ -28,8 +29,6 @@
 /* We exit after this many seconds */
 #define TIMEOUT 10
 
-#define ABRT_SERVER_EVENT_ENV "ABRT_SERVER_PID"
-
 /*
 Unix socket in ABRT daemon for creating new dump directories.
 
@@ -182,10 +181,9 @@ static int delete_path(const char *dump_dir_name)
     dd = dd_fdopendir(dd, /*flags:*/ 0);
     if (dd)
     {
-        if (dd_delete(dd) != 0)
+        if (dd_trash(dd) != 0)
         {
             error_msg("Failed to delete problem directory '%s'", dump_dir_name);
-            dd_close(dd);
             return 400;
         }
     }
@@ -225,6 +223,110 @@ static pid_t spawn_event_handler_child(const char *dump_dir_name, const char *ev
     return child;
 }
 
+/* Asks the event server started by abrtd to run the event. Returns a socket
+ * streaming output of the event or -1 if the server is not available. The exit
+ * status of the event is delivered to the pipe returned in status_fd.
+ */
+static int request_event_from_server(const char *dump_dir_name, const char *event_name, int *status_fd)
+{
+    const int sockfd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sockfd < 0)
+    {
+        perror_msg("socket");
+        return -1;
+    }
+
+    struct sockaddr_un sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sun_family = AF_UNIX;
+    strcpy(sa.sun_path, ABRT_EVENT_SOCKET_FILE);
+    if (connect(sockfd, (struct sockaddr *)&sa, sizeof(sa)) != 0)
+    {
+        log_info("Event server is not available, spawning the event handler: %s", strerror(errno));
+        close(sockfd);
+        return -1;
+    }
+
+    struct strbuf *request = strbuf_new();
+    strbuf_append_strf(request, "EVENT=%s", event_name);
+    strbuf_append_char(request, '\0');
+    strbuf_append_strf(request, "DIR=%s", dump_dir_name);
+    strbuf_append_char(request, '\0');
+    strbuf_append_str(request, "NICE=10");
+    strbuf_append_char(request, '\0');
+    strbuf_append_char(request, '\0');
+
+    int status_pipe[2];
+    xpipe(status_pipe);
+    close_on_exec_on(status_pipe[0]);
+    close_on_exec_on(status_pipe[1]);
+
+    /* The write end of the pipe is passed along with the request */
+    char control[CMSG_SPACE(sizeof(int))];
+    memset(control, 0, sizeof(control));
+    struct iovec iov = { .iov_base = request->buf, .iov_len = request->len };
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &status_pipe[1], sizeof(int));
+
+    ssize_t wrote;
+    do
+        wrote = sendmsg(sockfd, &msg, MSG_NOSIGNAL);
+    while (wrote < 0 && errno == EINTR);
+
+    const bool failed = wrote < 0 || (size_t)wrote != request->len;
+    strbuf_free(request);
+    close(status_pipe[1]);
+    if (failed)
+    {
+        perror_msg("Can't send request to the event server");
+        close(status_pipe[0]);
+        close(sockfd);
+        return -1;
+    }
+
+    shutdown(sockfd, SHUT_WR);
+    *status_fd = status_pipe[0];
+    return sockfd;
+}
+
+/* Reads the exit status of an event run by the event server */
+static int read_event_server_status(int status_fd)
+{
+    int status;
+    if (full_read(status_fd, &status, sizeof(status)) != sizeof(status))
+    {
+        error_msg("Event server did not send exit status");
+        /* Pretend the handler was killed */
+        status = SIGKILL;
+    }
+
+    close(status_fd);
+    return status;
+}
+
+/* Runs the event either via the event server or in a new abrt-handle-event
+ * process. Returns PID of the spawned process or 0 if the event is run by the
+ * server. In the latter case, status_fd is the pipe of the exit status.
+ */
+static pid_t run_event_handler(const char *dump_dir_name, const char *event_name, int *fdp, int *status_fd)
+{
+    *fdp = request_event_from_server(dump_dir_name, event_name, status_fd);
+    if (*fdp >= 0)
+        return 0;
+
+    return spawn_event_handler_child(dump_dir_name, event_name, fdp);
+}
+
 static int problem_dump_dir_was_provoked_by_abrt_event(struct dump_dir *dd, char  **provoker)
 {
     char *env_var = NULL;
@@ -300,7 +402,7 @@ static int run_post_create(const char *dirname, struct response *resp)
             if (g_settings_debug_level == 0)
             {
                 error_msg("Removing problem provoked by ABRT(pid:%s): '%s'", provoker, dirname);
-                dd_delete(dd);
+                dd_trash(dd);
             }
             else
             {
@@ -379,7 +481,9 @@ static int run_post_create(const char *dirname, struct response *resp)
      */
 
     int child_stdout_fd;
-    int child_pid = spawn_event_handler_child(dirname, "post-create", &child_stdout_fd);
+    /* The pipe of the exit status reported by the event server */
+    int server_status_fd = -1;
+    int child_pid = run_event_handler(dirname, "post-create", &child_stdout_fd, &server_status_fd);
 
     char *dup_of_dir = NULL;
     struct strbuf *cmd_output = strbuf_new();
@@ -430,7 +534,12 @@ static int run_post_create(const char *dirname, struct response *resp)
 
     /* Wait for child to actually exit, collect status */
     int status = 0;
-    if (safe_waitpid(child_pid, &status, 0) <= 0)
+    if (child_pid == 0)
+    {
+        status = read_event_server_status(server_status_fd);
+        server_status_fd = -1;
+    }
+    else if (safe_waitpid(child_pid, &status, 0) <= 0)
     /* should not happen */
         perror_msg("waitpid(%d)", child_pid);
 
@@ -527,15 +636,16 @@ static int run_post_create(const char *dirname, struct response *resp)
         log_warning("Deleting problem directory %s (dup of %s)",
                     strrchr(dirname, '/') + 1,
                     strrchr(dup_of_dir, '/') + 1);
-        delete_dump_dir(dirname);
+        trash_dump_dir(dirname);
     }
 
     /* Run "notify[-dup]" event */
     int fd;
-    child_pid = spawn_event_handler_child(
+    child_pid = run_event_handler(
                 work_dir,
                 (dup_of_dir ? "notify-dup" : "notify"),
-                &fd
+                &fd,
+                &server_status_fd
     );
     //log("Started notify, fd %d -> %d", fd, child_stdout_fd);
     xmove_fd(fd, child_stdout_fd);
@@ -553,7 +663,7 @@ static int run_post_create(const char *dirname, struct response *resp)
 
  delete_bad_dir:
     log_warning("Deleting problem directory '%s'", dirname);
-    delete_dump_dir(dirname);
+    trash_dump_dir(dirname);
     /* TODO - better code to allow detection on client's side */
     RESPONSE_SETTER(resp, 403, NULL);
 
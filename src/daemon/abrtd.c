@@ -24,6 +24,7 @@
 
 #include "abrt_glib.h"
 #include "abrt-inotify.h"
+#include "abrt-retention.h"
 #include "libabrt.h"
 #include "problem_api.h"
 
@@ -42,7 +43,9 @@
 /* Maximum number of simultaneously opened client connections. */
 #define MAX_CLIENT_COUNT  10
 
-#define IN_DUMP_LOCATION_FLAGS (IN_DELETE_SELF | IN_MOVE_SELF)
+/* IN_DELETE and IN_MOVED_FROM keep the retention engine in sync with problem
+ * directories removed by other tools */
+#define IN_DUMP_LOCATION_FLAGS (IN_DELETE_SELF | IN_MOVE_SELF | IN_DELETE | IN_MOVED_FROM | IN_ONLYDIR)
 
 #define ABRTD_DBUS_NAME ABRT_DBUS_NAME".daemon"
 
@@ -66,6 +69,22 @@ static GIOChannel *channel_socket = NULL;
 static guint channel_id_socket = 0;
 static int child_count = 0;
 
+/* PID of the process emptying the trash in the dump location */
+static pid_t s_trash_cleaner_pid = 0;
+/* Something was trashed while the cleaner was running */
+static bool s_trash_cleaner_rerun = false;
+
+/* PID of the event server ('abrt-handle-event --server') */
+static pid_t s_event_server_pid = 0;
+/* Start time of the event server, used to detect a crash loop */
+static time_t s_event_server_started = 0;
+/* Don't restart the event server if it died sooner than after this many seconds */
+#define EVENT_SERVER_MIN_LIFETIME 5
+
+/* Decides which problem directories are deleted when the dump location is
+ * over MaxCrashReportsSize or the per-type quotas */
+static struct abrt_retention *s_retention;
+
 struct abrt_server_proc
 {
     pid_t pid;
@@ -124,11 +143,75 @@ static void dispose_abrt_server(struct abrt_server_proc *proc)
         g_io_channel_unref(proc->channel);
 }
 
+/* Starts the background trash cleaner unless it is already running */
+static void empty_trash_in_background(void)
+{
+    if (s_trash_cleaner_pid > 0)
+    {
+        s_trash_cleaner_rerun = true;
+        return;
+    }
+
+    s_trash_cleaner_rerun = false;
+    if (!trash_has_items(g_settings_dump_location))
+        return;
+
+    const pid_t pid = spawn_trash_cleaner(g_settings_dump_location);
+    if (pid > 0)
+        s_trash_cleaner_pid = pid;
+}
+
+/* abrt-server falls back to spawning abrt-handle-event if the event server is
+ * not running */
+static void start_event_server(void)
+{
+    fflush(NULL); /* paranoia */
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        perror_msg("fork");
+        return;
+    }
+
+    if (pid == 0)
+    {
+        execl(LIBEXEC_DIR"/abrt-handle-event", "abrt-handle-event", "--server", (char *)NULL);
+        perror_msg_and_die("Can't execute '%s'", LIBEXEC_DIR"/abrt-handle-event");
+    }
+
+    log_debug("Started event server (%d)", pid);
+    s_event_server_pid = pid;
+    s_event_server_started = time(NULL);
+}
+
+static void stop_event_server(void)
+{
+    if (s_event_server_pid <= 0)
+        return;
+
+    kill(s_event_server_pid, SIGTERM);
+    s_event_server_pid = 0;
+}
+
+/* Loads the current data of the problem directory to the retention engine */
+static void retention_update_dir(const char *dirname)
+{
+    const char *name = strrchr(dirname, '/');
+    abrt_retention_update(s_retention, name != NULL ? name + 1 : dirname);
+}
+
 static void notify_next_post_create_process(struct abrt_server_proc *finished)
 {
     if (finished != NULL)
+    {
         s_dir_queue = g_list_remove(s_dir_queue, finished);
 
+        /* post-create scripts add core, backtrace, etc. or the directory was
+         * removed as a duplicate */
+        if (finished->dirname != NULL)
+            retention_update_dir(finished->dirname);
+    }
+
     while (s_dir_queue != NULL)
     {
         struct abrt_server_proc *n = (struct abrt_server_proc *)s_dir_queue->data;
@@ -160,8 +243,6 @@ static void queue_post_craete_process(struct abrt_server_proc *proc)
     load_abrt_conf();
     struct abrt_server_proc *running = s_dir_queue == NULL ? NULL
                                                            : (struct abrt_server_proc *)s_dir_queue->data;
-    if (g_settings_nMaxCrashReportsSize == 0)
-        goto consider_processing;
 
     const char *full_path_ignored = running != NULL ? running->dirname
                                                     : proc->dirname;
@@ -173,21 +254,26 @@ static void queue_post_craete_process(struct abrt_server_proc *proc)
         /* Move behind '/' */
         ++ignored;
 
+    abrt_retention_load_policy(s_retention);
+    retention_update_dir(proc->dirname);
+
+    GList *undeleted = NULL;
     char *worst_dir = NULL;
-    const double max_size = 1024 * 1024 * g_settings_nMaxCrashReportsSize;
-    while (get_dirsize_find_largest_dir(g_settings_dump_location, &worst_dir, ignored) >= max_size
-           && worst_dir)
+    const double max_size = 1024 * 1024 * (double)g_settings_nMaxCrashReportsSize;
+    bool trashed = false;
+    while ((worst_dir = abrt_retention_find_victim(s_retention, max_size, ignored)) != NULL)
     {
         const char *kind = "old";
+        char *deleted = concat_path_file(g_settings_dump_location, worst_dir);
 
         GList *proc_of_deleted_item = NULL;
-        if (proc != NULL && strcmp(worst_dir, proc->dirname) == 0)
+        if (proc != NULL && strcmp(deleted, proc->dirname) == 0)
         {
             kind = "new";
             stop_abrt_server(proc);
             proc = NULL;
         }
-        else if ((proc_of_deleted_item = g_list_find_custom(s_dir_queue, worst_dir, (GCompareFunc)abrt_server_compare_dirname)))
+        else if ((proc_of_deleted_item = g_list_find_custom(s_dir_queue, deleted, (GCompareFunc)abrt_server_compare_dirname)))
         {
             kind = "unprocessed";
             struct abrt_server_proc *removed_proc = (struct abrt_server_proc *)proc_of_deleted_item->data;
@@ -195,22 +281,35 @@ static void queue_post_craete_process(struct abrt_server_proc *proc)
             stop_abrt_server(removed_proc);
         }
 
-        log("Size of '%s' >= %u MB (MaxCrashReportsSize), deleting %s directory '%s'",
+        log("Size of '%s' >= %u MB (MaxCrashReportsSize) or quota exceeded, deleting %s directory '%s'",
                 g_settings_dump_location, g_settings_nMaxCrashReportsSize,
                 kind, worst_dir);
 
-        char *deleted = concat_path_file(g_settings_dump_location, worst_dir);
-        free(worst_dir);
-        worst_dir = NULL;
-
+        bool removed = false;
         struct dump_dir *dd = dd_opendir(deleted, DD_FAIL_QUIETLY_ENOENT);
         if (dd != NULL)
-            dd_delete(dd);
-
+            removed = dd_trash(dd) == 0;
+        trashed |= removed;
+
+        /* Forget the directory for the rest of this clean up even if we failed
+         * to delete it, otherwise we would try to delete it again and again. */
+        abrt_retention_remove(s_retention, worst_dir);
+        if (removed)
+            free(worst_dir);
+        else
+            undeleted = g_list_prepend(undeleted, worst_dir);
         free(deleted);
     }
 
-consider_processing:
+    /* The directories which we failed to delete still occupy the dump
+     * location, the next clean up will try to delete them again. */
+    for (GList *iter = undeleted; iter != NULL; iter = g_list_next(iter))
+        abrt_retention_update(s_retention, (const char *)iter->data);
+    list_free_with_free(undeleted);
+
+    if (trashed)
+        empty_trash_in_background();
+
     /* If the process survived cleaning up the dump location, append it to the
      * post-create queue.
      */
@@ -347,6 +446,28 @@ static gboolean server_socket_cb(GIOChannel *source, GIOCondition condition, gpo
 
 static void remove_abrt_server_proc(pid_t pid, int status)
 {
+    if (pid == s_event_server_pid)
+    {
+        s_event_server_pid = 0;
+        if (time(NULL) - s_event_server_started < EVENT_SERVER_MIN_LIFETIME)
+        {
+            error_msg("Event server (%d) died too early, not restarting it", pid);
+            return;
+        }
+
+        log_warning("Event server (%d) died, restarting it", pid);
+        start_event_server();
+        return;
+    }
+
+    if (pid == s_trash_cleaner_pid)
+    {
+        s_trash_cleaner_pid = 0;
+        if (s_trash_cleaner_rerun)
+            empty_trash_in_background();
+        return;
+    }
+
     GList *item = g_list_find_custom(s_processes, &pid, (GCompareFunc)abrt_server_compare_pid);
     if (item == NULL)
         return;
@@ -367,6 +488,9 @@ static void remove_abrt_server_proc(pid_t pid, int status)
     dispose_abrt_server(proc);
     free(proc);
 
+    /* abrt-server moves deleted and duplicate dump directories to trash */
+    empty_trash_in_background();
+
     if (g_list_length(s_processes) < MAX_CLIENT_COUNT && !channel_id_socket)
     {
         log_info("Accepting connections on '%s'", SOCKET_FILE);
@@ -493,6 +617,13 @@ static void handle_inotify_cb(struct abrt_inotify_watch *watch, struct inotify_e
 
         sanitize_dump_dir_rights();
         abrt_inotify_watch_reset(watch, g_settings_dump_location, IN_DUMP_LOCATION_FLAGS);
+        abrt_retention_rescan(s_retention, g_settings_dump_location);
+    }
+    else if ((event->mask & IN_ISDIR) && event->len > 0
+             && (event->mask & IN_DELETE || event->mask & IN_MOVED_FROM))
+    {
+        log_debug("Problem directory '%s' disappeared", event->name);
+        abrt_retention_remove(s_retention, event->name);
     }
 
     start_idle_timeout();
@@ -645,6 +776,9 @@ static void mark_unprocessed_dump_dirs_not_reportable(const char *path)
         if (dot_or_dotdot(dent->d_name))
             continue; /* skip "." and ".." */
 
+        if (strcmp(dent->d_name, ABRT_TRASH_DIR_NAME) == 0)
+            continue; /* dump directories waiting for removal */
+
         char *full_name = concat_path_file(path, dent->d_name);
 
         struct stat stat_buf;
@@ -788,6 +922,7 @@ int main(int argc, char** argv)
      */
     sanitize_dump_dir_rights();
     mark_unprocessed_dump_dirs_not_reportable(g_settings_dump_location);
+    s_retention = abrt_retention_new(g_settings_dump_location);
 
     /* Daemonize unless -d */
     if (!(opts & OPT_d))
@@ -852,6 +987,9 @@ int main(int argc, char** argv)
     /* Open socket to receive new problem data (from python etc). */
     dumpsocket_init();
 
+    /* Keep a process with loaded event rules for abrt-server */
+    start_event_server();
+
     /* Inform parent that we initialized ok */
     if (!(opts & OPT_d))
     {
@@ -873,6 +1011,9 @@ int main(int argc, char** argv)
                              on_name_lost,
                              NULL, NULL);
 
+    /* Finish removal of dump directories trashed before we were stopped */
+    empty_trash_in_background();
+
     start_idle_timeout();
 
     /* Enter the event loop */
@@ -900,6 +1041,7 @@ int main(int argc, char** argv)
      * Take care to not undo things we did not do.
      */
     dumpsocket_shutdown();
+    stop_event_server();
     if (pidfile_created)
         unlink(VAR_RUN_PIDFILE);
 
@@ -910,6 +1052,8 @@ int main(int argc, char** argv)
 
     abrt_inotify_watch_destroy(aiw);
 
+    abrt_retention_free(s_retention);
+
     if (s_main_loop)
         g_main_loop_unref(s_main_loop);
 
@@ -13,6 +13,8 @@
 #include "abrt_problems2_entry.h"
 #include "abrt_problems2_service.h"
 
+/* Owners of problem directories registered by the previous instance */
+#define ABRT_DBUS_ENTRIES_SNAPSHOT VAR_RUN"/abrt/abrt-dbus-entries"
 
 static GMainLoop *loop;
 static guint g_timeout_source;
@@ -328,7 +330,8 @@ static int add_dirname_to_GList_if_matches(struct dump_dir *dd, void *arg)
     return 0;
 }
 
-static GList *get_problem_dirs_for_element_in_time(uid_t uid,
+static GList *get_problem_dirs_for_element_in_time(AbrtP2Service *service,
+                uid_t uid,
                 const char *element,
                 const char *value,
                 unsigned long timestamp_from,
@@ -337,6 +340,12 @@ static GList *get_problem_dirs_for_element_in_time(uid_t uid,
     if (timestamp_to == 0) /* not sure this is possible, but... */
         timestamp_to = time(NULL);
 
+    /* The common elements are looked up in the index of Problems2 entries */
+    GList *dirs = NULL;
+    if (abrt_p2_service_find_problems_by_element(service, uid, element, value,
+                timestamp_from, timestamp_to, &dirs) == 0)
+        return dirs;
+
     struct field_and_time_range me = {
         .list = NULL,
         .element = element,
@@ -642,7 +651,7 @@ static void handle_method_call(GDBusConnection *connection,
         const double requested_size = (double)strlen(value) - item_size;
         /* Don't want to check the size limit in case of reducing of size */
         if (requested_size > 0
-            && requested_size > (max_dir_size - get_dirsize(g_settings_dump_location)))
+            && requested_size > (max_dir_size - dump_location_size_find_largest_dir(g_settings_dump_location, NULL, NULL)))
         {
             log_notice("No problem space left in '%s' (requested Bytes %f)", problem_id, requested_size);
             g_dbus_method_invocation_return_dbus_error(invocation,
@@ -783,8 +792,8 @@ static void handle_method_call(GDBusConnection *connection,
         if (all && polkit_check_authorization_dname(caller, "org.freedesktop.problems.getall") == PolkitYes)
             caller_uid = 0;
 
-        GList *dirs = get_problem_dirs_for_element_in_time(caller_uid, element, value, timestamp_from,
-                                                        timestamp_to);
+        GList *dirs = get_problem_dirs_for_element_in_time(ABRT_P2_SERVICE(user_data), caller_uid,
+                                                        element, value, timestamp_from, timestamp_to);
         response = variant_from_string_list(dirs);
         list_free_with_free(dirs);
 
@@ -826,6 +835,24 @@ static void handle_abrtd_problem_signals(GDBusConnection *connection,
         return;
     }
 
+    /* A repeated crash can be merged into a problem waiting for removal */
+    if (obj == NULL)
+    {
+        obj = abrt_p2_service_restore_problem(service, dir, &error);
+        if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_PENDING))
+        {
+            log_debug("Notifying '%s' after its removal: %s", dir, error->message);
+            g_error_free(error);
+            return;
+        }
+        if (error)
+        {
+            log_warning("Cannot notify '%s': %s", dir, error->message);
+            g_error_free(error);
+            return;
+        }
+    }
+
     if (obj == NULL)
     {
         AbrtP2Entry *entry = abrt_p2_entry_new_with_state(xstrdup(dir), ABRT_P2_ENTRY_STATE_COMPLETE);
@@ -1077,6 +1104,7 @@ int main(int argc, char *argv[])
     abrt_p2_service_set_max_message_unix_fds(p2_service, max_message_unix_fds);
 
     configure_problems2_service(p2_service);
+    abrt_p2_service_set_entries_snapshot(p2_service, ABRT_DBUS_ENTRIES_SNAPSHOT);
 
     owner_id = g_bus_own_name(G_BUS_TYPE_SYSTEM,
                              ABRT_DBUS_NAME,
@@ -1095,6 +1123,9 @@ int main(int argc, char *argv[])
 
     log_notice("Cleaning up");
 
+    /* The service is freed when the name is released */
+    abrt_p2_service_save_entries_snapshot(p2_service);
+
     g_bus_unown_name(owner_id);
 
     g_dbus_node_info_unref(introspection_data);
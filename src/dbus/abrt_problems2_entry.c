@@ -21,11 +21,31 @@
 
 #include <dbus/dbus.h>
 #include <gio/gunixfdlist.h>
+#include <sys/sendfile.h>
+
+/* A size of the kernel pipe buffer */
+#define ELEMENT_COPY_CHUNK_SIZE (64 * 1024)
 
 typedef struct
 {
     char *p2e_dirname;
     AbrtP2EntryState p2e_state;
+
+    /* Metadata are replaced as a whole when the directory is modified. The
+     * service refreshes metadata of watched entries, the other entries check
+     * the modification time of the directory. */
+    AbrtP2EntryMetadata *p2e_metadata;
+    struct timespec p2e_metadata_mtime;
+    bool p2e_metadata_trusted;
+    /* The service has modified the directory */
+    bool p2e_metadata_stale;
+    /* Metadata replaced by a read before abrt_p2_entry_reload_metadata()
+     * reported the changed properties */
+    AbrtP2EntryMetadata *p2e_metadata_unreported;
+    int p2e_watch;
+
+    uid_t p2e_registered_owner;
+    struct timespec p2e_registered_ctime;
 } AbrtP2EntryPrivate;
 
 struct _AbrtP2Entry
@@ -36,10 +56,14 @@ struct _AbrtP2Entry
 
 G_DEFINE_TYPE_WITH_PRIVATE(AbrtP2Entry, abrt_p2_entry, G_TYPE_OBJECT)
 
+static void abrt_p2_entry_metadata_free(AbrtP2EntryMetadata *md);
+
 static void abrt_p2_entry_finalize(GObject *gobject)
 {
     AbrtP2EntryPrivate *pv = abrt_p2_entry_get_instance_private(ABRT_P2_ENTRY(gobject));
     free(pv->p2e_dirname);
+    abrt_p2_entry_metadata_free(pv->p2e_metadata);
+    abrt_p2_entry_metadata_free(pv->p2e_metadata_unreported);
 }
 
 static void abrt_p2_entry_class_init(AbrtP2EntryClass *klass)
@@ -51,6 +75,8 @@ static void abrt_p2_entry_class_init(AbrtP2EntryClass *klass)
 static void abrt_p2_entry_init(AbrtP2Entry *self)
 {
     self->pv = abrt_p2_entry_get_instance_private(self);
+    self->pv->p2e_watch = -1;
+    self->pv->p2e_registered_owner = (uid_t)-1;
 }
 
 AbrtP2Entry *abrt_p2_entry_new(char *dirname)
@@ -83,6 +109,321 @@ const char *abrt_p2_entry_problem_id(AbrtP2Entry *entry)
     return entry->pv->p2e_dirname;
 }
 
+int abrt_p2_entry_watch(AbrtP2Entry *entry)
+{
+    return entry->pv->p2e_watch;
+}
+
+void abrt_p2_entry_set_watch(AbrtP2Entry *entry, int watch)
+{
+    entry->pv->p2e_watch = watch;
+}
+
+uid_t abrt_p2_entry_registered_owner(AbrtP2Entry *entry,
+            struct timespec *ctime)
+{
+    if (ctime != NULL)
+        *ctime = entry->pv->p2e_registered_ctime;
+
+    return entry->pv->p2e_registered_owner;
+}
+
+void abrt_p2_entry_set_registered_owner(AbrtP2Entry *entry,
+            uid_t owner,
+            const struct timespec *ctime)
+{
+    entry->pv->p2e_registered_owner = owner;
+    entry->pv->p2e_registered_ctime = *ctime;
+}
+
+/*
+ * Metadata
+ */
+enum metadata_property_type
+{
+    METADATA_TEXT,
+    METADATA_UINT32,
+    METADATA_TIME,
+    METADATA_BOOLEAN,
+};
+
+static const struct metadata_property
+{
+    const char *name;
+    const char *element;
+    enum metadata_property_type type;
+    size_t offset;
+} s_metadata_properties[] = {
+    { "User",                 FILENAME_USERNAME,        METADATA_TEXT,    offsetof(AbrtP2EntryMetadata, user)             },
+    { "Hostname",             FILENAME_HOSTNAME,        METADATA_TEXT,    offsetof(AbrtP2EntryMetadata, hostname)         },
+    { "Type",                 FILENAME_TYPE,            METADATA_TEXT,    offsetof(AbrtP2EntryMetadata, type)             },
+    { "Executable",           FILENAME_EXECUTABLE,      METADATA_TEXT,    offsetof(AbrtP2EntryMetadata, executable)       },
+    { "CommandLineArguments", FILENAME_CMDLINE,         METADATA_TEXT,    offsetof(AbrtP2EntryMetadata, cmdline)          },
+    { "Component",            FILENAME_COMPONENT,       METADATA_TEXT,    offsetof(AbrtP2EntryMetadata, component)        },
+    { "UUID",                 FILENAME_UUID,            METADATA_TEXT,    offsetof(AbrtP2EntryMetadata, uuid)             },
+    { "Duphash",              FILENAME_DUPHASH,         METADATA_TEXT,    offsetof(AbrtP2EntryMetadata, duphash)          },
+    { "Reason",               FILENAME_REASON,          METADATA_TEXT,    offsetof(AbrtP2EntryMetadata, reason)           },
+    { "TechnicalDetails",     FILENAME_NOT_REPORTABLE,  METADATA_TEXT,    offsetof(AbrtP2EntryMetadata, not_reportable)   },
+    { "UID",                  FILENAME_UID,             METADATA_UINT32,  offsetof(AbrtP2EntryMetadata, uid)              },
+    { "Count",                FILENAME_COUNT,           METADATA_UINT32,  offsetof(AbrtP2EntryMetadata, count)            },
+    { "FirstOccurrence",      FILENAME_TIME,            METADATA_TIME,    offsetof(AbrtP2EntryMetadata, first_occurrence) },
+    { "LastOccurrence",       FILENAME_LAST_OCCURRENCE, METADATA_TIME,    offsetof(AbrtP2EntryMetadata, last_occurrence)  },
+    { "IsReported",           FILENAME_REPORTED_TO,     METADATA_BOOLEAN, offsetof(AbrtP2EntryMetadata, reported)         },
+    { "CanBeReported",        FILENAME_NOT_REPORTABLE,  METADATA_BOOLEAN, offsetof(AbrtP2EntryMetadata, can_be_reported)  },
+    { "IsRemote",             FILENAME_REMOTE,          METADATA_BOOLEAN, offsetof(AbrtP2EntryMetadata, remote)           },
+};
+
+#define METADATA_FIELD(md, property, type) \
+        (*(type *)((char *)(md) + (property)->offset))
+
+static const struct metadata_property *metadata_property_lookup(const char *property_name)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(s_metadata_properties); ++i)
+        if (strcmp(s_metadata_properties[i].name, property_name) == 0)
+            return &s_metadata_properties[i];
+
+    return NULL;
+}
+
+static void abrt_p2_entry_metadata_free(AbrtP2EntryMetadata *md)
+{
+    if (md == NULL)
+        return;
+
+    for (size_t i = 0; i < ARRAY_SIZE(s_metadata_properties); ++i)
+        if (s_metadata_properties[i].type == METADATA_TEXT)
+            free(METADATA_FIELD(md, &s_metadata_properties[i], char *));
+
+    free(md);
+}
+
+static AbrtP2EntryMetadata *abrt_p2_entry_metadata_load(AbrtP2Entry *entry)
+{
+    AbrtP2EntryPrivate *pv = entry->pv;
+
+    /* Take the time stamp before reading, so a concurrent modification
+     * causes another reload */
+    struct stat st;
+    if (stat(pv->p2e_dirname, &st) != 0)
+    {
+        log_debug("Can't stat '%s': %s", pv->p2e_dirname, strerror(errno));
+        return NULL;
+    }
+
+    struct dump_dir *dd = dd_opendir(pv->p2e_dirname, DD_OPEN_READONLY
+                                                      | DD_DONT_WAIT_FOR_LOCK
+                                                      | DD_FAIL_QUIETLY_ENOENT
+                                                      | DD_FAIL_QUIETLY_EACCES);
+    if (dd == NULL)
+    {
+        log_debug("Can't load metadata of '%s'", pv->p2e_dirname);
+        return NULL;
+    }
+
+    log_debug("Loading metadata of '%s'", pv->p2e_dirname);
+
+    AbrtP2EntryMetadata *md = xzalloc(sizeof(*md));
+    for (size_t i = 0; i < ARRAY_SIZE(s_metadata_properties); ++i)
+    {
+        const struct metadata_property *prop = &s_metadata_properties[i];
+        if (prop->type == METADATA_TEXT)
+            METADATA_FIELD(md, prop, char *) = dd_load_text_ext(dd, prop->element,
+                                                                  DD_FAIL_QUIETLY_ENOENT
+                                                                  | DD_LOAD_TEXT_RETURN_NULL_ON_FAILURE);
+    }
+
+    md->count = 1;
+    dd_load_uint32(dd, FILENAME_UID, &md->uid);
+    dd_load_uint32(dd, FILENAME_COUNT, &md->count);
+    md->first_occurrence = dd_get_first_occurrence(dd);
+    md->last_occurrence = dd_get_last_occurrence(dd);
+    md->reported = dd_exist(dd, FILENAME_REPORTED_TO);
+    md->can_be_reported = !dd_exist(dd, FILENAME_NOT_REPORTABLE);
+    md->remote = dd_exist(dd, FILENAME_REMOTE);
+    dd_close(dd);
+
+    /* A modification made in the same second might not change the time
+     * stamp on file systems with coarse time stamps, so such metadata are
+     * not trusted next time */
+    pv->p2e_metadata_mtime = st.st_mtim;
+    pv->p2e_metadata_trusted = st.st_mtim.tv_sec < time(NULL);
+
+    return md;
+}
+
+static void abrt_p2_entry_metadata_diff(const AbrtP2EntryMetadata *old,
+            const AbrtP2EntryMetadata *new,
+            GPtrArray *changed)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(s_metadata_properties); ++i)
+    {
+        const struct metadata_property *prop = &s_metadata_properties[i];
+        bool differ = false;
+        switch (prop->type)
+        {
+            case METADATA_TEXT:
+                differ = g_strcmp0(METADATA_FIELD(old, prop, char *),
+                                   METADATA_FIELD(new, prop, char *)) != 0;
+                break;
+            case METADATA_UINT32:
+                differ = METADATA_FIELD(old, prop, uint32_t) != METADATA_FIELD(new, prop, uint32_t);
+                break;
+            case METADATA_TIME:
+                differ = METADATA_FIELD(old, prop, time_t) != METADATA_FIELD(new, prop, time_t);
+                break;
+            case METADATA_BOOLEAN:
+                differ = METADATA_FIELD(old, prop, bool) != METADATA_FIELD(new, prop, bool);
+                break;
+        }
+
+        if (differ)
+            g_ptr_array_add(changed, (gpointer)prop->name);
+    }
+}
+
+GPtrArray *abrt_p2_entry_reload_metadata(AbrtP2Entry *entry)
+{
+    AbrtP2EntryPrivate *pv = entry->pv;
+
+    AbrtP2EntryMetadata *md = abrt_p2_entry_metadata_load(entry);
+    if (md == NULL)
+        return NULL;
+
+    GPtrArray *changed = g_ptr_array_new();
+
+    /* Changes seen by a read in the meantime have not been reported yet */
+    AbrtP2EntryMetadata *old = pv->p2e_metadata_unreported != NULL
+                               ? pv->p2e_metadata_unreported
+                               : pv->p2e_metadata;
+    if (old != NULL)
+        abrt_p2_entry_metadata_diff(old, md, changed);
+
+    abrt_p2_entry_metadata_free(pv->p2e_metadata_unreported);
+    abrt_p2_entry_metadata_free(pv->p2e_metadata);
+    pv->p2e_metadata_unreported = NULL;
+    pv->p2e_metadata = md;
+    pv->p2e_metadata_stale = false;
+
+    return changed;
+}
+
+void abrt_p2_entry_invalidate_metadata(AbrtP2Entry *entry)
+{
+    entry->pv->p2e_metadata_stale = true;
+}
+
+bool abrt_p2_entry_metadata_loaded(AbrtP2Entry *entry)
+{
+    return entry->pv->p2e_metadata != NULL;
+}
+
+const AbrtP2EntryMetadata *abrt_p2_entry_metadata(AbrtP2Entry *entry)
+{
+    AbrtP2EntryPrivate *pv = entry->pv;
+
+    if (pv->p2e_metadata != NULL && !pv->p2e_metadata_stale)
+    {
+        if (pv->p2e_watch >= 0)
+            return pv->p2e_metadata;
+
+        struct stat st;
+        if (pv->p2e_metadata_trusted
+            && stat(pv->p2e_dirname, &st) == 0
+            && pv->p2e_metadata_mtime.tv_sec == st.st_mtim.tv_sec
+            && pv->p2e_metadata_mtime.tv_nsec == st.st_mtim.tv_nsec)
+        {
+            return pv->p2e_metadata;
+        }
+    }
+
+    AbrtP2EntryMetadata *md = abrt_p2_entry_metadata_load(entry);
+    if (md == NULL)
+        return NULL;
+
+    /* The changes are reported by the next abrt_p2_entry_reload_metadata() */
+    if (pv->p2e_metadata_unreported == NULL)
+        pv->p2e_metadata_unreported = pv->p2e_metadata;
+    else
+        abrt_p2_entry_metadata_free(pv->p2e_metadata);
+
+    pv->p2e_metadata = md;
+    pv->p2e_metadata_stale = false;
+    return md;
+}
+
+const AbrtP2EntryMetadata *abrt_p2_entry_metadata_for_uid(AbrtP2Entry *entry,
+            uid_t caller_uid,
+            GError **error)
+{
+    if (0 != abrt_p2_entry_accessible_by_uid(entry, caller_uid, NULL))
+    {
+        g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_ACCESS_DENIED,
+                    "You are not authorized to access the problem");
+
+        return NULL;
+    }
+
+    const AbrtP2EntryMetadata *md = abrt_p2_entry_metadata(entry);
+    if (md == NULL)
+        g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_IO_ERROR,
+                    "Failed to load problem data");
+
+    return md;
+}
+
+bool abrt_p2_entry_metadata_has_property(const char *property_name)
+{
+    return metadata_property_lookup(property_name) != NULL;
+}
+
+bool abrt_p2_entry_metadata_has_element(const char *element_name)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(s_metadata_properties); ++i)
+        if (strcmp(s_metadata_properties[i].element, element_name) == 0)
+            return true;
+
+    return false;
+}
+
+GVariant *abrt_p2_entry_metadata_property_value(const AbrtP2EntryMetadata *md,
+            const char *property_name,
+            GError **error)
+{
+    const struct metadata_property *prop = metadata_property_lookup(property_name);
+    if (prop == NULL)
+    {
+        g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_PROPERTY,
+                    "Property '%s' is not cached", property_name);
+        return NULL;
+    }
+
+    switch (prop->type)
+    {
+        case METADATA_TEXT:
+            {
+                const char *value = METADATA_FIELD(md, prop, char *);
+                return g_variant_new_string(value ? value : "");
+            }
+        case METADATA_UINT32:
+            return g_variant_new_uint32(METADATA_FIELD(md, prop, uint32_t));
+        case METADATA_TIME:
+            {
+                const time_t value = METADATA_FIELD(md, prop, time_t);
+                if (value == (time_t)-1)
+                {
+                    g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
+                                "Invalid problem data: %s cannot be returned", property_name);
+                    return NULL;
+                }
+                return g_variant_new_uint64((guint64)value);
+            }
+        case METADATA_BOOLEAN:
+            return g_variant_new_boolean(METADATA_FIELD(md, prop, bool));
+    }
+
+    return NULL;
+}
+
 int abrt_p2_entry_accessible_by_uid(AbrtP2Entry *entry,
             uid_t uid,
             struct dump_dir **dd)
@@ -108,7 +449,7 @@ int abrt_p2_entry_accessible_by_uid(AbrtP2Entry *entry,
     return ret;
 }
 
-int abrt_p2_entry_delete(AbrtP2Entry *entry, uid_t caller_uid, GError **error)
+int abrt_p2_entry_remove_directory(AbrtP2Entry *entry, uid_t caller_uid, GError **error)
 {
     struct dump_dir *dd = NULL;
     int ret = abrt_p2_entry_accessible_by_uid(entry, caller_uid, &dd);
@@ -120,15 +461,6 @@ int abrt_p2_entry_delete(AbrtP2Entry *entry, uid_t caller_uid, GError **error)
         return ret;
     }
 
-    if (entry->pv->p2e_state == ABRT_P2_ENTRY_STATE_DELETED)
-    {
-        g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
-                    "Problem entry is already deleted");
-
-        dd_close(dd);
-        return -EINVAL;
-    }
-
     dd = dd_fdopendir(dd, DD_DONT_WAIT_FOR_LOCK);
     if (dd == NULL)
     {
@@ -148,7 +480,31 @@ int abrt_p2_entry_delete(AbrtP2Entry *entry, uid_t caller_uid, GError **error)
         return ret;
     }
 
-    abrt_p2_entry_set_state(entry, ABRT_P2_ENTRY_STATE_DELETED);
+    return ret;
+}
+
+int abrt_p2_entry_delete(AbrtP2Entry *entry, uid_t caller_uid, GError **error)
+{
+    if (entry->pv->p2e_state == ABRT_P2_ENTRY_STATE_DELETED)
+    {
+        const int r = abrt_p2_entry_accessible_by_uid(entry, caller_uid, NULL);
+        if (r != 0)
+        {
+            g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_ACCESS_DENIED,
+                        "You are not authorized to delete the problem");
+
+            return r;
+        }
+
+        g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
+                    "Problem entry is already deleted");
+
+        return -EINVAL;
+    }
+
+    const int ret = abrt_p2_entry_remove_directory(entry, caller_uid, error);
+    if (ret == 0)
+        abrt_p2_entry_set_state(entry, ABRT_P2_ENTRY_STATE_DELETED);
 
     return ret;
 }
@@ -225,6 +581,78 @@ struct dump_dir *abrt_p2_entry_open_dump_dir(AbrtP2Entry *entry,
 /**
  * Read elements
  */
+static int read_elements_add_fd(GVariantBuilder *builder,
+            GUnixFDList *fd_list,
+            const char *name,
+            int fd,
+            long max_unix_fds)
+{
+    if (g_unix_fd_list_get_length(fd_list) == max_unix_fds)
+    {
+        error_msg("Reached limit of UNIX FDs per message: %ld", max_unix_fds);
+        close(fd);
+        return -EMFILE;
+    }
+
+    GError *error = NULL;
+    const gint pos = g_unix_fd_list_append(fd_list, fd, &error);
+    close(fd);
+    if (error != NULL)
+    {
+        error_msg("Failed to add file descriptor of %s: %s",
+                  name,
+                  error->message);
+
+        g_error_free(error);
+        return -EIO;
+    }
+
+    log_debug("Adding new Unix FD at position: %d",  pos);
+
+    g_variant_builder_add(builder, "{sv}",
+                                   name,
+                                   g_variant_new("h",
+                                                 pos));
+    return 0;
+}
+
+/* Opens the element for reading without loading its contents. Returns -ENODATA
+ * if the element should be read in the standard way. */
+static int read_elements_open_fd(struct dump_dir *dd,
+            const char *name,
+            gint32 flags)
+{
+    /* Type of an element is known only after reading its contents */
+    if (flags & (ABRT_P2_ENTRY_READ_ONLY_TEXT
+                 | ABRT_P2_ENTRY_READ_ONLY_BIG_TEXT
+                 | ABRT_P2_ENTRY_READ_ONLY_BINARY))
+        return -ENODATA;
+
+    if (!(flags & (ABRT_P2_ENTRY_READ_ALL_FD | ABRT_P2_ENTRY_READ_LARGE_FD)))
+        return -ENODATA;
+
+    struct stat st;
+    const int r = dd_item_stat(dd, name, &st);
+    if (r < 0)
+        return r;
+
+    if (!(flags & ABRT_P2_ENTRY_READ_ALL_FD) && st.st_size < ABRT_P2_ENTRY_LARGE_ELEMENT_SIZE)
+        return -ENODATA;
+
+    /* A new open file description, so readers do not share the offset */
+    const int fd = openat(dd->dd_fd, name, O_RDONLY | O_NOFOLLOW | O_CLOEXEC | O_NOCTTY);
+    if (fd < 0)
+        return -errno;
+
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+    {
+        close(fd);
+        return -EINVAL;
+    }
+
+    return fd;
+}
+
 GVariant *abrt_p2_entry_read_elements(AbrtP2Entry *entry,
              gint32 flags,
              GVariant *elements,
@@ -242,6 +670,14 @@ GVariant *abrt_p2_entry_read_elements(AbrtP2Entry *entry,
         return NULL;
     }
 
+    if ((flags & ABRT_P2_ENTRY_READ_LARGE_FD) && (flags & ABRT_P2_ENTRY_READ_ALL_NO_FD))
+    {
+        g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                    "Invalid arguments 'LARGE FD' ~ 'ALL NO FD'");
+
+        return NULL;
+    }
+
     struct dump_dir *dd = abrt_p2_entry_open_dump_dir(entry,
                                                       caller_uid,
                                                       DD_OPEN_READONLY | DD_DONT_WAIT_FOR_LOCK,
@@ -263,14 +699,23 @@ GVariant *abrt_p2_entry_read_elements(AbrtP2Entry *entry,
         /* Do ask me why -> see libreport xmalloc_read() */
         size_t data_size = (INT_MAX - 4095);
 
+        int fd = read_elements_open_fd(dd, name, flags);
+        if (fd >= 0)
+        {
+            log_debug("Passing element without reading it");
+            read_elements_add_fd(&builder, fd_list, name, fd, max_unix_fds);
+            continue;
+        }
+
         int elem_type = 0;
         char *data = NULL;
-        int fd = -1;
-        const int r = problem_data_load_dump_dir_element(dd,
-                                                         name,
-                                                         &data,
-                                                         &elem_type,
-                                                         &fd);
+        int r = fd;
+        if (r == -ENODATA)
+            r = problem_data_load_dump_dir_element(dd,
+                                                   name,
+                                                   &data,
+                                                   &elem_type,
+                                                   &fd);
         if (r < 0)
         {
             if (r == -ENOENT)
@@ -312,32 +757,7 @@ GVariant *abrt_p2_entry_read_elements(AbrtP2Entry *entry,
         if (   (flags & ABRT_P2_ENTRY_READ_ALL_FD)
             || (!(flags & ABRT_P2_ENTRY_READ_ALL_NO_FD) && !(elem_type & CD_FLAG_TXT)))
         {
-            if (g_unix_fd_list_get_length(fd_list) == max_unix_fds)
-            {
-                error_msg("Reached limit of UNIX FDs per message: %ld", max_unix_fds);
-                close(fd);
-                continue;
-            }
-
-            GError *error = NULL;
-            const gint pos = g_unix_fd_list_append(fd_list, fd, &error);
-            close(fd);
-            if (error != NULL)
-            {
-                error_msg("Failed to add file descriptor of %s: %s",
-                          name,
-                          error->message);
-
-                g_error_free(error);
-                continue;
-            }
-
-            log_debug("Adding new Unix FD at position: %d",  pos);
-
-            g_variant_builder_add(&builder, "{sv}",
-                                            name,
-                                            g_variant_new("h",
-                                                          pos));
+            read_elements_add_fd(&builder, fd_list, name, fd, max_unix_fds);
             continue;
         }
 
@@ -524,6 +944,113 @@ GVariant *abrt_p2_entry_save_elements(AbrtP2Entry *entry,
     return NULL;
 }
 
+/* Gets file system size and count of elements in a single pass */
+static int dump_dir_usage(struct dump_dir *dd,
+            off_t *size,
+            int *items)
+{
+    *size = 0;
+    *items = 0;
+
+    int r = 0;
+    char *short_name;
+    dd_init_next_file(dd);
+    while (dd_get_next_file(dd, &short_name, NULL))
+    {
+        struct stat st;
+        r = dd_item_stat(dd, short_name, &st);
+        free(short_name);
+        /* Removed in the meantime */
+        if (r == -ENOENT)
+        {
+            r = 0;
+            continue;
+        }
+
+        if (r < 0)
+            break;
+
+        *size += st.st_size;
+        ++(*items);
+    }
+
+    /* Finish the iteration to close the directory stream */
+    while (r < 0 && dd_get_next_file(dd, &short_name, NULL))
+        free(short_name);
+
+    return r;
+}
+
+/* Moves data in the kernel if the file descriptor allows it. */
+static off_t copy_fd_to_element(int in_fd,
+            int out_fd,
+            off_t max_size)
+{
+    struct stat st;
+    if (fstat(in_fd, &st) != 0)
+        return -errno;
+
+    off_t total = 0;
+    while (total < max_size)
+    {
+        const size_t chunk = (size_t)MIN(max_size - total, (off_t)ELEMENT_COPY_CHUNK_SIZE);
+
+        ssize_t copied;
+        if (S_ISFIFO(st.st_mode))
+            copied = splice(in_fd, NULL, out_fd, NULL, chunk, SPLICE_F_MOVE | SPLICE_F_MORE);
+        else if (S_ISREG(st.st_mode))
+            copied = sendfile(out_fd, in_fd, NULL, chunk);
+        else
+            break;
+
+        if (copied < 0)
+        {
+            /* Not supported by the file systems, copy the rest in user space */
+            if ((errno == EINVAL || errno == ENOSYS) && total == 0)
+                break;
+
+            return -errno;
+        }
+
+        /* EOF */
+        if (copied == 0)
+            return total;
+
+        total += copied;
+    }
+
+    if (total >= max_size)
+        return total;
+
+    const off_t copied = copyfd_size(in_fd, out_fd, max_size - total, /*flags*/0);
+    return copied < 0 ? copied : total + copied;
+}
+
+static off_t save_element_from_fd(struct dump_dir *dd,
+            const char *name,
+            int in_fd,
+            off_t max_size)
+{
+    /* Creates the element with the right owner and mode */
+    dd_save_binary(dd, name, "", 0);
+
+    const int out_fd = openat(dd->dd_fd, name, O_WRONLY | O_NOFOLLOW | O_CLOEXEC | O_NOCTTY);
+    if (out_fd < 0)
+    {
+        perror_msg("Can't open element '%s' for writing", name);
+        return -errno;
+    }
+
+    const off_t r = copy_fd_to_element(in_fd, out_fd, max_size);
+    if (close(out_fd) != 0)
+    {
+        perror_msg("Can't close element '%s'", name);
+        return r < 0 ? r : -EIO;
+    }
+
+    return r;
+}
+
 /**
  * Save elements in a dump directory
  */
@@ -542,28 +1069,19 @@ int abrt_p2_entry_save_elements_in_dump_dir(struct dump_dir *dd,
     GVariantIter iter;
     g_variant_iter_init(&iter, elements);
 
-    off_t dd_size = dd_compute_size(dd, /*no flags*/0);
-    if (dd_size < 0)
+    /* Both values are updated with every saved element */
+    off_t dd_size = 0;
+    int dd_items = 0;
+    const int usage_r = dump_dir_usage(dd, &dd_size, &dd_items);
+    if (usage_r < 0)
     {
         error_msg("Failed to get file system size of dump dir : %s",
-                  strerror(-(int)dd_size));
+                  strerror(-usage_r));
 
         g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_IO_ERROR,
                     "Dump directory file system size");
 
-        return dd_size;
-    }
-
-    int dd_items = dd_get_items_count(dd);
-    if (dd_items < 0)
-    {
-        error_msg("Failed to get count of dump dir elements: %s",
-                  strerror(-dd_items));
-
-        g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_IO_ERROR,
-                    "Dump directory elements count");
-
-        return dd_items;
+        return usage_r;
     }
 
     /* No need to free 'name' and 'container' unless breaking out of the loop */
@@ -777,7 +1295,7 @@ int abrt_p2_entry_save_elements_in_dump_dir(struct dump_dir *dd,
                 continue;
             }
 
-            const off_t r = dd_copy_fd(dd, name, fd, /*copy_flags*/0, max_size);
+            const off_t r = save_element_from_fd(dd, name, fd, max_size);
             close(fd);
 
             if (r < 0)
@@ -59,12 +59,119 @@ int abrt_p2_entry_delete(AbrtP2Entry *entry,
             uid_t caller_uid,
             GError **error);
 
+/*
+ * Removes the problem directory regardless of the entry's state and does not
+ * change the state. The function touches only the problem directory, hence it
+ * can be called from a worker thread for an unregistered entry.
+ */
+int abrt_p2_entry_remove_directory(AbrtP2Entry *entry,
+            uid_t caller_uid,
+            GError **error);
+
 int abrt_p2_entry_accessible_by_uid(AbrtP2Entry *entry,
             uid_t uid,
             struct dump_dir **dd);
 
 const char *abrt_p2_entry_problem_id(AbrtP2Entry *entry);
 
+/*
+ * The inotify watch descriptor of the problem directory, -1 if the directory
+ * is not watched
+ */
+int abrt_p2_entry_watch(AbrtP2Entry *entry);
+
+void abrt_p2_entry_set_watch(AbrtP2Entry *entry, int watch);
+
+/*
+ * The owner found when the entry was registered, (uid_t)-1 if unknown, and
+ * the change time of the problem directory taken before the owner was read.
+ * The owner is used for accounting of user's problems and both values are
+ * stored in the snapshot of registered entries.
+ */
+uid_t abrt_p2_entry_registered_owner(AbrtP2Entry *entry,
+            struct timespec *ctime);
+
+void abrt_p2_entry_set_registered_owner(AbrtP2Entry *entry,
+            uid_t owner,
+            const struct timespec *ctime);
+
+/*
+ * Values of the properties cached in memory, so neither filtering of problems
+ * nor reading of the properties has to read the elements
+ */
+typedef struct
+{
+    char *user;             ///< NULL if missing
+    char *hostname;         ///< NULL if missing
+    char *type;             ///< NULL if missing
+    char *executable;       ///< NULL if missing
+    char *cmdline;          ///< NULL if missing
+    char *component;        ///< NULL if missing
+    char *uuid;             ///< NULL if missing
+    char *duphash;          ///< NULL if missing
+    char *reason;           ///< NULL if missing
+    char *not_reportable;   ///< NULL if missing
+    uint32_t uid;
+    uint32_t count;
+    time_t first_occurrence;
+    time_t last_occurrence;
+    bool reported;
+    bool can_be_reported;
+    bool remote;
+} AbrtP2EntryMetadata;
+
+/*
+ * Returns cached metadata. Metadata of watched entries are reloaded by
+ * abrt_p2_entry_reload_metadata() and after
+ * abrt_p2_entry_invalidate_metadata(), metadata of the other entries are
+ * reloaded if the problem directory was modified.
+ *
+ * @returns NULL if the problem directory cannot be read; the metadata are
+ * valid until they are reloaded
+ */
+const AbrtP2EntryMetadata *abrt_p2_entry_metadata(AbrtP2Entry *entry);
+
+/*
+ * Returns true if the metadata have been loaded at least once
+ */
+bool abrt_p2_entry_metadata_loaded(AbrtP2Entry *entry);
+
+/*
+ * Same as abrt_p2_entry_metadata() but checks whether the caller can access
+ * the problem
+ */
+const AbrtP2EntryMetadata *abrt_p2_entry_metadata_for_uid(AbrtP2Entry *entry,
+            uid_t caller_uid,
+            GError **error);
+
+/*
+ * Replaces the cached metadata with fresh ones
+ *
+ * @returns Names of the properties whose values have changed since the
+ * previous call, including changes already seen by abrt_p2_entry_metadata()
+ * (the array does not own the names), or NULL if the problem directory cannot
+ * be read
+ */
+GPtrArray *abrt_p2_entry_reload_metadata(AbrtP2Entry *entry);
+
+/*
+ * Makes the next abrt_p2_entry_metadata() read the problem directory. Used
+ * after the service modified the directory, so its callers do not read stale
+ * values before the change notification is processed.
+ */
+void abrt_p2_entry_invalidate_metadata(AbrtP2Entry *entry);
+
+bool abrt_p2_entry_metadata_has_property(const char *property_name);
+
+/*
+ * Returns true if the element is a source of the metadata
+ */
+bool abrt_p2_entry_metadata_has_element(const char *element_name);
+
+GVariant *abrt_p2_entry_metadata_property_value(const AbrtP2EntryMetadata *md,
+            const char *property_name,
+            GError **error);
+
 struct dump_dir *abrt_p2_entry_open_dump_dir(AbrtP2Entry *entry,
             uid_t caller_uid,
             int dd_flags,
@@ -95,8 +202,13 @@ enum AbrtP2EntryReadElementsFlags
     ABRT_P2_ENTRY_READ_ONLY_BIG_TEXT      = 0x08,
     ABRT_P2_ENTRY_READ_ONLY_BINARY        = 0x10,
     ABRT_P2_ENTRY_READ_ALL_NO_FD          = 0x20,
+    ABRT_P2_ENTRY_READ_LARGE_FD           = 0x40,
 };
 
+/* Elements of this size and bigger are passed as file descriptors if
+ * ABRT_P2_ENTRY_READ_LARGE_FD is requested */
+#define ABRT_P2_ENTRY_LARGE_ELEMENT_SIZE (64 * 1024)
+
 GVariant *abrt_p2_entry_read_elements(AbrtP2Entry *entry,
             gint32 flags,
             GVariant *elements,
@@ -21,9 +21,13 @@
 #include <glib-object.h>
 #include <gio/gio.h>
 #include <gio/gunixfdlist.h>
+#include <sys/syscall.h>
+#include <sys/inotify.h>
 #include "libabrt.h"
+#include "abrt_glib.h"
 #include "problem_api.h"
 #include "abrt_problems2_task_new_problem.h"
+#include "abrt_problems2_task_delete_problems.h"
 #include "abrt_problems2_task.h"
 #include "abrt_problems2_generated_interfaces.h"
 #include "abrt_problems2_service.h"
@@ -45,8 +49,14 @@ struct problems2_object_type
     GDBusInterfaceInfo *iface;
     GDBusInterfaceVTable *vtable;
     GHashTable *objects;
+    guint subtree_regid;    ///< non-zero if the objects are dispatched by a subtree
 };
 
+static void abrt_p2_object_free(AbrtP2Object *obj);
+
+/* The number of elements in s_entry_index_elements */
+#define ENTRY_INDEX_ELEMENTS 5
+
 static int problems2_object_type_init(struct problems2_object_type *type,
             const char *xml_node,
             GDBusInterfaceVTable *vtable)
@@ -69,6 +79,14 @@ static int problems2_object_type_init(struct problems2_object_type *type,
 
 static void problems2_object_type_destroy(struct problems2_object_type *type)
 {
+    /* Objects of a subtree are not owned by GDBus */
+    if (type->subtree_regid != 0 && type->objects != NULL)
+    {
+        GList *objects = g_hash_table_get_values(type->objects);
+        g_list_free_full(objects, (GDestroyNotify)abrt_p2_object_free);
+        type->subtree_regid = 0;
+    }
+
     if (type->objects != NULL)
     {
         g_hash_table_destroy(type->objects);
@@ -169,6 +187,31 @@ typedef struct
     unsigned p2srv_limit_new_problem_throttling_magnitude;
     unsigned p2srv_limit_new_problems_batch;
 
+    /* Problem directories of Entries are watched, so cached metadata are
+     * reloaded only if the directories change */
+    int         p2srv_inotify_fd;
+    GIOChannel *p2srv_inotify_channel;
+    guint       p2srv_inotify_source;
+    GHashTable *p2srv_watched_entries;   ///< watch descriptor -> AbrtP2Object
+    GHashTable *p2srv_changed_entries;   ///< AbrtP2Object -> enum entry_changes
+    guint       p2srv_changed_entries_source;
+
+    /* Entries are registered when they are needed for the first time */
+    bool  p2srv_entries_loaded;
+    char *p2srv_entries_snapshot;
+
+    GHashTable *p2srv_problems_batches;  ///< Session AbrtP2Object -> struct problems_batch
+
+    /* Directories of deleted entries which have not been removed yet */
+    GHashTable *p2srv_deleted_dirs;      ///< problem directory -> AbrtP2TaskDeleteProblems
+
+    /* Index of entries by values of elements and by the last occurrence.
+     * The index is built by the first search. */
+    GHashTable *p2srv_index[ENTRY_INDEX_ELEMENTS];  ///< value -> GSequence of struct entry_index_record
+    GHashTable *p2srv_indexed_entries;   ///< AbrtP2Object -> struct entry_index_record
+    GHashTable *p2srv_unindexed_entries; ///< AbrtP2Object set
+    bool        p2srv_index_built;
+
     AbrtP2Object *p2srv_p2_object;
 } AbrtP2ServicePrivate;
 
@@ -195,6 +238,33 @@ static struct user_info *abrt_p2_service_user_new(AbrtP2Service *service,
 
 static GDBusConnection *abrt_p2_service_dbus(AbrtP2Service *service);
 
+static void abrt_p2_service_load_entries(AbrtP2Service *service);
+
+enum problems_batch_kind
+{
+    PROBLEMS_BATCH_NEW,
+    PROBLEMS_BATCH_CHANGED,
+    PROBLEMS_BATCH_DELETED,
+    PROBLEMS_BATCH_KINDS,
+};
+
+static void problems_batch_add(AbrtP2Service *service,
+            AbrtP2Object *entry_obj,
+            enum problems_batch_kind kind);
+
+static void problems_batch_unsubscribe(AbrtP2Service *service,
+            AbrtP2Object *session_obj);
+
+static void problems_batch_subscribe(AbrtP2Service *service,
+            AbrtP2Object *session_obj,
+            guint interval);
+
+static void entry_index_update(AbrtP2Service *service,
+            AbrtP2Object *object);
+
+static void entry_index_forget(AbrtP2Service *service,
+            AbrtP2Object *object);
+
 /*
  * DBus object
  */
@@ -246,6 +316,13 @@ void abrt_p2_object_destroy(AbrtP2Object *object)
 {
     log_debug("Unregistering object: %s", object->p2o_path);
 
+    /* Objects of a subtree disappear together with the node */
+    if (object->p2o_regid == 0)
+    {
+        abrt_p2_object_free(object);
+        return;
+    }
+
     g_dbus_connection_unregister_object(abrt_p2_service_dbus(object->p2o_service),
                                         object->p2o_regid);
 }
@@ -300,6 +377,13 @@ static AbrtP2Object *abrt_p2_object_new(AbrtP2Service *service,
     obj->p2o_type = type;
     obj->p2o_service = service;
 
+    if (type->subtree_regid != 0)
+    {
+        log_debug("Adding PATH %s iface %s to subtree", path, type->iface->name);
+        g_hash_table_insert(type->objects, path, obj);
+        return obj;
+    }
+
     /* Register the interface parsed from a XML file */
     log_debug("Registering PATH %s iface %s", path, type->iface->name);
     const guint registration_id = g_dbus_connection_register_object(abrt_p2_service_dbus(service),
@@ -431,6 +515,22 @@ static void session_object_dbus_method_call(GDBusConnection *connection,
         return;
     }
 
+    if (strcmp("SubscribeProblemsChanged", method_name) == 0)
+    {
+        guint interval = 0;
+        g_variant_get(parameters, "(u)", &interval);
+        problems_batch_subscribe(service, user_data, interval);
+        g_dbus_method_invocation_return_value(invocation, NULL);
+        return;
+    }
+
+    if (strcmp("UnsubscribeProblemsChanged", method_name) == 0)
+    {
+        problems_batch_unsubscribe(service, user_data);
+        g_dbus_method_invocation_return_value(invocation, NULL);
+        return;
+    }
+
     error_msg("BUG: org.freedesktop.Problems2.Session does not have method: %s",
               method_name);
 }
@@ -483,6 +583,7 @@ static void session_object_destructor(AbrtP2Object *obj)
         abort();
     }
 
+    problems_batch_unsubscribe(obj->p2o_service, obj);
     abrt_p2_session_clean_tasks(session);
     abrt_p2_session_revoke_authorization(session);
 
@@ -677,11 +778,412 @@ uid_t abrt_p2_service_caller_real_uid(AbrtP2Service *service,
 /*
  * /org/freedesktop/Problems2/Entry/XYZ
  */
+#define ENTRY_WATCH_EVENTS (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM \
+                            | IN_CREATE | IN_DELETE | IN_MOVE_SELF | IN_ONLYDIR)
+
+/* Changes made by a single writer are usually spread over several events */
+#define ENTRY_CHANGES_DELAY_MS 100
+/* Metadata cannot be read while the problem directory is locked */
+#define ENTRY_CHANGES_RETRY_DELAY_MS 1000
+
+enum entry_changes
+{
+    ENTRY_CHANGED_METADATA = 1 << 0,
+    ENTRY_CHANGED_ELEMENTS = 1 << 1,
+    ENTRY_CHANGED_REPORTS  = 1 << 2,
+    ENTRY_CHANGED_PACKAGE  = 1 << 3,
+    ENTRY_CHANGED_ALL = (ENTRY_CHANGED_METADATA
+                         | ENTRY_CHANGED_ELEMENTS
+                         | ENTRY_CHANGED_REPORTS
+                         | ENTRY_CHANGED_PACKAGE),
+};
+
+static void entry_object_emit_properties_changed(AbrtP2Object *object,
+            GPtrArray *properties)
+{
+    AbrtP2Service *service = object->p2o_service;
+    AbrtP2Entry *entry = abrt_p2_object_get_node(object);
+
+    /* The signal only invalidates the properties and the values must be read
+     * by the callers */
+    GVariant *children[3];
+    children[0] = g_variant_new_string(object->p2o_type->iface->name);
+    children[1] = g_variant_new_array(G_VARIANT_TYPE("{sv}"), NULL, 0);
+    children[2] = g_variant_new_strv((const gchar *const *)properties->pdata,
+                                     properties->len);
+
+    GVariant *parameters = g_variant_ref_sink(g_variant_new_tuple(children, 3));
+
+    if (g_verbose > 2)
+    {
+        gchar *pstr = g_variant_print(parameters, TRUE);
+        log_debug("Emitting signal '%s' : (%s)",
+                  "PropertiesChanged",
+                  pstr);
+        g_free(pstr);
+    }
+
+    /* Sent only to the sessions that can access the entry, the same way as
+     * the Crash signal */
+    GList *session_objects = problems2_object_type_get_all_objects(
+                                     &service->pv->p2srv_p2_session_type);
+
+    for (GList *iter = session_objects; iter != NULL; iter = g_list_next(iter))
+    {
+        AbrtP2Session *session = abrt_p2_object_get_node(iter->data);
+        const uid_t session_uid = abrt_p2_service_get_session_uid(service,
+                                                                  session);
+
+        const char *session_bus_address = abrt_p2_session_caller(session);
+
+        if (0 != abrt_p2_entry_accessible_by_uid(entry, session_uid, NULL))
+            continue;
+
+        GDBusMessage *message = g_dbus_message_new_signal(object->p2o_path,
+                                                         "org.freedesktop.DBus.Properties",
+                                                         "PropertiesChanged");
+
+        g_dbus_message_set_sender(message, ABRT_P2_BUS);
+        g_dbus_message_set_destination(message, session_bus_address);
+        g_dbus_message_set_body(message, parameters);
+
+        GError *error = NULL;
+        g_dbus_connection_send_message(abrt_p2_service_dbus(service),
+                                       message,
+                                       G_DBUS_SEND_MESSAGE_FLAGS_NONE,
+                                       NULL,
+                                       &error);
+        g_object_unref(message);
+        if (error != NULL)
+        {
+            error_msg("Failed to emit signal '%s' to '%s': %s",
+                      "PropertiesChanged",
+                      session_bus_address,
+                      error->message);
+            g_error_free(error);
+        }
+    }
+
+    g_list_free(session_objects);
+    g_variant_unref(parameters);
+}
+
+static void entry_object_prepare(AbrtP2Service *service,
+            AbrtP2Object *object);
+
+/* Returns -EAGAIN if the changes have to be refreshed later */
+static int entry_object_refresh(AbrtP2Object *object,
+            unsigned changes)
+{
+    AbrtP2Entry *entry = abrt_p2_object_get_node(object);
+    if (abrt_p2_entry_state(entry) == ABRT_P2_ENTRY_STATE_DELETED)
+        return 0;
+
+    GPtrArray *properties = NULL;
+    if (changes & ENTRY_CHANGED_METADATA)
+    {
+        entry_object_prepare(abrt_p2_object_service(object), object);
+        properties = abrt_p2_entry_reload_metadata(entry);
+        if (properties != NULL && properties->len != 0)
+            entry_index_update(abrt_p2_object_service(object), object);
+
+        if (properties == NULL)
+        {
+            /* A removed or broken directory is not worth another attempt */
+            char *lock = concat_path_file(abrt_p2_entry_problem_id(entry), ".lock");
+            struct stat st;
+            const bool locked = lstat(lock, &st) == 0;
+            free(lock);
+
+            return locked ? -EAGAIN : 0;
+        }
+    }
+    else
+        properties = g_ptr_array_new();
+
+    if (changes & ENTRY_CHANGED_ELEMENTS)
+        g_ptr_array_add(properties, (gpointer)"Elements");
+
+    if (changes & ENTRY_CHANGED_REPORTS)
+        g_ptr_array_add(properties, (gpointer)"Reports");
+
+    if (changes & ENTRY_CHANGED_PACKAGE)
+        g_ptr_array_add(properties, (gpointer)"Package");
+
+    if (properties->len != 0)
+    {
+        entry_object_emit_properties_changed(object, properties);
+        problems_batch_add(abrt_p2_object_service(object), object, PROBLEMS_BATCH_CHANGED);
+    }
+
+    g_ptr_array_free(properties, TRUE);
+    return 0;
+}
+
+static gboolean entry_objects_refresh_changed(gpointer user_data);
+
+static void entry_objects_schedule_refresh(AbrtP2Service *service,
+            guint delay)
+{
+    if (service->pv->p2srv_changed_entries_source != 0)
+        return;
+
+    service->pv->p2srv_changed_entries_source = g_timeout_add(delay,
+                                                              entry_objects_refresh_changed,
+                                                              service);
+}
+
+static void entry_object_mark_changed(AbrtP2Service *service,
+            AbrtP2Object *object,
+            unsigned changes)
+{
+    GHashTable *changed = service->pv->p2srv_changed_entries;
+    const unsigned current = GPOINTER_TO_UINT(g_hash_table_lookup(changed, object));
+    g_hash_table_insert(changed, object, GUINT_TO_POINTER(current | changes));
+
+    entry_objects_schedule_refresh(service, ENTRY_CHANGES_DELAY_MS);
+}
+
+static gboolean entry_objects_refresh_changed(gpointer user_data)
+{
+    AbrtP2Service *service = ABRT_P2_SERVICE(user_data);
+    AbrtP2ServicePrivate *pv = service->pv;
+
+    pv->p2srv_changed_entries_source = 0;
+
+    /* Signal handlers can cause new changes */
+    GHashTable *changed = pv->p2srv_changed_entries;
+    pv->p2srv_changed_entries = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+    bool retry = false;
+    GHashTableIter iter;
+    gpointer object;
+    gpointer changes;
+    g_hash_table_iter_init(&iter, changed);
+    while (g_hash_table_iter_next(&iter, &object, &changes))
+    {
+        if (entry_object_refresh(object, GPOINTER_TO_UINT(changes)) == -EAGAIN)
+        {
+            const unsigned current = GPOINTER_TO_UINT(g_hash_table_lookup(pv->p2srv_changed_entries, object));
+            g_hash_table_insert(pv->p2srv_changed_entries,
+                                object,
+                                GUINT_TO_POINTER(current | GPOINTER_TO_UINT(changes)));
+            retry = true;
+        }
+    }
+
+    g_hash_table_destroy(changed);
+
+    if (retry)
+        entry_objects_schedule_refresh(service, ENTRY_CHANGES_RETRY_DELAY_MS);
+    else if (g_hash_table_size(pv->p2srv_changed_entries) != 0)
+        entry_objects_schedule_refresh(service, ENTRY_CHANGES_DELAY_MS);
+
+    return G_SOURCE_REMOVE;
+}
+
+/* Returns the cached values affected by a modification of the element */
+static unsigned entry_changes_from_element(const char *element)
+{
+    unsigned changes = 0;
+    if (abrt_p2_entry_metadata_has_element(element))
+        changes |= ENTRY_CHANGED_METADATA;
+
+    if (strcmp(element, FILENAME_REPORTED_TO) == 0)
+        changes |= ENTRY_CHANGED_REPORTS;
+
+    if (strcmp(element, FILENAME_PACKAGE) == 0
+        || strcmp(element, FILENAME_PKG_EPOCH) == 0
+        || strcmp(element, FILENAME_PKG_NAME) == 0
+        || strcmp(element, FILENAME_PKG_VERSION) == 0
+        || strcmp(element, FILENAME_PKG_RELEASE) == 0)
+        changes |= ENTRY_CHANGED_PACKAGE;
+
+    return changes;
+}
+
+/* Accepts both 'as' and 'a{sv}' */
+static unsigned entry_changes_from_elements(GVariant *elements)
+{
+    unsigned changes = ENTRY_CHANGED_ELEMENTS;
+
+    GVariantIter iter;
+    GVariant *child;
+    g_variant_iter_init(&iter, elements);
+    while ((child = g_variant_iter_next_value(&iter)) != NULL)
+    {
+        GVariant *name = g_variant_is_of_type(child, G_VARIANT_TYPE_DICT_ENTRY)
+                         ? g_variant_get_child_value(child, 0)
+                         : g_variant_ref(child);
+
+        changes |= entry_changes_from_element(g_variant_get_string(name, NULL));
+
+        g_variant_unref(name);
+        g_variant_unref(child);
+    }
+
+    return changes;
+}
+
+static unsigned entry_changes_from_event(const struct inotify_event *event)
+{
+    /* Every dd_opendir() creates and removes the lock */
+    if (event->len == 0 || strcmp(event->name, ".lock") == 0)
+        return 0;
+
+    unsigned changes = entry_changes_from_element(event->name);
+    if (event->mask & (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO))
+        changes |= ENTRY_CHANGED_ELEMENTS;
+
+    return changes;
+}
+
+static void entry_object_unwatch(AbrtP2Service *service,
+            AbrtP2Object *object)
+{
+    AbrtP2Entry *entry = abrt_p2_object_get_node(object);
+    const int wd = abrt_p2_entry_watch(entry);
+    if (wd < 0)
+        return;
+
+    g_hash_table_remove(service->pv->p2srv_watched_entries, GINT_TO_POINTER(wd));
+    abrt_p2_entry_set_watch(entry, -1);
+
+    /* Fails if the kernel has already removed the watch */
+    inotify_rm_watch(service->pv->p2srv_inotify_fd, wd);
+}
+
+static void entry_object_watch(AbrtP2Service *service,
+            AbrtP2Object *object)
+{
+    AbrtP2ServicePrivate *pv = service->pv;
+    if (pv->p2srv_inotify_fd < 0)
+        return;
+
+    AbrtP2Entry *entry = abrt_p2_object_get_node(object);
+    if (abrt_p2_entry_watch(entry) >= 0)
+        return;
+
+    const char *dirname = abrt_p2_entry_problem_id(entry);
+    const int wd = inotify_add_watch(pv->p2srv_inotify_fd, dirname, ENTRY_WATCH_EVENTS);
+    if (wd < 0)
+    {
+        /* Metadata of not watched entries are validated by modification time */
+        static bool reported;
+        if (!reported || errno != ENOSPC)
+            log_notice("Can't watch '%s': %s", dirname, strerror(errno));
+        reported |= (errno == ENOSPC);
+        return;
+    }
+
+    if (g_hash_table_contains(pv->p2srv_watched_entries, GINT_TO_POINTER(wd)))
+    {
+        log_debug("'%s' is already watched by another Entry", dirname);
+        return;
+    }
+
+    g_hash_table_insert(pv->p2srv_watched_entries, GINT_TO_POINTER(wd), object);
+    abrt_p2_entry_set_watch(entry, wd);
+}
+
+/* Entries are watched since their metadata are used for the first time, so
+ * registration does not touch the problem directories */
+static void entry_object_prepare(AbrtP2Service *service,
+            AbrtP2Object *object)
+{
+    AbrtP2Entry *entry = abrt_p2_object_get_node(object);
+    if (!abrt_p2_entry_metadata_loaded(entry))
+        entry_object_watch(service, object);
+}
+
+static gboolean entry_objects_handle_inotify_cb(GIOChannel *gio,
+            GIOCondition condition,
+            gpointer user_data)
+{
+    AbrtP2Service *service = ABRT_P2_SERVICE(user_data);
+    AbrtP2ServicePrivate *pv = service->pv;
+
+    char buf[16 * (sizeof(struct inotify_event) + NAME_MAX + 1)]
+            __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    for (;;)
+    {
+        const ssize_t len = read(pv->p2srv_inotify_fd, buf, sizeof(buf));
+        if (len < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            if (errno != EAGAIN)
+                perror_msg("Error reading inotify fd");
+
+            break;
+        }
+
+        for (char *ptr = buf; ptr < buf + len; )
+        {
+            const struct inotify_event *event = (const struct inotify_event *)ptr;
+            ptr += sizeof(*event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                log_notice("Inotify queue overflowed, refreshing all Entries");
+
+                GHashTableIter iter;
+                gpointer object;
+                g_hash_table_iter_init(&iter, pv->p2srv_watched_entries);
+                while (g_hash_table_iter_next(&iter, NULL, &object))
+                    entry_object_mark_changed(service, object, ENTRY_CHANGED_ALL);
+
+                continue;
+            }
+
+            AbrtP2Object *object = g_hash_table_lookup(pv->p2srv_watched_entries,
+                                                       GINT_TO_POINTER(event->wd));
+            if (object == NULL)
+                continue;
+
+            if (event->mask & (IN_IGNORED | IN_MOVE_SELF))
+            {
+                /* The path of a moved directory belongs to something else */
+                entry_object_unwatch(service, object);
+                continue;
+            }
+
+            const unsigned changes = entry_changes_from_event(event);
+            if (changes != 0)
+                entry_object_mark_changed(service, object, changes);
+        }
+    }
+
+    return TRUE;
+}
+
 void abrt_p2_service_notify_entry_object(AbrtP2Service *service,
             AbrtP2Object *obj,
             GError **error)
 {
     AbrtP2Entry *entry = abrt_p2_object_get_node(obj);
+
+    /* abrtd notifies also about updated problems (e.g. a repeated crash), so
+     * the metadata are reloaded before the problem is announced */
+    entry_object_prepare(service, obj);
+    GPtrArray *properties = abrt_p2_entry_reload_metadata(entry);
+    if (properties == NULL)
+        entry_object_mark_changed(service, obj, ENTRY_CHANGED_METADATA);
+    else
+    {
+        if (properties->len != 0)
+        {
+            entry_index_update(service, obj);
+            entry_object_emit_properties_changed(obj, properties);
+        }
+
+        g_ptr_array_free(properties, TRUE);
+    }
+
+    problems_batch_add(service, obj, PROBLEMS_BATCH_NEW);
+
     uid_t owner_uid = abrt_p2_entry_get_owner(entry, error);
 
     if (owner_uid >= 0)
@@ -722,52 +1224,570 @@ void abrt_p2_service_notify_entry_object(AbrtP2Service *service,
     }
 }
 
-struct entry_object_save_elements_context
+/*
+ * Batches of changes for the ProblemsChanged signal
+ *
+ * Subscribed sessions get one signal with all new, changed and deleted
+ * entries instead of a signal per entry.
+ */
+/* Pending refreshes of the listed entries hold the signal at most this long */
+#define PROBLEMS_BATCH_MAX_HOLD_MS 2000
+
+static const char *const s_problems_batch_summary[] = {
+    "UID", "Type", "Count", "LastOccurrence", "Executable", "Component", "Reason",
+};
+
+struct problems_batch_change
 {
-    GDBusMethodInvocation *invocation;
-    GVariant *elements;
+    enum problems_batch_kind kind;
+    uid_t owner;                ///< the owner of a deleted entry
 };
 
-static void entry_object_save_elements_cb(GObject *source_object,
-            GAsyncResult *result,
-            gpointer user_data)
+struct problems_batch
 {
-    AbrtP2Entry *entry = ABRT_P2_ENTRY(source_object);
-    struct entry_object_save_elements_context *context = user_data;
+    AbrtP2Object *pb_session;
+    guint pb_interval;          ///< the minimal delay between two signals in ms
+    gint64 pb_last_emitted;     ///< monotonic time in us
+    gint64 pb_held_since;       ///< monotonic time in us, 0 if not held
+    guint pb_source;
+    GHashTable *pb_changes;     ///< entry path -> struct problems_batch_change
+};
 
-    g_variant_unref(context->elements);
+static GHashTable *problems_batch_changes_new(void)
+{
+    return g_hash_table_new_full(g_str_hash, g_str_equal, free, free);
+}
 
-    GError *error = NULL;
-    GVariant *response = abrt_p2_entry_save_elements_finish(entry,
-                                                            result,
-                                                            &error);
+static void problems_batch_free(struct problems_batch *batch)
+{
+    if (batch->pb_source != 0)
+        g_source_remove(batch->pb_source);
 
-    if (error == NULL)
+    g_hash_table_destroy(batch->pb_changes);
+    free(batch);
+}
+
+static void problems_batch_add_summary(GVariantBuilder *builder,
+            const char *entry_path,
+            const AbrtP2EntryMetadata *md)
+{
+    g_variant_builder_open(builder, G_VARIANT_TYPE("a{sv}"));
+    g_variant_builder_add(builder, "{sv}", "Entry", g_variant_new_object_path(entry_path));
+
+    for (size_t i = 0; i < ARRAY_SIZE(s_problems_batch_summary); ++i)
     {
-        g_dbus_method_invocation_return_value(context->invocation, response);
+        GVariant *value = abrt_p2_entry_metadata_property_value(md,
+                                                                s_problems_batch_summary[i],
+                                                                NULL);
+        if (value != NULL)
+            g_variant_builder_add(builder, "{sv}", s_problems_batch_summary[i], value);
     }
-    else
+
+    g_variant_builder_close(builder);
+}
+
+/* A refresh of a listed entry would send the entry again in the next signal
+ * and its summary would not contain the current values */
+static bool problems_batch_refresh_pending(AbrtP2Service *service,
+            GHashTable *changes)
+{
+    GHashTableIter iter;
+    const char *entry_path;
+    const struct problems_batch_change *change;
+    g_hash_table_iter_init(&iter, changes);
+    while (g_hash_table_iter_next(&iter, (gpointer)&entry_path, (gpointer)&change))
     {
-        g_dbus_method_invocation_return_gerror(context->invocation, error);
-        g_error_free(error);
+        if (change->kind == PROBLEMS_BATCH_DELETED)
+            continue;
+
+        AbrtP2Object *obj = problems2_object_type_get_object(&(service->pv->p2srv_p2_entry_type),
+                                                             entry_path);
+        if (obj != NULL && g_hash_table_contains(service->pv->p2srv_changed_entries, obj))
+            return true;
     }
 
-    g_object_unref(context->invocation);
-    free(context);
+    return false;
 }
 
-struct entry_object_read_elements_context
+static gboolean problems_batch_emit_cb(gpointer user_data)
 {
-    GDBusMethodInvocation *invocation;
-    GVariant *elements;
-    GUnixFDList *out_fd_list;
-};
+    struct problems_batch *batch = user_data;
+    batch->pb_source = 0;
 
-static void entry_object_read_elements_cb(GObject *source_object,
-            GAsyncResult *result,
-            gpointer user_data)
-{
-    AbrtP2Entry *entry = ABRT_P2_ENTRY(source_object);
+    AbrtP2Service *service = abrt_p2_object_service(batch->pb_session);
+
+    if (problems_batch_refresh_pending(service, batch->pb_changes))
+    {
+        const gint64 now = g_get_monotonic_time();
+        if (batch->pb_held_since == 0)
+            batch->pb_held_since = now;
+
+        if (now - batch->pb_held_since < (gint64)PROBLEMS_BATCH_MAX_HOLD_MS * 1000)
+        {
+            batch->pb_source = g_timeout_add(ENTRY_CHANGES_DELAY_MS,
+                                             problems_batch_emit_cb,
+                                             batch);
+            return G_SOURCE_REMOVE;
+        }
+    }
+
+    batch->pb_held_since = 0;
+    AbrtP2Session *session = abrt_p2_object_get_node(batch->pb_session);
+    const uid_t session_uid = abrt_p2_service_get_session_uid(service, session);
+
+    GHashTable *changes = batch->pb_changes;
+    batch->pb_changes = problems_batch_changes_new();
+
+    GVariantBuilder paths[PROBLEMS_BATCH_KINDS];
+    for (size_t i = 0; i < ARRAY_SIZE(paths); ++i)
+        g_variant_builder_init(&paths[i], G_VARIANT_TYPE("ao"));
+
+    GVariantBuilder summaries;
+    g_variant_builder_init(&summaries, G_VARIANT_TYPE("aa{sv}"));
+
+    unsigned count = 0;
+    GHashTableIter iter;
+    const char *entry_path;
+    const struct problems_batch_change *change;
+    g_hash_table_iter_init(&iter, changes);
+    while (g_hash_table_iter_next(&iter, (gpointer)&entry_path, (gpointer)&change))
+    {
+        if (change->kind == PROBLEMS_BATCH_DELETED)
+        {
+            /* The directory is gone, so only the owner is known */
+            if (session_uid != 0 && session_uid != change->owner)
+                continue;
+        }
+        else
+        {
+            AbrtP2Object *obj = problems2_object_type_get_object(&(service->pv->p2srv_p2_entry_type),
+                                                                 entry_path);
+            if (obj == NULL)
+                continue;
+
+            entry_object_prepare(service, obj);
+            AbrtP2Entry *entry = abrt_p2_object_get_node(obj);
+            const AbrtP2EntryMetadata *md = abrt_p2_entry_metadata_for_uid(entry,
+                                                                           session_uid,
+                                                                           NULL);
+            if (md == NULL)
+                continue;
+
+            problems_batch_add_summary(&summaries, entry_path, md);
+        }
+
+        g_variant_builder_add(&paths[change->kind], "o", entry_path);
+        ++count;
+    }
+
+    g_hash_table_destroy(changes);
+
+    if (count == 0)
+    {
+        for (size_t i = 0; i < ARRAY_SIZE(paths); ++i)
+            g_variant_builder_clear(&paths[i]);
+
+        g_variant_builder_clear(&summaries);
+        return G_SOURCE_REMOVE;
+    }
+
+    log_debug("Problems changed signal with %u entries sent to session: '%s'",
+              count, abrt_p2_session_caller(session));
+
+    GVariant *parameters = g_variant_new("(aoaoaoaa{sv})",
+                                         &paths[PROBLEMS_BATCH_NEW],
+                                         &paths[PROBLEMS_BATCH_CHANGED],
+                                         &paths[PROBLEMS_BATCH_DELETED],
+                                         &summaries);
+
+    abrt_p2_object_emit_signal_with_destination(service->pv->p2srv_p2_object,
+                                                "ProblemsChanged",
+                                                parameters,
+                                                abrt_p2_session_caller(session));
+
+    batch->pb_last_emitted = g_get_monotonic_time();
+    return G_SOURCE_REMOVE;
+}
+
+static void problems_batch_schedule(struct problems_batch *batch)
+{
+    if (batch->pb_source != 0)
+        return;
+
+    const gint64 next = batch->pb_last_emitted + (gint64)batch->pb_interval * 1000;
+    const gint64 now = g_get_monotonic_time();
+    const guint delay = next > now ? (guint)((next - now) / 1000) : 0;
+
+    batch->pb_source = g_timeout_add(delay, problems_batch_emit_cb, batch);
+}
+
+static void problems_batch_record(struct problems_batch *batch,
+            const char *entry_path,
+            enum problems_batch_kind kind,
+            uid_t owner)
+{
+    struct problems_batch_change *change = g_hash_table_lookup(batch->pb_changes, entry_path);
+    if (change == NULL)
+    {
+        change = xmalloc(sizeof(*change));
+        change->kind = kind;
+        g_hash_table_insert(batch->pb_changes, xstrdup(entry_path), change);
+    }
+    else if (kind == PROBLEMS_BATCH_DELETED)
+        change->kind = PROBLEMS_BATCH_DELETED;
+    /* A directory re-created with the same name is a new problem */
+    else if (   change->kind == PROBLEMS_BATCH_DELETED
+             || change->kind == PROBLEMS_BATCH_NEW
+             || kind == PROBLEMS_BATCH_NEW)
+        change->kind = PROBLEMS_BATCH_NEW;
+
+    change->owner = owner;
+    problems_batch_schedule(batch);
+}
+
+static void problems_batch_add(AbrtP2Service *service,
+            AbrtP2Object *entry_obj,
+            enum problems_batch_kind kind)
+{
+    GHashTable *batches = service->pv->p2srv_problems_batches;
+    if (batches == NULL || g_hash_table_size(batches) == 0)
+        return;
+
+    AbrtP2Entry *entry = abrt_p2_object_get_node(entry_obj);
+    const uid_t owner = abrt_p2_entry_registered_owner(entry, NULL);
+
+    GHashTableIter iter;
+    struct problems_batch *batch;
+    g_hash_table_iter_init(&iter, batches);
+    while (g_hash_table_iter_next(&iter, NULL, (gpointer)&batch))
+        problems_batch_record(batch, entry_obj->p2o_path, kind, owner);
+}
+
+static void problems_batch_subscribe(AbrtP2Service *service,
+            AbrtP2Object *session_obj,
+            guint interval)
+{
+    struct problems_batch *batch = g_hash_table_lookup(service->pv->p2srv_problems_batches,
+                                                       session_obj);
+    if (batch == NULL)
+    {
+        batch = xzalloc(sizeof(*batch));
+        batch->pb_session = session_obj;
+        batch->pb_changes = problems_batch_changes_new();
+        g_hash_table_insert(service->pv->p2srv_problems_batches, session_obj, batch);
+    }
+
+    log_debug("Session '%s' subscribed to ProblemsChanged: %u ms",
+              session_obj->p2o_path, interval);
+
+    batch->pb_interval = interval;
+}
+
+static void problems_batch_unsubscribe(AbrtP2Service *service,
+            AbrtP2Object *session_obj)
+{
+    if (service->pv->p2srv_problems_batches != NULL)
+        g_hash_table_remove(service->pv->p2srv_problems_batches, session_obj);
+}
+
+/*
+ * Index of entries for searching problems by an element
+ *
+ * Every value of an indexed element has a sequence of entries ordered by the
+ * last occurrence. Entries are indexed from their cached metadata and
+ * re-indexed whenever the metadata of a watched entry change. Entries which
+ * cannot be watched are re-indexed before every search.
+ */
+static const struct
+{
+    const char *element;
+    size_t offset;
+} s_entry_index_elements[ENTRY_INDEX_ELEMENTS] = {
+    { FILENAME_UUID,       offsetof(AbrtP2EntryMetadata, uuid)       },
+    { FILENAME_DUPHASH,    offsetof(AbrtP2EntryMetadata, duphash)    },
+    { FILENAME_EXECUTABLE, offsetof(AbrtP2EntryMetadata, executable) },
+    { FILENAME_COMPONENT,  offsetof(AbrtP2EntryMetadata, component)  },
+    { FILENAME_TYPE,       offsetof(AbrtP2EntryMetadata, type)       },
+};
+
+struct entry_index_record
+{
+    AbrtP2Object *object;
+    time_t last_occurrence;
+    char *values[ENTRY_INDEX_ELEMENTS];                ///< NULL if missing
+    GSequenceIter *positions[ENTRY_INDEX_ELEMENTS];    ///< NULL if missing
+};
+
+static void entry_index_record_free(struct entry_index_record *record)
+{
+    for (size_t i = 0; i < ENTRY_INDEX_ELEMENTS; ++i)
+        free(record->values[i]);
+
+    free(record);
+}
+
+static gint entry_index_record_cmp(gconstpointer a,
+            gconstpointer b,
+            gpointer user_data)
+{
+    const struct entry_index_record *ra = a;
+    const struct entry_index_record *rb = b;
+
+    if (ra->last_occurrence != rb->last_occurrence)
+        return ra->last_occurrence < rb->last_occurrence ? -1 : 1;
+
+    if (ra->object != rb->object)
+        return (uintptr_t)ra->object < (uintptr_t)rb->object ? -1 : 1;
+
+    return 0;
+}
+
+static int entry_index_element(const char *element)
+{
+    for (int i = 0; i < ENTRY_INDEX_ELEMENTS; ++i)
+        if (strcmp(s_entry_index_elements[i].element, element) == 0)
+            return i;
+
+    return -1;
+}
+
+static void entry_index_forget(AbrtP2Service *service,
+            AbrtP2Object *object)
+{
+    AbrtP2ServicePrivate *pv = service->pv;
+    if (pv->p2srv_indexed_entries == NULL)
+        return;
+
+    g_hash_table_remove(pv->p2srv_unindexed_entries, object);
+
+    struct entry_index_record *record = g_hash_table_lookup(pv->p2srv_indexed_entries, object);
+    if (record == NULL)
+        return;
+
+    for (size_t i = 0; i < ENTRY_INDEX_ELEMENTS; ++i)
+    {
+        if (record->positions[i] == NULL)
+            continue;
+
+        GSequence *entries = g_sequence_iter_get_sequence(record->positions[i]);
+        g_sequence_remove(record->positions[i]);
+        if (g_sequence_is_empty(entries))
+            g_hash_table_remove(pv->p2srv_index[i], record->values[i]);
+    }
+
+    g_hash_table_remove(pv->p2srv_indexed_entries, object);
+}
+
+static void entry_index_add(AbrtP2Service *service,
+            AbrtP2Object *object)
+{
+    AbrtP2ServicePrivate *pv = service->pv;
+
+    entry_index_forget(service, object);
+
+    entry_object_prepare(service, object);
+    AbrtP2Entry *entry = abrt_p2_object_get_node(object);
+    const AbrtP2EntryMetadata *md = abrt_p2_entry_metadata(entry);
+    if (md == NULL)
+    {
+        /* Metadata cannot be read while the directory is locked, the entry
+         * is indexed by the next search */
+        g_hash_table_add(pv->p2srv_unindexed_entries, object);
+        return;
+    }
+
+    struct entry_index_record *record = xzalloc(sizeof(*record));
+    record->object = object;
+    record->last_occurrence = md->last_occurrence;
+
+    for (size_t i = 0; i < ENTRY_INDEX_ELEMENTS; ++i)
+    {
+        const char *value = *(char **)((char *)md + s_entry_index_elements[i].offset);
+        if (value == NULL)
+            continue;
+
+        GSequence *entries = g_hash_table_lookup(pv->p2srv_index[i], value);
+        if (entries == NULL)
+        {
+            entries = g_sequence_new(NULL);
+            g_hash_table_insert(pv->p2srv_index[i], xstrdup(value), entries);
+        }
+
+        record->values[i] = xstrdup(value);
+        record->positions[i] = g_sequence_insert_sorted(entries,
+                                                        record,
+                                                        entry_index_record_cmp,
+                                                        NULL);
+    }
+
+    g_hash_table_insert(pv->p2srv_indexed_entries, object, record);
+
+    /* Changes of not watched entries are not noticed */
+    if (abrt_p2_entry_watch(entry) < 0)
+        g_hash_table_add(pv->p2srv_unindexed_entries, object);
+}
+
+static void entry_index_update(AbrtP2Service *service,
+            AbrtP2Object *object)
+{
+    if (service->pv->p2srv_index_built)
+        entry_index_add(service, object);
+}
+
+static void entry_index_refresh(AbrtP2Service *service)
+{
+    AbrtP2ServicePrivate *pv = service->pv;
+
+    if (!pv->p2srv_index_built)
+    {
+        abrt_p2_service_load_entries(service);
+
+        log_debug("Building index of entries");
+        GHashTableIter iter;
+        AbrtP2Object *object;
+        g_hash_table_iter_init(&iter, pv->p2srv_p2_entry_type.objects);
+        while (g_hash_table_iter_next(&iter, NULL, (gpointer)&object))
+            g_hash_table_add(pv->p2srv_unindexed_entries, object);
+
+        pv->p2srv_index_built = true;
+    }
+
+    /* Entries which can't be watched return to the set */
+    GHashTable *unindexed = pv->p2srv_unindexed_entries;
+    pv->p2srv_unindexed_entries = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+    GHashTableIter iter;
+    AbrtP2Object *object;
+    g_hash_table_iter_init(&iter, unindexed);
+    while (g_hash_table_iter_next(&iter, (gpointer)&object, NULL))
+        entry_index_add(service, object);
+
+    g_hash_table_destroy(unindexed);
+}
+
+int abrt_p2_service_find_problems_by_element(AbrtP2Service *service,
+            uid_t caller_uid,
+            const char *element,
+            const char *value,
+            time_t timestamp_from,
+            time_t timestamp_to,
+            GList **problems)
+{
+    *problems = NULL;
+
+    const int i = entry_index_element(element);
+    if (i < 0)
+        return -ENOTSUP;
+
+    /* An empty value matches also the problems without the element, which
+     * are not indexed */
+    if (value[0] == '\0')
+        return -ENOTSUP;
+
+    entry_index_refresh(service);
+
+    GSequence *entries = g_hash_table_lookup(service->pv->p2srv_index[i], value);
+    if (entries == NULL)
+        return 0;
+
+    struct entry_index_record first = {
+        .object = NULL,
+        .last_occurrence = timestamp_from,
+    };
+
+    GList *list = NULL;
+    GSequenceIter *iter = g_sequence_search(entries, &first, entry_index_record_cmp, NULL);
+    for (; !g_sequence_iter_is_end(iter); iter = g_sequence_iter_next(iter))
+    {
+        const struct entry_index_record *record = g_sequence_get(iter);
+        if (record->last_occurrence > timestamp_to)
+            break;
+
+        AbrtP2Entry *entry = abrt_p2_object_get_node(record->object);
+        if (abrt_p2_entry_state(entry) != ABRT_P2_ENTRY_STATE_COMPLETE)
+            continue;
+
+        /* The directory might have been removed or given to somebody else */
+        if (abrt_p2_entry_metadata_for_uid(entry, caller_uid, NULL) == NULL)
+            continue;
+
+        list = g_list_prepend(list, xstrdup(abrt_p2_entry_problem_id(entry)));
+    }
+
+    *problems = g_list_reverse(list);
+    return 0;
+}
+
+struct entry_object_save_elements_context
+{
+    AbrtP2Service *service;
+    GDBusMethodInvocation *invocation;
+    GVariant *elements;
+};
+
+/* Data changed through the service are refreshed even if the directory is not
+ * watched */
+static void entry_object_mark_entry_changed(AbrtP2Service *service,
+            AbrtP2Entry *entry,
+            unsigned changes)
+{
+    AbrtP2Object *obj = abrt_p2_service_get_entry_for_problem(service,
+                                                              abrt_p2_entry_problem_id(entry),
+                                                              ABRT_P2_SERVICE_ENTRY_LOOKUP_OPTIONAL,
+                                                              NULL);
+    if (obj == NULL)
+        return;
+
+    /* The callers must read the new values before the changes are
+     * announced */
+    if (changes & ENTRY_CHANGED_METADATA)
+        abrt_p2_entry_invalidate_metadata(abrt_p2_object_get_node(obj));
+
+    entry_object_mark_changed(service, obj, changes);
+}
+
+static void entry_object_save_elements_cb(GObject *source_object,
+            GAsyncResult *result,
+            gpointer user_data)
+{
+    AbrtP2Entry *entry = ABRT_P2_ENTRY(source_object);
+    struct entry_object_save_elements_context *context = user_data;
+
+    const unsigned changes = entry_changes_from_elements(context->elements);
+    g_variant_unref(context->elements);
+
+    GError *error = NULL;
+    GVariant *response = abrt_p2_entry_save_elements_finish(entry,
+                                                            result,
+                                                            &error);
+
+    if (error == NULL)
+    {
+        entry_object_mark_entry_changed(context->service, entry, changes);
+        g_dbus_method_invocation_return_value(context->invocation, response);
+    }
+    else
+    {
+        g_dbus_method_invocation_return_gerror(context->invocation, error);
+        g_error_free(error);
+    }
+
+    g_object_unref(context->invocation);
+    free(context);
+}
+
+struct entry_object_read_elements_context
+{
+    GDBusMethodInvocation *invocation;
+    GVariant *elements;
+    GUnixFDList *out_fd_list;
+};
+
+static void entry_object_read_elements_cb(GObject *source_object,
+            GAsyncResult *result,
+            gpointer user_data)
+{
+    AbrtP2Entry *entry = ABRT_P2_ENTRY(source_object);
     struct entry_object_read_elements_context *context = user_data;
 
     g_variant_unref(context->elements);
@@ -855,6 +1875,7 @@ static void entry_object_dbus_method_call(GDBusConnection *connection,
 
         struct entry_object_save_elements_context *context = xmalloc(sizeof(*context));
 
+        context->service = service;
         context->invocation = g_object_ref(invocation);
         context->elements = g_variant_get_child_value(parameters, 0);
 
@@ -888,6 +1909,11 @@ static void entry_object_dbus_method_call(GDBusConnection *connection,
                                                  elements,
                                                  &error);
 
+        if (error == NULL)
+            entry_object_mark_entry_changed(service,
+                                            entry,
+                                            entry_changes_from_elements(elements));
+
         g_variant_unref(elements);
     }
     else
@@ -930,29 +1956,12 @@ static void entry_object_dbus_method_call(GDBusConnection *connection,
 
 #define GET_UINT32_PROPERTY(name, element, def) GET_INTEGER_PROPERTY(name, element, 32, def)
 
-static GVariant *entry_object_dbus_get_property(GDBusConnection *connection,
-            const gchar *caller,
-            const gchar *object_path,
-            const gchar *interface_name,
+/* Reads the property from the opened problem directory */
+static GVariant *entry_property_value(struct dump_dir *dd,
             const gchar *property_name,
-            GError      **error,
-            gpointer    user_data)
+            GError      **error)
 {
-    log_debug("Problems2.Entry get property : %s", property_name);
-
-    AbrtP2Service *service = abrt_p2_object_service(user_data);
-    uid_t caller_uid = abrt_p2_service_caller_uid(service, caller, error);
-    if (caller_uid == (uid_t)-1)
-        return NULL;
-
     GVariant *retval;
-    AbrtP2Entry *entry = abrt_p2_object_get_node(user_data);
-    struct dump_dir *dd = abrt_p2_entry_open_dump_dir(entry,
-                                                      caller_uid,
-                                                      DD_DONT_WAIT_FOR_LOCK | DD_OPEN_READONLY,
-                                                      error);
-    if (dd == NULL)
-        return NULL;
 
     if (strcmp("ID", property_name) == 0)
     {
@@ -979,7 +1988,6 @@ static GVariant *entry_object_dbus_get_property(GDBusConnection *connection,
         time_t tm = dd_get_first_occurrence(dd);
         if (tm == (time_t) -1)
         {
-            dd_close(dd);
             g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
                         "Invalid problem data: FirstOccurrence cannot be returned");
             return NULL;
@@ -994,7 +2002,6 @@ static GVariant *entry_object_dbus_get_property(GDBusConnection *connection,
         time_t ltm = dd_get_last_occurrence(dd);
         if (ltm == (time_t) -1)
         {
-            dd_close(dd);
             g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
                         "Invalid problem data: LastOccurrence cannot be returned");
             return NULL;
@@ -1122,39 +2129,77 @@ static GVariant *entry_object_dbus_get_property(GDBusConnection *connection,
        goto return_property_value;
     }
 
-    dd_close(dd);
     error_msg("Unknown property %s", property_name);
     g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_PROPERTY,
             "BUG: the property getter has to be implemented");
     return NULL;
 
 return_property_value:
-    dd_close(dd);
     return retval;
 }
 
-#ifdef PROBLEMS2_PROPERTY_SET
-static gboolean entry_object_dbus_set_property(GDBusConnection *connection,
+static GVariant *entry_object_dbus_get_property(GDBusConnection *connection,
             const gchar *caller,
             const gchar *object_path,
             const gchar *interface_name,
             const gchar *property_name,
-            GVariant    *args,
             GError      **error,
             gpointer    user_data)
 {
-    log_debug("Problems2.Entry set property : %s", property_name);
+    log_debug("Problems2.Entry get property : %s", property_name);
 
-    uid_t caller_uid = abrt_p2_service_caller_uid(connection, caller, error);
+    AbrtP2Service *service = abrt_p2_object_service(user_data);
+    uid_t caller_uid = abrt_p2_service_caller_uid(service, caller, error);
     if (caller_uid == (uid_t)-1)
-        return FALSE;
+        return NULL;
 
     AbrtP2Entry *entry = abrt_p2_object_get_node(user_data);
+    if (abrt_p2_entry_metadata_has_property(property_name))
+    {
+        entry_object_prepare(service, user_data);
+        const AbrtP2EntryMetadata *md = abrt_p2_entry_metadata_for_uid(entry,
+                                                                       caller_uid,
+                                                                       error);
+        if (md == NULL)
+            return NULL;
+
+        return abrt_p2_entry_metadata_property_value(md, property_name, error);
+    }
+
     struct dump_dir *dd = abrt_p2_entry_open_dump_dir(entry,
                                                       caller_uid,
-                                                      DD_DONT_WAIT_FOR_LOCK,
+                                                      DD_DONT_WAIT_FOR_LOCK | DD_OPEN_READONLY,
                                                       error);
-    if (entry == NULL)
+    if (dd == NULL)
+        return NULL;
+
+    GVariant *retval = entry_property_value(dd, property_name, error);
+    dd_close(dd);
+    return retval;
+}
+
+#ifdef PROBLEMS2_PROPERTY_SET
+static gboolean entry_object_dbus_set_property(GDBusConnection *connection,
+            const gchar *caller,
+            const gchar *object_path,
+            const gchar *interface_name,
+            const gchar *property_name,
+            GVariant    *args,
+            GError      **error,
+            gpointer    user_data)
+{
+    log_debug("Problems2.Entry set property : %s", property_name);
+
+    uid_t caller_uid = abrt_p2_service_caller_uid(connection, caller, error);
+    if (caller_uid == (uid_t)-1)
+        return FALSE;
+
+    AbrtP2Entry *entry = abrt_p2_object_get_node(user_data);
+    struct dump_dir *dd = abrt_p2_entry_open_dump_dir(entry,
+                                                      caller_uid,
+                                                      DD_DONT_WAIT_FOR_LOCK,
+                                                      error);
+    if (entry == NULL)
         return FALSE;
 
     if (strcmp("id", property_name) == 0)
@@ -1282,6 +2327,15 @@ static gboolean entry_object_dbus_set_property(GDBusConnection *connection,
 
 static void entry_object_destructor(AbrtP2Object *obj)
 {
+    AbrtP2Service *service = abrt_p2_object_service(obj);
+    if (service->pv->p2srv_changed_entries != NULL)
+    {
+        entry_object_unwatch(service, obj);
+        g_hash_table_remove(service->pv->p2srv_changed_entries, obj);
+    }
+
+    entry_index_forget(service, obj);
+
     AbrtP2Entry *entry = (AbrtP2Entry *)obj->node;
     g_object_unref(entry);
 }
@@ -1303,11 +2357,21 @@ static AbrtP2Object *entry_object_register_dump_dir(AbrtP2Service *service,
     return abrt_p2_service_register_entry(service, entry, error);
 }
 
-AbrtP2Object *abrt_p2_service_register_entry(AbrtP2Service *service,
-            struct _AbrtP2Entry *entry,
+static AbrtP2Object *entry_object_register(AbrtP2Service *service,
+            AbrtP2Entry *entry,
+            uid_t owner,
+            const struct timespec *ctime,
             GError **error)
 {
     const char *dd_dirname = abrt_p2_entry_problem_id(entry);
+    if (g_hash_table_contains(service->pv->p2srv_deleted_dirs, dd_dirname))
+    {
+        g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
+                    "Problem directory '%s' is being deleted", dd_dirname);
+        g_object_unref(entry);
+        return NULL;
+    }
+
     log_debug("Registering problem entry for directory: %s", dd_dirname);
     char *path = entry_object_dir_name_to_path(dd_dirname);
 
@@ -1325,9 +2389,10 @@ AbrtP2Object *abrt_p2_service_register_entry(AbrtP2Service *service,
         return NULL;
     }
 
-    struct dump_dir *dd = dd_opendir(dd_dirname, DD_OPEN_FD_ONLY);
-    uid_t owner = dd_get_owner(dd);
-    dd_close(dd);
+    abrt_p2_entry_set_registered_owner(entry, owner, ctime);
+
+    if (service->pv->p2srv_index_built)
+        g_hash_table_add(service->pv->p2srv_unindexed_entries, obj);
 
     struct user_info *user = abrt_p2_service_user_lookup(service, owner);
 
@@ -1346,6 +2411,23 @@ AbrtP2Object *abrt_p2_service_register_entry(AbrtP2Service *service,
     return obj;
 }
 
+AbrtP2Object *abrt_p2_service_register_entry(AbrtP2Service *service,
+            struct _AbrtP2Entry *entry,
+            GError **error)
+{
+    /* A change of the owner made after stat() changes the time again */
+    struct stat st;
+    memset(&st, 0, sizeof(st));
+    if (lstat(abrt_p2_entry_problem_id(entry), &st) != 0)
+        log_debug("Can't stat '%s': %s", abrt_p2_entry_problem_id(entry), strerror(errno));
+
+    struct dump_dir *dd = dd_opendir(abrt_p2_entry_problem_id(entry), DD_OPEN_FD_ONLY);
+    uid_t owner = dd_get_owner(dd);
+    dd_close(dd);
+
+    return entry_object_register(service, entry, owner, &st.st_ctim, error);
+}
+
 struct entry_object_save_problem_args
 {
     AbrtP2EntrySaveElementsLimits limits;
@@ -1537,6 +2619,8 @@ AbrtP2Object *abrt_p2_service_get_entry_object(AbrtP2Service *service,
             int flags,
             GError **error)
 {
+    abrt_p2_service_load_entries(service);
+
     AbrtP2Object *obj = problems2_object_type_get_object(&(service->pv->p2srv_p2_entry_type),
                                                          entry_path);
 
@@ -1549,6 +2633,46 @@ AbrtP2Object *abrt_p2_service_get_entry_object(AbrtP2Service *service,
     return obj;
 }
 
+AbrtP2Object *abrt_p2_service_restore_problem(AbrtP2Service *service,
+            const char *problem_id,
+            GError **error)
+{
+    AbrtP2TaskDeleteProblems *task = g_hash_table_lookup(service->pv->p2srv_deleted_dirs,
+                                                         problem_id);
+    if (task == NULL)
+        return NULL;
+
+    switch (abrt_p2_task_delete_problems_keep_entry(task, problem_id))
+    {
+        case ABRT_P2_TASK_DELETE_PROBLEMS_KEEP_REMOVED:
+            g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
+                        "Problem directory '%s' has been deleted", problem_id);
+            return NULL;
+        case ABRT_P2_TASK_DELETE_PROBLEMS_KEEP_PENDING:
+            /* delete_problems_on_status_changed() finishes the restore */
+            log_notice("Problem directory '%s' is being deleted, it will be restored if that fails", problem_id);
+            g_set_error(error, G_IO_ERROR, G_IO_ERROR_PENDING,
+                        "Problem directory '%s' is being deleted", problem_id);
+            return NULL;
+        case ABRT_P2_TASK_DELETE_PROBLEMS_KEEP_KEPT:
+            break;
+    }
+
+    log_notice("Problem directory '%s' will not be deleted", problem_id);
+    g_hash_table_remove(service->pv->p2srv_deleted_dirs, problem_id);
+
+    AbrtP2Entry *entry = abrt_p2_entry_new_with_state(xstrdup(problem_id),
+                                                      ABRT_P2_ENTRY_STATE_COMPLETE);
+    if (entry == NULL)
+    {
+        g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
+                    "Cannot access problem directory '%s'", problem_id);
+        return NULL;
+    }
+
+    return abrt_p2_service_register_entry(service, entry, error);
+}
+
 AbrtP2Object *abrt_p2_service_get_entry_for_problem(AbrtP2Service *service,
             const char *problem_id,
             int flags,
@@ -1564,39 +2688,6 @@ AbrtP2Object *abrt_p2_service_get_entry_for_problem(AbrtP2Service *service,
     return obj;
 }
 
-int abrt_p2_service_remove_problem(AbrtP2Service *service,
-            const char *entry_path,
-            uid_t caller_uid,
-            GError **error)
-{
-    AbrtP2Object *obj = abrt_p2_service_get_entry_object(service,
-                                                         entry_path,
-                                                         ABRT_P2_SERVICE_ENTRY_LOOKUP_NOFLAGS,
-                                                         error);
-    if (obj == NULL)
-    {
-        log_debug("The requested Problem Entry does not exist");
-        return -ENOENT;
-    }
-
-    AbrtP2Entry *entry = ABRT_P2_ENTRY(abrt_p2_object_get_node(obj));
-    if (abrt_p2_entry_state(entry) != ABRT_P2_ENTRY_STATE_COMPLETE)
-    {
-        log_debug("Cannot remove temporary/deleted Problem Entry");
-        return -EINVAL;
-    }
-
-    const int ret = abrt_p2_entry_delete(entry, caller_uid, error);
-    if (ret != 0)
-    {
-        log_debug("Failed to remove Entry's data directory");
-        return ret;
-    }
-
-    abrt_p2_object_destroy(obj);
-    return 0;
-}
-
 GVariant *abrt_p2_service_entry_problem_data(AbrtP2Service *service,
             const char *entry_path,
             uid_t caller_uid,
@@ -2022,89 +3113,804 @@ GVariant *abrt_p2_service_callers_session(AbrtP2Service *service,
     return g_variant_new("(o)", session_path);
 }
 
+/*
+ * GetProblems options
+ */
+typedef struct
+{
+    bool has_since;
+    guint64 since;
+    bool has_until;
+    guint64 until;
+    const char *type;
+    const char *component;
+    const char *executable;
+    bool not_reported;
+    guint32 offset;
+    guint32 limit;          ///< 0 means no limit
+    int sort;               ///< 0 - unsorted, 1 - oldest first, -1 - newest first
+    GVariant *problems;     ///< 'ao' of the only considered entries or NULL
+} AbrtP2ServiceProblemsFilter;
+
+static bool problems_filter_option_type(const char *key,
+                GVariant *value,
+                const GVariantType *type,
+                GError **error)
+{
+    if (g_variant_is_of_type(value, type))
+        return true;
+
+    g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                "Option '%s' must be of type '%.*s'",
+                key, (int)g_variant_type_get_string_length(type), g_variant_type_peek_string(type));
+    return false;
+}
+
+/* The strings in the filter point to 'options' */
+static int problems_filter_init(AbrtP2ServiceProblemsFilter *filter,
+                GVariant *options,
+                GError **error)
+{
+    memset(filter, 0, sizeof(*filter));
+
+    GVariantIter iter;
+    g_variant_iter_init(&iter, options);
+
+    const char *key;
+    GVariant *value;
+    while (g_variant_iter_loop(&iter, "{&sv}", &key, &value))
+    {
+        if (strcmp(key, "since") == 0 || strcmp(key, "until") == 0)
+        {
+            if (!problems_filter_option_type(key, value, G_VARIANT_TYPE_UINT64, error))
+                goto invalid_option;
+
+            if (key[0] == 's')
+            {
+                filter->has_since = true;
+                filter->since = g_variant_get_uint64(value);
+            }
+            else
+            {
+                filter->has_until = true;
+                filter->until = g_variant_get_uint64(value);
+            }
+        }
+        else if (strcmp(key, "type") == 0
+                 || strcmp(key, "component") == 0
+                 || strcmp(key, "executable") == 0)
+        {
+            if (!problems_filter_option_type(key, value, G_VARIANT_TYPE_STRING, error))
+                goto invalid_option;
+
+            /* The value is owned by the options */
+            const char *str = g_variant_get_string(value, NULL);
+            if (key[0] == 't')
+                filter->type = str;
+            else if (key[0] == 'c')
+                filter->component = str;
+            else
+                filter->executable = str;
+        }
+        else if (strcmp(key, "not_reported") == 0)
+        {
+            if (!problems_filter_option_type(key, value, G_VARIANT_TYPE_BOOLEAN, error))
+                goto invalid_option;
+
+            filter->not_reported = g_variant_get_boolean(value);
+        }
+        else if (strcmp(key, "offset") == 0 || strcmp(key, "limit") == 0)
+        {
+            if (!problems_filter_option_type(key, value, G_VARIANT_TYPE_UINT32, error))
+                goto invalid_option;
+
+            if (key[0] == 'o')
+                filter->offset = g_variant_get_uint32(value);
+            else
+                filter->limit = g_variant_get_uint32(value);
+        }
+        else if (strcmp(key, "problems") == 0)
+        {
+            if (!problems_filter_option_type(key, value, G_VARIANT_TYPE_OBJECT_PATH_ARRAY, error))
+                goto invalid_option;
+
+            if (filter->problems != NULL)
+                g_variant_unref(filter->problems);
+            filter->problems = g_variant_ref(value);
+        }
+        else if (strcmp(key, "sort") == 0)
+        {
+            if (!problems_filter_option_type(key, value, G_VARIANT_TYPE_STRING, error))
+                goto invalid_option;
+
+            const char *order = g_variant_get_string(value, NULL);
+            if (strcmp(order, "time") == 0)
+                filter->sort = 1;
+            else if (strcmp(order, "-time") == 0)
+                filter->sort = -1;
+            else
+            {
+                g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                            "Unsupported sort order '%s'", order);
+                goto invalid_option;
+            }
+        }
+        else
+            /* Clients may pass options of newer versions */
+            log_notice("GetProblems: ignoring unknown option '%s'", key);
+    }
+
+    return 0;
+
+invalid_option:
+    g_variant_unref(value);
+    if (filter->problems != NULL)
+        g_variant_unref(filter->problems);
+    return -EINVAL;
+}
+
+static void problems_filter_destroy(AbrtP2ServiceProblemsFilter *filter)
+{
+    if (filter->problems != NULL)
+        g_variant_unref(filter->problems);
+}
+
+static bool problems_filter_has_conditions(const AbrtP2ServiceProblemsFilter *filter)
+{
+    return filter->has_since || filter->has_until
+        || filter->type || filter->component || filter->executable
+        || filter->not_reported
+        || filter->sort != 0;
+}
+
+static bool problems_filter_matches(const AbrtP2ServiceProblemsFilter *filter,
+                const AbrtP2EntryMetadata *md)
+{
+    if (filter->has_since && (guint64)md->last_occurrence < filter->since)
+        return false;
+
+    if (filter->has_until && (guint64)md->last_occurrence > filter->until)
+        return false;
+
+    if (filter->type && g_strcmp0(filter->type, md->type) != 0)
+        return false;
+
+    if (filter->component && g_strcmp0(filter->component, md->component) != 0)
+        return false;
+
+    if (filter->executable && g_strcmp0(filter->executable, md->executable) != 0)
+        return false;
+
+    if (filter->not_reported && md->reported)
+        return false;
+
+    return true;
+}
+
+typedef struct
+{
+    const char *path;
+    AbrtP2Object *object;
+    AbrtP2Entry *entry;
+    time_t last_occurrence;
+} AbrtP2ServiceProblemsItem;
+
+static gint problems_item_cmp_oldest(gconstpointer a, gconstpointer b)
+{
+    const AbrtP2ServiceProblemsItem *lhs = a;
+    const AbrtP2ServiceProblemsItem *rhs = b;
+
+    if (lhs->last_occurrence != rhs->last_occurrence)
+        return lhs->last_occurrence < rhs->last_occurrence ? -1 : 1;
+
+    /* Stable order for paging */
+    return strcmp(lhs->path, rhs->path);
+}
+
+static gint problems_item_cmp_newest(gconstpointer a, gconstpointer b)
+{
+    return problems_item_cmp_oldest(b, a);
+}
+
+static gint problems_item_cmp_path(gconstpointer a, gconstpointer b)
+{
+    return strcmp(((const AbrtP2ServiceProblemsItem *)a)->path,
+                  ((const AbrtP2ServiceProblemsItem *)b)->path);
+}
+
+/* Returns true if the entry is visible for the caller and passes the filter */
+static bool problems_select_entry(const AbrtP2ServiceProblemsFilter *filter,
+                const char *entry_path,
+                AbrtP2Object *entry_obj,
+                uid_t caller_uid,
+                gint32 flags,
+                AbrtP2ServiceProblemsItem *item)
+{
+    bool singleout = flags == 0;
+
+    AbrtP2Entry *entry = abrt_p2_object_get_node(entry_obj);
+    int state = abrt_p2_entry_state(entry);
+
+    log_debug("Entry: %s", entry_path);
+    if (state == ABRT_P2_ENTRY_STATE_DELETED)
+    {
+        return false;
+    }
+    else if (state == ABRT_P2_ENTRY_STATE_NEW)
+    {
+        if (flags == 0)
+            return false;
+
+        singleout = singleout || (flags & ABRT_P2_SERVICE_GET_PROBLEM_FLAGS_NEW);
+    }
+
+    if (0 != abrt_p2_entry_accessible_by_uid(entry, caller_uid, NULL))
+    {
+        if (flags == 0)
+            return false;
+
+        log_debug("Entry not accessible: %s", entry_path);
+        singleout = singleout || (flags & ABRT_P2_SERVICE_GET_PROBLEM_FLAGS_FOREIGN);
+    }
+
+    if (!singleout)
+        return false;
+
+    item->path = entry_path;
+    item->object = entry_obj;
+    item->entry = entry;
+    item->last_occurrence = 0;
+    if (problems_filter_has_conditions(filter))
+    {
+        entry_object_prepare(abrt_p2_object_service(entry_obj), entry_obj);
+        const AbrtP2EntryMetadata *md = abrt_p2_entry_metadata(entry);
+        if (md == NULL || !problems_filter_matches(filter, md))
+        {
+            log_debug("Entry filtered out: %s", entry_path);
+            return false;
+        }
+
+        item->last_occurrence = md->last_occurrence;
+    }
+
+    log_debug("Adding entry: %s", entry_path);
+    return true;
+}
+
+/* Returns an array of AbrtP2ServiceProblemsItem of the requested page */
+static GArray *abrt_p2_service_select_problems(AbrtP2Service *service,
+                uid_t caller_uid,
+                gint32 flags,
+                const AbrtP2ServiceProblemsFilter *filter,
+                GError **error)
+{
+    GArray *items = g_array_new(FALSE, FALSE, sizeof(AbrtP2ServiceProblemsItem));
+    AbrtP2ServiceProblemsItem item;
+
+    if (filter->problems != NULL)
+    {
+        GVariantIter iter;
+        g_variant_iter_init(&iter, filter->problems);
+
+        const char *entry_path;
+        while (g_variant_iter_next(&iter, "&o", &entry_path))
+        {
+            AbrtP2Object *entry_obj = abrt_p2_service_get_entry_object(service,
+                                                                       entry_path,
+                                                                       ABRT_P2_SERVICE_ENTRY_LOOKUP_NOFLAGS,
+                                                                       error);
+            if (entry_obj == NULL)
+            {
+                g_array_free(items, TRUE);
+                return NULL;
+            }
+
+            /* The path must outlive the filter */
+            if (problems_select_entry(filter, abrt_p2_object_path(entry_obj), entry_obj, caller_uid, flags, &item))
+                g_array_append_val(items, item);
+        }
+    }
+    else
+    {
+        abrt_p2_service_load_entries(service);
+
+        GHashTableIter iter;
+        g_hash_table_iter_init(&iter, service->pv->p2srv_p2_entry_type.objects);
+
+        log_debug("Going through entries");
+        const char *entry_path;
+        AbrtP2Object *entry_obj;
+        while(g_hash_table_iter_next(&iter, (gpointer)&entry_path, (gpointer)&entry_obj))
+        {
+            if (problems_select_entry(filter, entry_path, entry_obj, caller_uid, flags, &item))
+                g_array_append_val(items, item);
+        }
+    }
+
+    /* Pages must not depend on the order of the hash table */
+    if (filter->sort > 0)
+        g_array_sort(items, problems_item_cmp_oldest);
+    else if (filter->sort < 0)
+        g_array_sort(items, problems_item_cmp_newest);
+    else if (filter->offset != 0 || filter->limit != 0)
+        g_array_sort(items, problems_item_cmp_path);
+
+    const guint offset = MIN(filter->offset, items->len);
+    g_array_remove_range(items, 0, offset);
+
+    if (filter->limit != 0 && items->len > filter->limit)
+        g_array_set_size(items, filter->limit);
+
+    return items;
+}
+
 GVariant *abrt_p2_service_get_problems(AbrtP2Service *service,
                 uid_t caller_uid,
                 gint32 flags,
                 GVariant *options,
                 GError **error)
 {
+    AbrtP2ServiceProblemsFilter filter;
+    if (problems_filter_init(&filter, options, error) != 0)
+        return NULL;
+
+    GArray *items = abrt_p2_service_select_problems(service, caller_uid, flags, &filter, error);
+    problems_filter_destroy(&filter);
+    if (items == NULL)
+        return NULL;
+
     GVariantBuilder builder;
     g_variant_builder_init(&builder, G_VARIANT_TYPE("ao"));
 
-    GHashTableIter iter;
-    g_hash_table_iter_init(&iter, service->pv->p2srv_p2_entry_type.objects);
+    for (guint i = 0; i < items->len; ++i)
+        g_variant_builder_add(&builder, "o", g_array_index(items, AbrtP2ServiceProblemsItem, i).path);
 
-    log_debug("Going through entries");
-    const char *entry_path;
-    AbrtP2Object *entry_obj;
-    while(g_hash_table_iter_next(&iter, (gpointer)&entry_path, (gpointer)&entry_obj))
+    g_array_free(items, TRUE);
+
+    GVariant *retval_body[1];
+    retval_body[0] = g_variant_builder_end(&builder);
+    return  g_variant_new_tuple(retval_body, ARRAY_SIZE(retval_body));
+}
+
+/*
+ * GetProblemsSummary
+ */
+#ifndef MFD_CLOEXEC
+# define MFD_CLOEXEC       0x0001U
+#endif
+#ifndef MFD_ALLOW_SEALING
+# define MFD_ALLOW_SEALING 0x0002U
+#endif
+#ifndef F_ADD_SEALS
+# define F_ADD_SEALS       (1024 + 9)
+# define F_SEAL_SEAL       0x0001
+# define F_SEAL_SHRINK     0x0002
+# define F_SEAL_GROW       0x0004
+# define F_SEAL_WRITE      0x0008
+#endif
+
+/* Room for the message header and the rest of the reply */
+#define SUMMARY_MESSAGE_RESERVE 4096
+
+/* Returns a sealed memfd with the data or -1 */
+static int summary_memfd(const void *data, size_t size, GError **error)
+{
+    const int fd = syscall(__NR_memfd_create, "abrt-problems-summary", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0)
     {
-        bool singleout = flags == 0;
+        perror_msg("Failed to create memfd");
+        g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_IO_ERROR,
+                    "The summary is too large and cannot be passed in a file descriptor");
+        return -1;
+    }
 
-        AbrtP2Entry *entry = abrt_p2_object_get_node(entry_obj);
-        int state = abrt_p2_entry_state(entry);
+    if (full_write(fd, data, size) != size
+        || fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0
+        || lseek(fd, 0, SEEK_SET) != 0)
+    {
+        perror_msg("Failed to fill memfd");
+        g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_IO_ERROR,
+                    "Failed to write the summary to a file descriptor");
+        close(fd);
+        return -1;
+    }
 
-        log_debug("Entry: %s", entry_path);
-        if (state == ABRT_P2_ENTRY_STATE_DELETED)
+    return fd;
+}
+
+GVariant *abrt_p2_service_get_problems_summary(AbrtP2Service *service,
+                uid_t caller_uid,
+                gint32 flags,
+                GVariant *options,
+                GVariant *properties,
+                GUnixFDList *out_fd_list,
+                GError **error)
+{
+    AbrtP2ServiceProblemsFilter filter;
+    if (problems_filter_init(&filter, options, error) != 0)
+        return NULL;
+
+    GVariantIter iter;
+    const char *property_name;
+    g_variant_iter_init(&iter, properties);
+    while (g_variant_iter_next(&iter, "&s", &property_name))
+    {
+        if (g_dbus_interface_info_lookup_property(service->pv->p2srv_p2_entry_type.iface, property_name) == NULL)
         {
-            continue;
+            g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                        "Unknown property '%s'", property_name);
+            problems_filter_destroy(&filter);
+            return NULL;
         }
-        else if (state == ABRT_P2_ENTRY_STATE_NEW)
+    }
+
+    GArray *items = abrt_p2_service_select_problems(service, caller_uid, flags, &filter, error);
+    problems_filter_destroy(&filter);
+    if (items == NULL)
+        return NULL;
+
+    GVariantBuilder builder;
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("aa{sv}"));
+
+    for (guint i = 0; i < items->len; ++i)
+    {
+        const AbrtP2ServiceProblemsItem *item = &g_array_index(items, AbrtP2ServiceProblemsItem, i);
+
+        g_variant_builder_open(&builder, G_VARIANT_TYPE("a{sv}"));
+        g_variant_builder_add(&builder, "{sv}", "Entry", g_variant_new_object_path(item->path));
+
+        /* Foreign entries of unauthorized callers have only the path */
+        entry_object_prepare(service, item->object);
+        const AbrtP2EntryMetadata *md = abrt_p2_entry_metadata_for_uid(item->entry,
+                                                                       caller_uid,
+                                                                       NULL);
+        if (md != NULL)
         {
-            if (flags == 0)
-                continue;
+            /* The directory is opened only for properties which are not cached */
+            struct dump_dir *dd = NULL;
+            g_variant_iter_init(&iter, properties);
+            while (g_variant_iter_next(&iter, "&s", &property_name))
+            {
+                GError *local_error = NULL;
+                GVariant *value = NULL;
+                if (abrt_p2_entry_metadata_has_property(property_name))
+                    value = abrt_p2_entry_metadata_property_value(md, property_name, &local_error);
+                else
+                {
+                    if (dd == NULL)
+                        dd = abrt_p2_entry_open_dump_dir(item->entry,
+                                                         caller_uid,
+                                                         DD_DONT_WAIT_FOR_LOCK | DD_OPEN_READONLY,
+                                                         &local_error);
+                    if (dd != NULL)
+                        value = entry_property_value(dd, property_name, &local_error);
+                }
+
+                if (value == NULL)
+                {
+                    log_debug("Skipping property '%s' of '%s': %s",
+                              property_name, item->path, local_error->message);
+                    g_error_free(local_error);
+                    continue;
+                }
 
-            singleout = singleout || (flags & ABRT_P2_SERVICE_GET_PROBLEM_FLAGS_NEW);
+                g_variant_builder_add(&builder, "{sv}", property_name, value);
+            }
+
+            if (dd != NULL)
+                dd_close(dd);
         }
 
-        if (0 != abrt_p2_entry_accessible_by_uid(entry, caller_uid, NULL))
+        g_variant_builder_close(&builder);
+    }
+
+    g_array_free(items, TRUE);
+
+    GVariant *summary = g_variant_ref_sink(g_variant_builder_end(&builder));
+    const gsize summary_size = g_variant_get_size(summary);
+
+    GVariant *retval = NULL;
+    if (summary_size + SUMMARY_MESSAGE_RESERVE <= (gsize)service->pv->p2srv_max_message_size)
+    {
+        retval = g_variant_new("(v)", summary);
+        goto finito;
+    }
+
+    log_debug("Passing %zu bytes of the summary in a memfd", (size_t)summary_size);
+    const int fd = summary_memfd(g_variant_get_data(summary), summary_size, error);
+    if (fd < 0)
+        goto finito;
+
+    const gint pos = g_unix_fd_list_append(out_fd_list, fd, error);
+    close(fd);
+    if (pos < 0)
+        goto finito;
+
+    retval = g_variant_new("(v)", g_variant_new_handle(pos));
+
+finito:
+    g_variant_unref(summary);
+    return retval;
+}
+
+
+/* Drops the directories of a finished task from the deleted directories and
+ * registers the entries again if their directories have not been removed.
+ */
+static gboolean delete_problems_dir_of_task(gpointer key,
+            gpointer value,
+            gpointer user_data)
+{
+    return value == user_data;
+}
+
+static void delete_problems_on_status_changed(AbrtP2Task *task,
+            gint32 status,
+            gpointer user_data)
+{
+    if (   status != ABRT_P2_TASK_STATUS_DONE
+        && status != ABRT_P2_TASK_STATUS_FAILED
+        && status != ABRT_P2_TASK_STATUS_CANCELED)
+        return;
+
+    AbrtP2Service *service = ABRT_P2_SERVICE(user_data);
+    g_signal_handlers_disconnect_by_func(task, delete_problems_on_status_changed, user_data);
+
+    g_hash_table_foreach_remove(service->pv->p2srv_deleted_dirs,
+                                delete_problems_dir_of_task,
+                                task);
+
+    GList *reoccurred = NULL;
+    GList *remaining = abrt_p2_task_delete_problems_remaining_entries(ABRT_P2_TASK_DELETE_PROBLEMS(task),
+                                                                      &reoccurred);
+    for (GList *iter = remaining; iter != NULL; iter = g_list_next(iter))
+    {
+        AbrtP2Entry *entry = ABRT_P2_ENTRY(iter->data);
+        log_notice("Problem directory '%s' has not been deleted",
+                   abrt_p2_entry_problem_id(entry));
+
+        abrt_p2_entry_set_state(entry, ABRT_P2_ENTRY_STATE_COMPLETE);
+
+        GError *error = NULL;
+        AbrtP2Object *obj = abrt_p2_service_register_entry(service, g_object_ref(entry), &error);
+        if (obj == NULL)
         {
-            if (flags == 0)
-                continue;
+            error_msg("Can't register problem entry again: %s", error->message);
+            g_error_free(error);
+            continue;
+        }
+
+        /* The subscribers have been told that the problem was deleted */
+        problems_batch_add(service, obj, PROBLEMS_BATCH_NEW);
 
-            log_debug("Entry not accessible: %s", entry_path);
-            singleout = singleout || (flags & ABRT_P2_SERVICE_GET_PROBLEM_FLAGS_FOREIGN);
+        /* The new occurrence could not be notified while the directory was
+         * being removed */
+        if (g_list_find(reoccurred, entry) != NULL)
+        {
+            abrt_p2_service_notify_entry_object(service, obj, &error);
+            if (error != NULL)
+            {
+                error_msg("Can't notify the new occurrence of '%s': %s",
+                          abrt_p2_entry_problem_id(entry), error->message);
+                g_error_free(error);
+            }
         }
+    }
+
+    g_list_free(reoccurred);
+    g_list_free(remaining);
+}
+
+/* Unregisters the entry and passes its directory to the task */
+static int delete_problems_detach_entry(AbrtP2Service *service,
+            AbrtP2TaskDeleteProblems *task,
+            const char *entry_path,
+            uid_t caller_uid,
+            GError **error)
+{
+    AbrtP2Object *obj = abrt_p2_service_get_entry_object(service,
+                                                         entry_path,
+                                                         ABRT_P2_SERVICE_ENTRY_LOOKUP_NOFLAGS,
+                                                         error);
+    if (obj == NULL)
+    {
+        log_debug("The requested Problem Entry does not exist");
+        return -ENOENT;
+    }
+
+    AbrtP2Entry *entry = ABRT_P2_ENTRY(abrt_p2_object_get_node(obj));
+    if (abrt_p2_entry_state(entry) != ABRT_P2_ENTRY_STATE_COMPLETE)
+    {
+        log_debug("Cannot remove temporary/deleted Problem Entry");
+        return -EINVAL;
+    }
+
+    const int r = abrt_p2_entry_accessible_by_uid(entry, caller_uid, NULL);
+    if (r != 0)
+    {
+        g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_ACCESS_DENIED,
+                    "You are not authorized to delete the problem");
+        return r;
+    }
+
+    abrt_p2_entry_set_state(entry, ABRT_P2_ENTRY_STATE_DELETED);
+    g_hash_table_insert(service->pv->p2srv_deleted_dirs,
+                        xstrdup(abrt_p2_entry_problem_id(entry)),
+                        task);
+
+    abrt_p2_task_delete_problems_add_entry(task, g_object_ref(entry), entry_path);
+
+    problems_batch_add(service, obj, PROBLEMS_BATCH_DELETED);
+    abrt_p2_object_destroy(obj);
+    return 0;
+}
+
+/* Entries are detached in the given order until the first error. The detached
+ * entries must be removed even if this function fails. */
+static AbrtP2TaskDeleteProblems *delete_problems_task_new(AbrtP2Service *service,
+                GVariant *entries,
+                uid_t caller_uid,
+                GError **error)
+{
+    AbrtP2TaskDeleteProblems *task = abrt_p2_task_delete_problems_new(caller_uid);
+
+    g_signal_connect(task,
+                     "status-changed",
+                     G_CALLBACK(delete_problems_on_status_changed),
+                     service);
+
+    GVariantIter *iter;
+    gchar *entry_path;
+    g_variant_get(entries, "ao", &iter);
+    while (g_variant_iter_loop(iter, "o", &entry_path))
+    {
+        log_debug("Deleting Problem Entry: '%s'", entry_path);
+        const int r = delete_problems_detach_entry(service,
+                                                   task,
+                                                   entry_path,
+                                                   caller_uid,
+                                                   error);
 
-        if (singleout)
+        if (r != 0)
         {
-            log_debug("Adding entry: %s", entry_path);
-            g_variant_builder_add(&builder, "o", entry_path);
+            g_free(entry_path);
+            break;
         }
     }
 
+    g_variant_iter_free(iter);
+    return task;
+}
 
-    GVariant *retval_body[1];
-    retval_body[0] = g_variant_builder_end(&builder);
-    return  g_variant_new_tuple(retval_body, ARRAY_SIZE(retval_body));
+struct delete_problems_context
+{
+    GDBusMethodInvocation *invocation;
+    GError *error;              ///< the error which stopped detaching
+};
+
+static void delete_problems_reply(struct delete_problems_context *context,
+            AbrtP2TaskDeleteProblems *task)
+{
+    /* The detached entries precede the entry which stopped detaching */
+    GError *error = abrt_p2_task_delete_problems_first_error(task);
+    if (error == NULL)
+    {
+        error = context->error;
+        context->error = NULL;
+    }
+
+    if (error != NULL)
+    {
+        g_dbus_method_invocation_return_gerror(context->invocation, error);
+        g_error_free(error);
+    }
+    else
+        g_dbus_method_invocation_return_value(context->invocation, NULL);
+
+    if (context->error != NULL)
+        g_error_free(context->error);
+
+    free(context);
+}
+
+static void delete_problems_reply_on_status_changed(AbrtP2Task *task,
+            gint32 status,
+            gpointer user_data)
+{
+    if (   status != ABRT_P2_TASK_STATUS_DONE
+        && status != ABRT_P2_TASK_STATUS_FAILED
+        && status != ABRT_P2_TASK_STATUS_CANCELED)
+        return;
+
+    struct delete_problems_context *context = user_data;
+    g_signal_handlers_disconnect_by_func(task, delete_problems_reply_on_status_changed, user_data);
+
+    if (status != ABRT_P2_TASK_STATUS_DONE && context->error == NULL)
+        g_set_error(&context->error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
+                    "Removing of problems has not finished");
+
+    delete_problems_reply(context, ABRT_P2_TASK_DELETE_PROBLEMS(task));
+}
+
+void abrt_p2_service_delete_problems(AbrtP2Service *service,
+                GVariant *entries,
+                uid_t caller_uid,
+                GDBusMethodInvocation *invocation)
+{
+    struct delete_problems_context *context = xzalloc(sizeof(*context));
+    context->invocation = invocation;
+
+    AbrtP2TaskDeleteProblems *task = delete_problems_task_new(service,
+                                                              entries,
+                                                              caller_uid,
+                                                              &context->error);
+
+    /* The reply is sent when the directories are removed */
+    g_signal_connect(task,
+                     "status-changed",
+                     G_CALLBACK(delete_problems_reply_on_status_changed),
+                     context);
+
+    GError *local_error = NULL;
+    abrt_p2_task_autonomous_run(ABRT_P2_TASK(task), &local_error);
+    if (local_error != NULL)
+    {
+        error_msg("Failed to start removing of problems: %s", local_error->message);
+
+        /* The detached entries return */
+        g_signal_handlers_disconnect_by_func(task, delete_problems_reply_on_status_changed, context);
+        delete_problems_on_status_changed(ABRT_P2_TASK(task), ABRT_P2_TASK_STATUS_FAILED, service);
+
+        if (context->error != NULL)
+            g_error_free(context->error);
+        context->error = local_error;
+
+        delete_problems_reply(context, task);
+        g_object_unref(task);
+    }
 }
 
-
-GVariant *abrt_p2_service_delete_problems(AbrtP2Service *service,
+GVariant *abrt_p2_service_delete_problems_task(AbrtP2Service *service,
+                AbrtP2Object *session_obj,
                 GVariant *entries,
                 uid_t caller_uid,
                 GError **error)
 {
-    GVariantIter *iter;
-    gchar *entry_path;
-    g_variant_get(entries, "ao", &iter);
-    while (g_variant_iter_loop(iter, "o", &entry_path))
+    AbrtP2TaskDeleteProblems *task = delete_problems_task_new(service,
+                                                              entries,
+                                                              caller_uid,
+                                                              error);
+
+    GError *local_error = NULL;
+    AbrtP2Object *obj = NULL;
+    if (*error == NULL)
     {
-        log_debug("Removing Problem Entry: '%s'", entry_path);
-        const int r = abrt_p2_service_remove_problem(service,
-                                                     entry_path,
-                                                     caller_uid,
-                                                     error);
+        obj = task_object_register(service, session_obj, ABRT_P2_TASK(task), error);
+        if (obj == NULL)
+            g_prefix_error(error, "Cannot export DeleteProblems task on D-Bus: ");
+    }
 
-        if (r != 0)
-        {
-            g_free(entry_path);
-            break;
-        }
+    if (obj == NULL)
+    {
+        /* Nobody will watch the task, but the detached entries still wait */
+        abrt_p2_task_autonomous_run(ABRT_P2_TASK(task), &local_error);
+    }
+    else
+    {
+        log_debug("Created task '%p' for session '%s'", task, abrt_p2_object_path(session_obj));
+        abrt_p2_task_start(ABRT_P2_TASK(task), NULL, &local_error);
     }
 
-    g_variant_iter_free(iter);
-    return NULL;
+    if (local_error != NULL)
+    {
+        error_msg("Failed to start removing of problems: %s", local_error->message);
+        g_error_free(local_error);
+    }
+
+    if (obj == NULL)
+        return NULL;
+
+    return g_variant_new("(o)", obj->p2o_path);
 }
 
 /* D-Bus method handler
@@ -2181,6 +3987,33 @@ static void p2_object_dbus_method_call(GDBusConnection *connection,
         g_variant_unref(options_param);
         g_variant_unref(flags_param);
     }
+    else if (strcmp("GetProblemsSummary", method_name) == 0)
+    {
+        GVariant *flags_param = g_variant_get_child_value(parameters, 0);
+        GVariant *options_param = g_variant_get_child_value(parameters, 1);
+        GVariant *properties_param = g_variant_get_child_value(parameters, 2);
+        GUnixFDList *out_fd_list = g_unix_fd_list_new();
+
+        response = abrt_p2_service_get_problems_summary(service,
+                                                        caller_uid,
+                                                        g_variant_get_int32(flags_param),
+                                                        options_param,
+                                                        properties_param,
+                                                        out_fd_list,
+                                                        &error);
+
+        g_variant_unref(properties_param);
+        g_variant_unref(options_param);
+        g_variant_unref(flags_param);
+
+        if (error == NULL)
+            g_dbus_method_invocation_return_value_with_unix_fd_list(invocation, response, out_fd_list);
+
+        g_object_unref(out_fd_list);
+
+        if (error == NULL)
+            return;
+    }
     else if (strcmp("GetProblemData", method_name) == 0)
     {
         /* Parameter tuple is (0) */
@@ -2195,8 +4028,26 @@ static void p2_object_dbus_method_call(GDBusConnection *connection,
     else if (strcmp("DeleteProblems", method_name) == 0)
     {
         GVariant *array = g_variant_get_child_value(parameters, 0);
-        response = abrt_p2_service_delete_problems(service, array, caller_uid, &error);
+        abrt_p2_service_delete_problems(service, array, caller_uid, invocation);
         g_variant_unref(array);
+        return;
+    }
+    else if (strcmp("DeleteProblemsTask", method_name) == 0)
+    {
+        AbrtP2Object *session_obj = abrt_p2_service_get_session_for_caller(service,
+                                                                           caller,
+                                                                           caller_uid,
+                                                                           &error);
+        if (session_obj != NULL)
+        {
+            GVariant *array = g_variant_get_child_value(parameters, 0);
+            response = abrt_p2_service_delete_problems_task(service,
+                                                            session_obj,
+                                                            array,
+                                                            caller_uid,
+                                                            &error);
+            g_variant_unref(array);
+        }
     }
     else
     {
@@ -2231,11 +4082,91 @@ static void abrt_p2_service_private_destroy(AbrtP2ServicePrivate *pv)
         pv->p2srv_connected_users = NULL;
     }
 
+    if (pv->p2srv_p2_entry_type.subtree_regid != 0 && pv->p2srv_dbus != NULL)
+        g_dbus_connection_unregister_subtree(pv->p2srv_dbus, pv->p2srv_p2_entry_type.subtree_regid);
+
+    free(pv->p2srv_entries_snapshot);
+    pv->p2srv_entries_snapshot = NULL;
+
+    if (pv->p2srv_problems_batches != NULL)
+    {
+        g_hash_table_destroy(pv->p2srv_problems_batches);
+        pv->p2srv_problems_batches = NULL;
+    }
+
+    if (pv->p2srv_deleted_dirs != NULL)
+    {
+        /* Running DeleteProblems tasks must not call back the destroyed service */
+        GHashTableIter iter;
+        g_hash_table_iter_init(&iter, pv->p2srv_deleted_dirs);
+
+        AbrtP2Task *task;
+        while (g_hash_table_iter_next(&iter, NULL, (gpointer)&task))
+            g_signal_handlers_disconnect_matched(task,
+                                                 G_SIGNAL_MATCH_FUNC,
+                                                 0,
+                                                 0,
+                                                 NULL,
+                                                 delete_problems_on_status_changed,
+                                                 NULL);
+
+        g_hash_table_destroy(pv->p2srv_deleted_dirs);
+        pv->p2srv_deleted_dirs = NULL;
+    }
+
+    if (pv->p2srv_indexed_entries != NULL)
+    {
+        for (size_t i = 0; i < ENTRY_INDEX_ELEMENTS; ++i)
+            g_hash_table_destroy(pv->p2srv_index[i]);
+
+        g_hash_table_destroy(pv->p2srv_indexed_entries);
+        pv->p2srv_indexed_entries = NULL;
+
+        g_hash_table_destroy(pv->p2srv_unindexed_entries);
+        pv->p2srv_unindexed_entries = NULL;
+    }
+
     problems2_object_type_destroy(&(pv->p2srv_p2_type));
     problems2_object_type_destroy(&(pv->p2srv_p2_session_type));
     problems2_object_type_destroy(&(pv->p2srv_p2_entry_type));
     problems2_object_type_destroy(&(pv->p2srv_p2_task_type));
 
+    if (pv->p2srv_changed_entries_source != 0)
+    {
+        g_source_remove(pv->p2srv_changed_entries_source);
+        pv->p2srv_changed_entries_source = 0;
+    }
+
+    if (pv->p2srv_changed_entries != NULL)
+    {
+        g_hash_table_destroy(pv->p2srv_changed_entries);
+        pv->p2srv_changed_entries = NULL;
+    }
+
+    if (pv->p2srv_watched_entries != NULL)
+    {
+        g_hash_table_destroy(pv->p2srv_watched_entries);
+        pv->p2srv_watched_entries = NULL;
+    }
+
+    if (pv->p2srv_inotify_source != 0)
+    {
+        g_source_remove(pv->p2srv_inotify_source);
+        pv->p2srv_inotify_source = 0;
+    }
+
+    if (pv->p2srv_inotify_channel != NULL)
+    {
+        g_io_channel_unref(pv->p2srv_inotify_channel);
+        pv->p2srv_inotify_channel = NULL;
+    }
+
+    if (pv->p2srv_inotify_fd >= 0)
+    {
+        close(pv->p2srv_inotify_fd);
+        pv->p2srv_inotify_fd = -1;
+    }
+
     if (pv->p2srv_proxy_dbus != NULL)
     {
         g_object_unref(pv->p2srv_proxy_dbus);
@@ -2274,6 +4205,20 @@ static int abrt_p2_service_private_init(AbrtP2ServicePrivate *pv,
     pv->p2srv_limit_new_problem_throttling_magnitude = 4;
     pv->p2srv_limit_new_problems_batch = 10;
 
+    pv->p2srv_watched_entries = g_hash_table_new(g_direct_hash, g_direct_equal);
+    pv->p2srv_changed_entries = g_hash_table_new(g_direct_hash, g_direct_equal);
+    pv->p2srv_problems_batches = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                                       NULL, (GDestroyNotify)problems_batch_free);
+    pv->p2srv_deleted_dirs = g_hash_table_new_full(g_str_hash, g_str_equal, free, NULL);
+
+    for (size_t i = 0; i < ENTRY_INDEX_ELEMENTS; ++i)
+        pv->p2srv_index[i] = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                                   free, (GDestroyNotify)g_sequence_free);
+
+    pv->p2srv_indexed_entries = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                                      NULL, (GDestroyNotify)entry_index_record_free);
+    pv->p2srv_unindexed_entries = g_hash_table_new(g_direct_hash, g_direct_equal);
+
     int r = 0;
     {
         static GDBusInterfaceVTable p2_object_vtable = {
@@ -2414,6 +4359,28 @@ static void abrt_p2_service_class_init(AbrtP2ServiceClass *klass)
 static void abrt_p2_service_init(AbrtP2Service *self)
 {
     self->pv = abrt_p2_service_get_instance_private(self);
+    self->pv->p2srv_inotify_fd = -1;
+}
+
+/* Entries work without inotify too, but their metadata are validated by the
+ * modification time of the problem directories */
+static void abrt_p2_service_init_inotify(AbrtP2Service *service)
+{
+    AbrtP2ServicePrivate *pv = service->pv;
+
+    pv->p2srv_inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (pv->p2srv_inotify_fd < 0)
+    {
+        perror_msg("Can't watch problem directories: inotify_init1 failed");
+        return;
+    }
+
+    pv->p2srv_inotify_channel = abrt_gio_channel_unix_new(pv->p2srv_inotify_fd);
+    g_io_channel_set_buffered(pv->p2srv_inotify_channel, false);
+    pv->p2srv_inotify_source = g_io_add_watch(pv->p2srv_inotify_channel,
+                                              G_IO_IN | G_IO_PRI,
+                                              entry_objects_handle_inotify_cb,
+                                              service);
 }
 
 AbrtP2Service *abrt_p2_service_new(GError **error)
@@ -2426,6 +4393,8 @@ AbrtP2Service *abrt_p2_service_new(GError **error)
         return NULL;
     }
 
+    abrt_p2_service_init_inotify(service);
+
     return service;
 }
 
@@ -2468,11 +4437,345 @@ static int bridge_register_dump_dir_entry_node(struct dump_dir *dd,
             void *call_args)
 {
     struct bridge_call_args *args = call_args;
+
+    /* New problems might have been registered before the others were loaded */
+    if (abrt_p2_service_get_entry_for_problem(args->service,
+                                              dd->dd_dirname,
+                                              ABRT_P2_SERVICE_ENTRY_LOOKUP_OPTIONAL,
+                                              NULL) != NULL)
+        return 0;
+
     return NULL == entry_object_register_dump_dir(args->service,
                                                   dd->dd_dirname,
                                                   args->error);
 }
 
+/*
+ * Snapshot of registered entries
+ *
+ * abrt-dbus exits when it is idle, so the snapshot lets the next instance
+ * register the entries without opening and locking all problem directories.
+ * The snapshot holds owners of the problem directories. An owner is valid as
+ * long as the change time of its directory is the same.
+ */
+#define ENTRIES_SNAPSHOT_MAGIC "abrt-dbus entries 1"
+
+struct entries_snapshot_record
+{
+    uid_t owner;
+    struct timespec ctime;
+};
+
+/* Returns a table of problem directory -> struct entries_snapshot_record */
+static GHashTable *entries_snapshot_load(const char *path)
+{
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL)
+    {
+        log_debug("Can't open '%s': %s", path, strerror(errno));
+        return NULL;
+    }
+
+    GHashTable *records = NULL;
+
+    char *line = xmalloc_fgetline(fp);
+    if (line == NULL || strcmp(line, ENTRIES_SNAPSHOT_MAGIC) != 0)
+    {
+        log_notice("Ignoring '%s': unknown format", path);
+        goto finito;
+    }
+
+    /* The dump location might have been reconfigured */
+    free(line);
+    line = xmalloc_fgetline(fp);
+    if (line == NULL || strcmp(line, g_settings_dump_location) != 0)
+    {
+        log_notice("Ignoring '%s': different dump location", path);
+        goto finito;
+    }
+
+    records = g_hash_table_new_full(g_str_hash, g_str_equal, free, free);
+
+    free(line);
+    while ((line = xmalloc_fgetline(fp)) != NULL)
+    {
+        unsigned long owner;
+        long long sec;
+        long nsec;
+        int dirname_pos = 0;
+        if (sscanf(line, "%lu %lld.%ld %n", &owner, &sec, &nsec, &dirname_pos) != 3
+            || dirname_pos == 0 || line[dirname_pos] == '\0')
+        {
+            log_notice("Ignoring malformed line in '%s': %s", path, line);
+            free(line);
+            continue;
+        }
+
+        struct entries_snapshot_record *record = xmalloc(sizeof(*record));
+        record->owner = (uid_t)owner;
+        record->ctime.tv_sec = (time_t)sec;
+        record->ctime.tv_nsec = nsec;
+        g_hash_table_replace(records, xstrdup(line + dirname_pos), record);
+
+        free(line);
+    }
+
+finito:
+    free(line);
+    fclose(fp);
+    return records;
+}
+
+static int entries_snapshot_register_dir(AbrtP2Service *service,
+            const char *dirname,
+            GHashTable *records,
+            GError **error)
+{
+    struct stat st;
+    if (lstat(dirname, &st) != 0 || !S_ISDIR(st.st_mode))
+        return 0;
+
+    const struct entries_snapshot_record *record = g_hash_table_lookup(records, dirname);
+    if (record == NULL
+        || record->ctime.tv_sec != st.st_ctim.tv_sec
+        || record->ctime.tv_nsec != st.st_ctim.tv_nsec)
+    {
+        /* Unknown or modified problem directory, checked by the standard way */
+        struct dump_dir *dd = dd_opendir(dirname, DD_OPEN_FD_ONLY
+                                                  | DD_FAIL_QUIETLY_ENOENT
+                                                  | DD_FAIL_QUIETLY_EACCES);
+        if (dd == NULL)
+        {
+            VERB2 perror_msg("can't open problem directory '%s'", dirname);
+            return 0;
+        }
+
+        dd = dd_fdopendir(dd, DD_OPEN_READONLY | DD_DONT_WAIT_FOR_LOCK);
+        if (dd == NULL)
+            return 0;
+
+        dd_close(dd);
+        return NULL == entry_object_register_dump_dir(service, dirname, error);
+    }
+
+    AbrtP2Entry *entry = abrt_p2_entry_new(xstrdup(dirname));
+    return NULL == entry_object_register(service, entry, record->owner, &st.st_ctim, error);
+}
+
+/* Registers entries of problem directories in the dump location */
+static int abrt_p2_service_load_entries_snapshot(AbrtP2Service *service,
+            GError **error)
+{
+    GHashTable *records = entries_snapshot_load(service->pv->p2srv_entries_snapshot);
+    if (records == NULL)
+        return -ENOENT;
+
+    DIR *dp = opendir(g_settings_dump_location);
+    if (dp == NULL)
+    {
+        g_hash_table_destroy(records);
+        return 0;
+    }
+
+    int r = 0;
+    struct dirent *dent;
+    while (r == 0 && (dent = readdir(dp)) != NULL)
+    {
+        if (dot_or_dotdot(dent->d_name) || strcmp(dent->d_name, ABRT_TRASH_DIR_NAME) == 0)
+            continue;
+
+        char *dirname = concat_path_file(g_settings_dump_location, dent->d_name);
+
+        char *entry_path = entry_object_dir_name_to_path(dirname);
+        if (problems2_object_type_get_object(&(service->pv->p2srv_p2_entry_type), entry_path) == NULL)
+            r = entries_snapshot_register_dir(service, dirname, records, error);
+
+        free(entry_path);
+        free(dirname);
+    }
+
+    closedir(dp);
+    g_hash_table_destroy(records);
+
+    return r;
+}
+
+int abrt_p2_service_save_entries_snapshot(AbrtP2Service *service)
+{
+    AbrtP2ServicePrivate *pv = service->pv;
+
+    /* Not loaded entries did not change since the last snapshot */
+    if (pv->p2srv_entries_snapshot == NULL || !pv->p2srv_entries_loaded)
+        return 0;
+
+    struct strbuf *snapshot = strbuf_new();
+    strbuf_append_strf(snapshot, "%s\n%s\n", ENTRIES_SNAPSHOT_MAGIC, g_settings_dump_location);
+
+    GHashTableIter iter;
+    AbrtP2Object *obj;
+    g_hash_table_iter_init(&iter, pv->p2srv_p2_entry_type.objects);
+    while (g_hash_table_iter_next(&iter, NULL, (gpointer)&obj))
+    {
+        AbrtP2Entry *entry = abrt_p2_object_get_node(obj);
+        if (abrt_p2_entry_state(entry) != ABRT_P2_ENTRY_STATE_COMPLETE)
+            continue;
+
+        struct timespec ctime;
+        const uid_t owner = abrt_p2_entry_registered_owner(entry, &ctime);
+        const char *dirname = abrt_p2_entry_problem_id(entry);
+        if (owner == (uid_t)-1 || strchr(dirname, '\n') != NULL)
+            continue;
+
+        strbuf_append_strf(snapshot, "%lu %lld.%09ld %s\n",
+                           (unsigned long)owner,
+                           (long long)ctime.tv_sec, (long)ctime.tv_nsec,
+                           dirname);
+    }
+
+    /* Replace the snapshot atomically */
+    int r = 0;
+    char *tmp = xasprintf("%s.%lu.new", pv->p2srv_entries_snapshot, (long)getpid());
+    const int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC, 0600);
+    if (fd < 0)
+    {
+        r = -errno;
+        perror_msg("Can't create '%s'", tmp);
+        goto finito;
+    }
+
+    const bool written = full_write(fd, snapshot->buf, snapshot->len) == snapshot->len;
+    close(fd);
+
+    if (!written || rename(tmp, pv->p2srv_entries_snapshot) != 0)
+    {
+        r = -1;
+        perror_msg("Can't save snapshot of entries '%s'", pv->p2srv_entries_snapshot);
+        unlink(tmp);
+    }
+    else
+        log_debug("Saved snapshot of entries '%s'", pv->p2srv_entries_snapshot);
+
+finito:
+    free(tmp);
+    strbuf_free(snapshot);
+    return r;
+}
+
+void abrt_p2_service_set_entries_snapshot(AbrtP2Service *service,
+            const char *path)
+{
+    free(service->pv->p2srv_entries_snapshot);
+    service->pv->p2srv_entries_snapshot = path != NULL ? xstrdup(path) : NULL;
+}
+
+static void abrt_p2_service_load_entries(AbrtP2Service *service)
+{
+    if (service->pv->p2srv_entries_loaded)
+        return;
+
+    /* Registration of an entry looks up the existing ones */
+    service->pv->p2srv_entries_loaded = true;
+
+    log_debug("Registering entries of problem directories");
+
+    GError *error = NULL;
+    int r = -ENOENT;
+    if (service->pv->p2srv_entries_snapshot != NULL)
+        r = abrt_p2_service_load_entries_snapshot(service, &error);
+
+    if (r == -ENOENT)
+    {
+        struct bridge_call_args args;
+        args.service = service;
+        args.error = &error;
+
+        for_each_problem_in_dir(g_settings_dump_location, (uid_t)-1, bridge_register_dump_dir_entry_node, &args);
+    }
+
+    if (error != NULL)
+    {
+        error_msg("Failed to register Problems objects: %s", error->message);
+        g_error_free(error);
+    }
+}
+
+/*
+ * Entries are dispatched by a subtree, so the objects do not need to be
+ * registered before the name is acquired
+ */
+static gchar **entry_subtree_enumerate(GDBusConnection *connection,
+            const gchar *sender,
+            const gchar *object_path,
+            gpointer user_data)
+{
+    AbrtP2Service *service = ABRT_P2_SERVICE(user_data);
+    abrt_p2_service_load_entries(service);
+
+    GHashTable *objects = service->pv->p2srv_p2_entry_type.objects;
+    gchar **nodes = g_new(gchar *, g_hash_table_size(objects) + 1);
+
+    size_t i = 0;
+    GHashTableIter iter;
+    const char *path;
+    g_hash_table_iter_init(&iter, objects);
+    while (g_hash_table_iter_next(&iter, (gpointer)&path, NULL))
+        nodes[i++] = g_strdup(strrchr(path, '/') + 1);
+
+    nodes[i] = NULL;
+    return nodes;
+}
+
+static AbrtP2Object *entry_subtree_lookup(AbrtP2Service *service,
+            const gchar *object_path,
+            const gchar *node)
+{
+    if (node == NULL)
+        return NULL;
+
+    char *path = xasprintf("%s/%s", object_path, node);
+    AbrtP2Object *obj = abrt_p2_service_get_entry_object(service,
+                                                         path,
+                                                         ABRT_P2_SERVICE_ENTRY_LOOKUP_OPTIONAL,
+                                                         NULL);
+    free(path);
+
+    return obj;
+}
+
+static GDBusInterfaceInfo **entry_subtree_introspect(GDBusConnection *connection,
+            const gchar *sender,
+            const gchar *object_path,
+            const gchar *node,
+            gpointer user_data)
+{
+    AbrtP2Service *service = ABRT_P2_SERVICE(user_data);
+    if (entry_subtree_lookup(service, object_path, node) == NULL)
+        return NULL;
+
+    GDBusInterfaceInfo **interfaces = g_new(GDBusInterfaceInfo *, 2);
+    interfaces[0] = g_dbus_interface_info_ref(service->pv->p2srv_p2_entry_type.iface);
+    interfaces[1] = NULL;
+
+    return interfaces;
+}
+
+static const GDBusInterfaceVTable *entry_subtree_dispatch(GDBusConnection *connection,
+            const gchar *sender,
+            const gchar *object_path,
+            const gchar *interface_name,
+            const gchar *node,
+            gpointer *out_user_data,
+            gpointer user_data)
+{
+    AbrtP2Service *service = ABRT_P2_SERVICE(user_data);
+    AbrtP2Object *obj = entry_subtree_lookup(service, object_path, node);
+    if (obj == NULL)
+        return NULL;
+
+    *out_user_data = obj;
+    return obj->p2o_type->vtable;
+}
+
 static void on_g_signal(GDBusProxy *proxy,
             gchar      *sender_name,
             gchar      *signal_name,
@@ -2558,13 +4861,22 @@ int abrt_p2_service_register_objects(AbrtP2Service *service, GDBusConnection *co
         return -1;
     }
 
-    struct bridge_call_args args;
-    args.service = service;
-    args.error = error;
+    static const GDBusSubtreeVTable entry_subtree_vtable = {
+        .enumerate = entry_subtree_enumerate,
+        .introspect = entry_subtree_introspect,
+        .dispatch = entry_subtree_dispatch,
+    };
 
-    for_each_problem_in_dir(g_settings_dump_location, (uid_t)-1, bridge_register_dump_dir_entry_node, &args);
+    /* Entries are registered on the first access */
+    service->pv->p2srv_p2_entry_type.subtree_regid = g_dbus_connection_register_subtree(connection,
+                                                    ABRT_P2_PATH"/Entry",
+                                                    &entry_subtree_vtable,
+                                                    G_DBUS_SUBTREE_FLAGS_DISPATCH_TO_UNENUMERATED_NODES,
+                                                    service,
+                                                    NULL,
+                                                    error);
 
-    if (*args.error != NULL)
+    if (service->pv->p2srv_p2_entry_type.subtree_regid == 0)
     {
         g_prefix_error(error, "Failed to register Problems objects: ");
         return -1;
@@ -2722,6 +5034,9 @@ int abrt_p2_service_user_can_create_new_problem(AbrtP2Service *service,
     }
 
     const unsigned upl = abrt_p2_service_user_problems_limit(service, uid);
+    if (upl != 0)
+        abrt_p2_service_load_entries(service);
+
     if (upl != 0 && user->problems >= upl)
         return -E2BIG;
 
@@ -57,6 +57,16 @@ int abrt_p2_service_register_objects(AbrtP2Service *service,
             GDBusConnection *connection,
             GError **error);
 
+/*
+ * Entries of problem directories are registered on the first access. The
+ * snapshot file allows the service to register them without opening every
+ * problem directory whose change time is the same as in the snapshot.
+ */
+void abrt_p2_service_set_entries_snapshot(AbrtP2Service *service,
+            const char *path);
+
+int abrt_p2_service_save_entries_snapshot(AbrtP2Service *service);
+
 const char *abrt_p2_service_session_path(AbrtP2Service *service,
             const char *caller,
             GError **error);
@@ -75,15 +85,26 @@ char *abrt_p2_service_save_problem(AbrtP2Service *service,
             uid_t caller_uid,
             GError **error);
 
-int abrt_p2_service_remove_problem(AbrtP2Service *service,
+GVariant *abrt_p2_service_entry_problem_data(AbrtP2Service *service,
             const char *entry_path,
             uid_t caller_uid,
             GError **error);
 
-GVariant *abrt_p2_service_entry_problem_data(AbrtP2Service *service,
-            const char *entry_path,
+/*
+ * Returns a list of problem directories whose element has the value and
+ * whose last occurrence is in the range, ordered by the last occurrence.
+ * Only some elements are indexed (uuid, duphash, executable, component and
+ * type).
+ *
+ * @returns -ENOTSUP if the element is not indexed or the value is empty
+ */
+int abrt_p2_service_find_problems_by_element(AbrtP2Service *service,
             uid_t caller_uid,
-            GError **error);
+            const char *element,
+            const char *value,
+            time_t timestamp_from,
+            time_t timestamp_to,
+            GList **problems);
 
 
 enum {
@@ -96,6 +117,21 @@ AbrtP2Object *abrt_p2_service_get_entry_for_problem(AbrtP2Service *service,
             int flags,
             GError **error);
 
+/*
+ * Stops the removal of a problem directory which abrtd has added a new
+ * occurrence to while the directory was waiting for removal, and registers
+ * its entry again.
+ *
+ * If the directory is being removed right now, the function does not wait
+ * and fails with G_IO_ERROR_PENDING. The entry is registered again and
+ * notified when the removal fails.
+ *
+ * @returns NULL without error if the directory is not being deleted
+ */
+AbrtP2Object *abrt_p2_service_restore_problem(AbrtP2Service *service,
+            const char *problem_id,
+            GError **error);
+
 struct _AbrtP2Entry;
 AbrtP2Object *abrt_p2_service_register_entry(AbrtP2Service *service,
             struct _AbrtP2Entry *entry,
@@ -149,7 +185,36 @@ GVariant *abrt_p2_service_get_problems(AbrtP2Service *service,
             GVariant *options,
             GError **error);
 
-GVariant *abrt_p2_service_delete_problems(AbrtP2Service *service,
+/*
+ * GetProblemsSummary
+ *
+ * Returns (v) where the variant is either the array of summaries or
+ * a handle of a sealed memfd appended to out_fd_list.
+ */
+GVariant *abrt_p2_service_get_problems_summary(AbrtP2Service *service,
+            uid_t caller_uid,
+            gint32 flags,
+            GVariant *options,
+            GVariant *properties,
+            GUnixFDList *out_fd_list,
+            GError **error);
+
+/*
+ * DeleteProblems
+ *
+ * The entries are unregistered immediately and their directories are removed
+ * by a DeleteProblems task running in the background. The method replies to
+ * the invocation when the task finishes, with the first error in the order
+ * of the entries. The task variant exports the task in the caller's session
+ * and returns its path.
+ */
+void abrt_p2_service_delete_problems(AbrtP2Service *service,
+            GVariant *entries,
+            uid_t caller_uid,
+            GDBusMethodInvocation *invocation);
+
+GVariant *abrt_p2_service_delete_problems_task(AbrtP2Service *service,
+            AbrtP2Object *session_obj,
             GVariant *entries,
             uid_t caller_uid,
             GError **error);
@@ -25,6 +25,9 @@ enum {
 
 static guint s_signals[SN_LAST_SIGNAL] = { 0 };
 
+/* Offspring update details from the task thread */
+G_LOCK_DEFINE_STATIC(task_details);
+
 G_DEFINE_TYPE_WITH_PRIVATE(AbrtP2Task, abrt_p2_task, G_TYPE_OBJECT)
 
 static void abrt_p2_task_finalize(GObject *gobject)
@@ -99,13 +102,19 @@ AbrtP2TaskStatus abrt_p2_task_status(AbrtP2Task *task)
 
 GVariant *abrt_p2_task_details(AbrtP2Task *task)
 {
-    return g_variant_ref(task->pv->p2t_details);
+    G_LOCK(task_details);
+    GVariant *details = g_variant_ref(task->pv->p2t_details);
+    G_UNLOCK(task_details);
+
+    return details;
 }
 
 void abrt_p2_task_add_detail(AbrtP2Task *task,
             const char *key,
             GVariant *value)
 {
+    G_LOCK(task_details);
+
     GVariantDict dict;
     g_variant_dict_init(&dict, task->pv->p2t_details);
     g_variant_dict_insert(&dict, key, "v", value);
@@ -114,6 +123,8 @@ void abrt_p2_task_add_detail(AbrtP2Task *task,
         g_variant_unref(task->pv->p2t_details);
 
     task->pv->p2t_details = g_variant_dict_end(&dict);
+
+    G_UNLOCK(task_details);
 }
 
 void abrt_p2_task_set_response(AbrtP2Task *task,
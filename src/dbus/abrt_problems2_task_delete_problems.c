@@ -0,0 +1,346 @@
+/*
+  Copyright (C) 2016  ABRT team
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "abrt_problems2_task_delete_problems.h"
+
+/* Removing of a directory is mostly waiting for the file system, a few
+ * threads are enough to keep it busy */
+#define DELETE_PROBLEMS_MAX_THREADS 4
+
+struct delete_problems_item
+{
+    AbrtP2TaskDeleteProblems *dpi_task;
+    AbrtP2Entry *dpi_entry;
+    char *dpi_path;             ///< path of the unregistered D-Bus object
+    GError *dpi_error;          ///< why the directory has not been removed
+    bool dpi_started;
+    bool dpi_done;
+    bool dpi_removed;
+    bool dpi_kept;              ///< the problem occurred again before the removal started
+    bool dpi_reoccurred;        ///< the problem occurred again in the meantime
+};
+
+typedef struct
+{
+    GPtrArray *p2tdp_items;     ///< struct delete_problems_item
+    uid_t p2tdp_caller_uid;
+
+    /* Progress of the worker threads */
+    GMutex p2tdp_lock;
+    GCond p2tdp_cond;
+    guint p2tdp_processed;
+    guint p2tdp_deleted;
+} AbrtP2TaskDeleteProblemsPrivate;
+
+struct _AbrtP2TaskDeleteProblems
+{
+    AbrtP2Task parent_instance;
+    AbrtP2TaskDeleteProblemsPrivate *pv;
+};
+
+static AbrtP2TaskCode abrt_p2_task_delete_problems_run(AbrtP2Task *task,
+            GError **error);
+
+G_DEFINE_TYPE_WITH_PRIVATE(AbrtP2TaskDeleteProblems, abrt_p2_task_delete_problems, ABRT_TYPE_P2_TASK)
+
+static void delete_problems_item_free(struct delete_problems_item *item)
+{
+    if (item == NULL)
+        return;
+
+    g_object_unref(item->dpi_entry);
+    free(item->dpi_path);
+    if (item->dpi_error != NULL)
+        g_error_free(item->dpi_error);
+    free(item);
+}
+
+static void abrt_p2_task_delete_problems_finalize(GObject *gobject)
+{
+    AbrtP2TaskDeleteProblemsPrivate *pv = abrt_p2_task_delete_problems_get_instance_private(ABRT_P2_TASK_DELETE_PROBLEMS(gobject));
+    g_ptr_array_free(pv->p2tdp_items, TRUE);
+
+    g_mutex_clear(&pv->p2tdp_lock);
+    g_cond_clear(&pv->p2tdp_cond);
+
+    G_OBJECT_CLASS(abrt_p2_task_delete_problems_parent_class)->finalize(gobject);
+}
+
+static void abrt_p2_task_delete_problems_class_init(AbrtP2TaskDeleteProblemsClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+    object_class->finalize = abrt_p2_task_delete_problems_finalize;
+
+    AbrtP2TaskClass *task_class = ABRT_P2_TASK_CLASS(klass);
+    task_class->run = abrt_p2_task_delete_problems_run;
+}
+
+static void abrt_p2_task_delete_problems_init(AbrtP2TaskDeleteProblems *self)
+{
+    self->pv = abrt_p2_task_delete_problems_get_instance_private(self);
+    self->pv->p2tdp_items = g_ptr_array_new_with_free_func((GDestroyNotify)delete_problems_item_free);
+
+    g_mutex_init(&self->pv->p2tdp_lock);
+    g_cond_init(&self->pv->p2tdp_cond);
+}
+
+AbrtP2TaskDeleteProblems *abrt_p2_task_delete_problems_new(uid_t caller_uid)
+{
+    AbrtP2TaskDeleteProblems *task = g_object_new(TYPE_ABRT_P2_TASK_DELETE_PROBLEMS, NULL);
+
+    task->pv->p2tdp_caller_uid = caller_uid;
+
+    return task;
+}
+
+void abrt_p2_task_delete_problems_add_entry(AbrtP2TaskDeleteProblems *task,
+            AbrtP2Entry *entry,
+            const char *entry_path)
+{
+    struct delete_problems_item *item = xzalloc(sizeof(*item));
+    item->dpi_task = task;
+    item->dpi_entry = entry;
+    item->dpi_path = xstrdup(entry_path);
+
+    g_ptr_array_add(task->pv->p2tdp_items, item);
+}
+
+GList *abrt_p2_task_delete_problems_remaining_entries(AbrtP2TaskDeleteProblems *task,
+            GList **reoccurred)
+{
+    GList *remaining = NULL;
+
+    g_mutex_lock(&task->pv->p2tdp_lock);
+    for (guint i = 0; i < task->pv->p2tdp_items->len; ++i)
+    {
+        struct delete_problems_item *item = g_ptr_array_index(task->pv->p2tdp_items, i);
+        if (item->dpi_removed || item->dpi_kept)
+            continue;
+
+        remaining = g_list_prepend(remaining, item->dpi_entry);
+        if (reoccurred != NULL && item->dpi_reoccurred)
+            *reoccurred = g_list_prepend(*reoccurred, item->dpi_entry);
+    }
+    g_mutex_unlock(&task->pv->p2tdp_lock);
+
+    return g_list_reverse(remaining);
+}
+
+AbrtP2TaskDeleteProblemsKeep abrt_p2_task_delete_problems_keep_entry(AbrtP2TaskDeleteProblems *task,
+            const char *problem_id)
+{
+    AbrtP2TaskDeleteProblemsKeep retval = ABRT_P2_TASK_DELETE_PROBLEMS_KEEP_REMOVED;
+
+    g_mutex_lock(&task->pv->p2tdp_lock);
+    for (guint i = 0; i < task->pv->p2tdp_items->len; ++i)
+    {
+        struct delete_problems_item *item = g_ptr_array_index(task->pv->p2tdp_items, i);
+        if (strcmp(abrt_p2_entry_problem_id(item->dpi_entry), problem_id) != 0)
+            continue;
+
+        if (item->dpi_removed)
+            break;
+
+        item->dpi_reoccurred = true;
+
+        /* The directory is being removed right now, the outcome is known
+         * when the task finishes */
+        if (item->dpi_started && !item->dpi_done)
+        {
+            retval = ABRT_P2_TASK_DELETE_PROBLEMS_KEEP_PENDING;
+            break;
+        }
+
+        if (item->dpi_error == NULL)
+            g_set_error(&item->dpi_error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
+                        "The problem has occurred again");
+
+        item->dpi_kept = true;
+        retval = ABRT_P2_TASK_DELETE_PROBLEMS_KEEP_KEPT;
+        break;
+    }
+    g_mutex_unlock(&task->pv->p2tdp_lock);
+
+    return retval;
+}
+
+GError *abrt_p2_task_delete_problems_first_error(AbrtP2TaskDeleteProblems *task)
+{
+    GError *error = NULL;
+
+    g_mutex_lock(&task->pv->p2tdp_lock);
+    for (guint i = 0; i < task->pv->p2tdp_items->len; ++i)
+    {
+        struct delete_problems_item *item = g_ptr_array_index(task->pv->p2tdp_items, i);
+        if (item->dpi_error != NULL)
+        {
+            error = g_error_copy(item->dpi_error);
+            break;
+        }
+    }
+    g_mutex_unlock(&task->pv->p2tdp_lock);
+
+    return error;
+}
+
+/* Runs on the pool shared by all tasks, the item knows its task. The task
+ * waits until all its items are processed, so it outlives the item. */
+static void abrt_p2_task_delete_problems_worker(gpointer data,
+            gpointer user_data)
+{
+    struct delete_problems_item *item = data;
+    AbrtP2TaskDeleteProblems *task = item->dpi_task;
+
+    g_mutex_lock(&task->pv->p2tdp_lock);
+    const bool kept = item->dpi_kept;
+    if (!kept)
+        item->dpi_started = true;
+    g_mutex_unlock(&task->pv->p2tdp_lock);
+
+    GError *error = NULL;
+    int r = 0;
+    if (kept)
+    {
+        log_debug("Task '%p': Keeping problem directory: %s",
+                  task,
+                  abrt_p2_entry_problem_id(item->dpi_entry));
+    }
+    else
+    {
+        log_debug("Task '%p': Removing problem directory: %s",
+                  task,
+                  abrt_p2_entry_problem_id(item->dpi_entry));
+
+        r = abrt_p2_entry_remove_directory(item->dpi_entry,
+                                           task->pv->p2tdp_caller_uid,
+                                           &error);
+        if (r != 0)
+        {
+            if (error == NULL)
+                g_set_error(&error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
+                            "Failed to remove problem data: %s", strerror(-r));
+
+            error_msg("Can't remove problem directory '%s': %s",
+                      abrt_p2_entry_problem_id(item->dpi_entry),
+                      error->message);
+        }
+    }
+
+    g_mutex_lock(&task->pv->p2tdp_lock);
+
+    item->dpi_done = true;
+    if (!kept)
+    {
+        item->dpi_removed = r == 0;
+        item->dpi_error = error;
+    }
+    task->pv->p2tdp_processed++;
+    if (item->dpi_removed)
+        task->pv->p2tdp_deleted++;
+
+    g_cond_broadcast(&task->pv->p2tdp_cond);
+    g_mutex_unlock(&task->pv->p2tdp_lock);
+}
+
+/* Returns the pool of worker threads shared by all tasks, so concurrent
+ * DeleteProblems calls do not start more threads */
+static GThreadPool *abrt_p2_task_delete_problems_pool(GError **error)
+{
+    static GMutex s_pool_lock;
+    static GThreadPool *s_pool;
+
+    g_mutex_lock(&s_pool_lock);
+    if (s_pool == NULL)
+        s_pool = g_thread_pool_new(abrt_p2_task_delete_problems_worker,
+                                   NULL,
+                                   DELETE_PROBLEMS_MAX_THREADS,
+                                   /*exclusive*/FALSE,
+                                   error);
+    GThreadPool *pool = s_pool;
+    g_mutex_unlock(&s_pool_lock);
+
+    return pool;
+}
+
+static AbrtP2TaskCode abrt_p2_task_delete_problems_run(AbrtP2Task *task,
+            GError **error)
+{
+    AbrtP2TaskDeleteProblems *dp = ABRT_P2_TASK_DELETE_PROBLEMS(task);
+    const guint total = dp->pv->p2tdp_items->len;
+
+    abrt_p2_task_add_detail(task, "DeleteProblems.Total", g_variant_new_uint32(total));
+    abrt_p2_task_add_detail(task, "DeleteProblems.Deleted", g_variant_new_uint32(0));
+
+    if (total != 0)
+    {
+        GThreadPool *pool = abrt_p2_task_delete_problems_pool(error);
+        if (pool == NULL)
+        {
+            g_prefix_error(error, "Cannot start removing of problems: ");
+            return ABRT_P2_TASK_CODE_ERROR;
+        }
+
+        for (guint i = 0; i < total; ++i)
+            g_thread_pool_push(pool, g_ptr_array_index(dp->pv->p2tdp_items, i), NULL);
+
+        g_mutex_lock(&dp->pv->p2tdp_lock);
+        while (dp->pv->p2tdp_processed < total)
+        {
+            g_cond_wait(&dp->pv->p2tdp_cond, &dp->pv->p2tdp_lock);
+
+            const guint deleted = dp->pv->p2tdp_deleted;
+            g_mutex_unlock(&dp->pv->p2tdp_lock);
+
+            abrt_p2_task_add_detail(task, "DeleteProblems.Deleted", g_variant_new_uint32(deleted));
+
+            g_mutex_lock(&dp->pv->p2tdp_lock);
+        }
+        g_mutex_unlock(&dp->pv->p2tdp_lock);
+    }
+
+    GVariantBuilder not_deleted;
+    g_variant_builder_init(&not_deleted, G_VARIANT_TYPE("ao"));
+
+    bool partially = false;
+    for (guint i = 0; i < total; ++i)
+    {
+        struct delete_problems_item *item = g_ptr_array_index(dp->pv->p2tdp_items, i);
+        if (item->dpi_removed)
+            continue;
+
+        g_variant_builder_add(&not_deleted, "o", item->dpi_path);
+        partially = true;
+    }
+
+    GVariantDict response;
+    g_variant_dict_init(&response, NULL);
+    g_variant_dict_insert_value(&response,
+                                "DeleteProblems.NotDeleted",
+                                g_variant_builder_end(&not_deleted));
+
+    log_debug("DeleteProblems task '%p' has finished: %u of %u removed",
+              task,
+              dp->pv->p2tdp_deleted,
+              total);
+
+    abrt_p2_task_set_response(task,
+                              g_variant_dict_end(&response));
+
+    return ABRT_P2_TASK_CODE_DONE + (partially ? ABRT_P2_TASK_DELETE_PROBLEMS_PARTIALLY_DELETED
+                                               : ABRT_P2_TASK_DELETE_PROBLEMS_DELETED);
+}
@@ -0,0 +1,95 @@
+/*
+  Copyright (C) 2016  ABRT team
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+  ------------------------------------------------------------------------------
+
+  Definition of a task for removing problem directories.
+
+  Problems2 service unregisters the entries and marks them DELETED before it
+  passes them to the task, so clients do not see the entries any more. The
+  task only removes the problem directories from disk. The directories are
+  removed in parallel on a pool of worker threads shared by all tasks and the
+  number of removed directories is published through the task details
+  'DeleteProblems.Deleted'.
+
+  The removal cannot be canceled because the entries are already gone. Only a
+  directory that receives a new occurrence of the problem before it is removed
+  is kept and registered again by the service. If the directory is being
+  removed at that time, the service registers it again when the task finishes
+  and the removal has failed.
+
+  See abrt_problems2_task.h for more details about Problems2 Tasks.
+*/
+#ifndef ABRT_P2_TASK_DELETE_PROBLEMS_H
+#define ABRT_P2_TASK_DELETE_PROBLEMS_H
+
+#include "abrt_problems2_task.h"
+#include "abrt_problems2_entry.h"
+
+#include <glib-object.h>
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define TYPE_ABRT_P2_TASK_DELETE_PROBLEMS abrt_p2_task_delete_problems_get_type ()
+G_DECLARE_FINAL_TYPE(AbrtP2TaskDeleteProblems, abrt_p2_task_delete_problems, ABRT_P2, TASK_DELETE_PROBLEMS, AbrtP2Task)
+
+typedef enum {
+    ABRT_P2_TASK_DELETE_PROBLEMS_DELETED,
+    ABRT_P2_TASK_DELETE_PROBLEMS_PARTIALLY_DELETED,
+} AbrtP2TaskDeleteProblemsCodes;
+
+typedef enum {
+    ABRT_P2_TASK_DELETE_PROBLEMS_KEEP_REMOVED,  ///< the directory has been removed
+    ABRT_P2_TASK_DELETE_PROBLEMS_KEEP_KEPT,     ///< the directory will not be removed
+    ABRT_P2_TASK_DELETE_PROBLEMS_KEEP_PENDING,  ///< the directory is being removed
+} AbrtP2TaskDeleteProblemsKeep;
+
+AbrtP2TaskDeleteProblems *abrt_p2_task_delete_problems_new(uid_t caller_uid);
+
+/* Takes over the reference to the entry. The entry path is the path of the
+ * unregistered Problems2.Entry object and it is reported back to the caller
+ * if the directory cannot be removed.
+ */
+void abrt_p2_task_delete_problems_add_entry(AbrtP2TaskDeleteProblems *task,
+            AbrtP2Entry *entry,
+            const char *entry_path);
+
+/* Returns a list of entries whose directories have not been removed and
+ * have not been kept. The entries which have occurred again while their
+ * directories were being removed are also prepended to 'reoccurred' if it is
+ * not NULL. The entries belong to the task, free only the lists.
+ */
+GList *abrt_p2_task_delete_problems_remaining_entries(AbrtP2TaskDeleteProblems *task,
+            GList **reoccurred);
+
+/* Stops the removal of the problem directory, because abrtd has added a new
+ * occurrence to it. Never waits; if the directory is being removed right now,
+ * the entry is returned by abrt_p2_task_delete_problems_remaining_entries()
+ * in case the removal fails.
+ */
+AbrtP2TaskDeleteProblemsKeep abrt_p2_task_delete_problems_keep_entry(AbrtP2TaskDeleteProblems *task,
+            const char *problem_id);
+
+/* Returns a copy of the error of the first directory, in the order of
+ * addition, that has not been removed, or NULL.
+ */
+GError *abrt_p2_task_delete_problems_first_error(AbrtP2TaskDeleteProblems *task);
+
+G_END_DECLS
+
+#endif/*ABRT_P2_TASK_DELETE_PROBLEMS_H*/
@@ -206,10 +206,21 @@ static int abrt_p2_task_new_problem_notify_directory_task(AbrtP2TaskNewProblem *
 
         AbrtP2Object *obj = abrt_p2_service_get_entry_for_problem(task->pv->p2tnp_service,
                                                                   message,
-                                                                  ABRT_P2_SERVICE_ENTRY_LOOKUP_NOFLAGS,
+                                                                  ABRT_P2_SERVICE_ENTRY_LOOKUP_OPTIONAL,
                                                                   error);
+
+        /* The duplicate might have been waiting for removal */
+        if (obj == NULL && *error == NULL)
+            obj = abrt_p2_service_restore_problem(task->pv->p2tnp_service,
+                                                  message,
+                                                  error);
+
         if (obj == NULL)
         {
+            if (*error == NULL)
+                g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_BAD_ADDRESS,
+                            "Requested Entry does not exist");
+
             error_msg("Problem Entry for directory '%s' does not exist", message);
             free(message);
             return ABRT_P2_TASK_CODE_ERROR;
@@ -42,6 +42,43 @@ int low_free_space(unsigned setting_MaxCrashReportsSize, const char *dump_locati
 
 #define trim_problem_dirs abrt_trim_problem_dirs
 void trim_problem_dirs(const char *dirname, double cap_size, const char *exclude_path);
+
+/* Hidden directory in a dump location holding dump directories which are
+ * waiting for removal by the trash cleaner */
+#define ABRT_TRASH_DIR_NAME ".trash"
+
+/**
+  @brief Moves the dump directory to the trash of its dump location
+
+  The dump directory is atomically renamed, hence it disappears from the dump
+  location immediately, and the time consuming unlinking of its files is left
+  to empty_trash(). Falls back to dd_delete() if the rename fails.
+
+  @param dd A locked dump directory; the function always closes it
+  @return 0 on success; otherwise non-zero value
+*/
+#define dd_trash abrt_dd_trash
+int dd_trash(struct dump_dir *dd);
+#define trash_dump_dir abrt_trash_dump_dir
+int trash_dump_dir(const char *dump_dir_name);
+#define trash_has_items abrt_trash_has_items
+bool trash_has_items(const char *dump_location);
+#define empty_trash abrt_empty_trash
+void empty_trash(const char *dump_location);
+/**
+  @brief Forks a child process removing the trash with the idle I/O priority
+
+  @return PID of the child or negative number on error
+*/
+#define spawn_trash_cleaner abrt_spawn_trash_cleaner
+pid_t spawn_trash_cleaner(const char *dump_location);
+/**
+  @brief Like libreport's get_dirsize_find_largest_dir() but does not count
+  the trash directory
+*/
+#define dump_location_size_find_largest_dir abrt_dump_location_size_find_largest_dir
+double dump_location_size_find_largest_dir(const char *dump_location, char **worst_dir, const char *excluded);
+
 #define ensure_writable_dir_id abrt_ensure_writable_dir_uid_git
 void ensure_writable_dir_uid_gid(const char *dir, mode_t mode, uid_t uid, gid_t gid);
 #define ensure_writable_dir abrt_ensure_writable_dir
@@ -83,6 +120,22 @@ extern bool          g_settings_shortenedreporting;
 extern bool          g_settings_explorechroots;
 #define g_settings_debug_level abrt_g_settings_debug_level
 extern unsigned int  g_settings_debug_level;
+#define g_settings_retention_size_weight abrt_g_settings_retention_size_weight
+extern unsigned int  g_settings_retention_size_weight;
+#define g_settings_retention_age_weight abrt_g_settings_retention_age_weight
+extern unsigned int  g_settings_retention_age_weight;
+#define g_settings_retention_count_weight abrt_g_settings_retention_count_weight
+extern unsigned int  g_settings_retention_count_weight;
+#define g_settings_retention_reported_weight abrt_g_settings_retention_reported_weight
+extern unsigned int  g_settings_retention_reported_weight;
+#define g_settings_retention_system_weight abrt_g_settings_retention_system_weight
+extern unsigned int  g_settings_retention_system_weight;
+#define g_settings_retention_type_weights abrt_g_settings_retention_type_weights
+extern char *        g_settings_retention_type_weights;
+#define g_settings_retention_type_quotas abrt_g_settings_retention_type_quotas
+extern char *        g_settings_retention_type_quotas;
+#define g_settings_post_create_parallelism abrt_g_settings_post_create_parallelism
+extern unsigned int  g_settings_post_create_parallelism;
 
 
 #define load_abrt_conf abrt_load_abrt_conf
@@ -130,6 +183,69 @@ wait for the reply
 #define notify_new_path_with_response abrt_notify_new_path_with_response
 int notify_new_path_with_response(const char *path, char **message);
 
+/* Socket of the event server ('abrt-handle-event --server') started by abrtd.
+ * See abrt-handle-event.c for the protocol description. */
+#define ABRT_EVENT_SOCKET_FILE VAR_RUN"/abrt/abrt-event.socket"
+/* Environment variable holding PID of abrt-server running the event */
+#define ABRT_SERVER_EVENT_ENV "ABRT_SERVER_PID"
+
+/* Host facts are data describing the host which are the same for all
+ * problems detected until the next boot, kernel update or package
+ * transaction. They are generated once and cached in ABRT_HOST_FACTS_DIR.
+ */
+#define ABRT_HOST_FACTS_DIR VAR_RUN"/abrt/host-facts"
+/* Output of lscpu or /proc/cpuinfo */
+#define HOST_FACT_CPUINFO "cpuinfo"
+
+/**
+  @brief Returns malloced contents of the host fact or NULL on errors
+
+  The cached value is used if it is still valid; otherwise the fact is
+  generated and the cache is updated (if the process has the privileges).
+*/
+#define host_fact_load abrt_host_fact_load
+char *host_fact_load(const char *fact);
+
+/**
+  @brief Saves the host fact as the element 'name' of the dump directory
+
+  @return 0 on success; otherwise non-zero value
+*/
+#define dd_save_host_fact abrt_dd_save_host_fact
+int dd_save_host_fact(struct dump_dir *dd, const char *fact, const char *name);
+
+/**
+  @brief Aho-Corasick automaton searching for many strings in a single pass
+
+  Every added string carries flags which are reported when the string is
+  found, so a single matcher can hold, for example, interesting strings and
+  a blacklist at once.
+*/
+struct abrt_strings_matcher;
+
+#define strings_matcher_new abrt_strings_matcher_new
+struct abrt_strings_matcher *strings_matcher_new(void);
+#define strings_matcher_free abrt_strings_matcher_free
+void strings_matcher_free(struct abrt_strings_matcher *matcher);
+/* Strings can be added only before the matcher is compiled */
+#define strings_matcher_add abrt_strings_matcher_add
+void strings_matcher_add(struct abrt_strings_matcher *matcher, const char *pattern, unsigned flags);
+#define strings_matcher_add_list abrt_strings_matcher_add_list
+void strings_matcher_add_list(struct abrt_strings_matcher *matcher, GList *patterns, unsigned flags);
+#define strings_matcher_compile abrt_strings_matcher_compile
+void strings_matcher_compile(struct abrt_strings_matcher *matcher);
+/**
+  @brief Searches the buffer for the added strings
+
+  @param stop_flags The search stops at the first string with any of these flags
+  @param matched If not NULL, set to the first found string or NULL
+  @return Bitwise OR of flags of all found strings
+*/
+#define strings_matcher_scan abrt_strings_matcher_scan
+unsigned strings_matcher_scan(const struct abrt_strings_matcher *matcher,
+                              const char *buf, size_t len,
+                              unsigned stop_flags, const char **matched);
+
 /* Note: should be public since unit tests need to call it */
 #define koops_extract_version abrt_koops_extract_version
 char *koops_extract_version(const char *line);
@@ -156,6 +272,41 @@ struct abrt_koops_line_info {
     int level;
 };
 
+/*
+ * Streaming oops parser. Lines are pushed one by one and every completed
+ * oops is appended to the list passed along with the line that completed
+ * it. Only the lines of the oops in flight (and a few lines looked ahead)
+ * are kept in memory.
+ */
+struct abrt_koops_parser;
+
+#define koops_parser_new abrt_koops_parser_new
+struct abrt_koops_parser *koops_parser_new(void);
+#define koops_parser_free abrt_koops_parser_free
+void koops_parser_free(struct abrt_koops_parser *parser);
+/* Drops all lines in flight */
+#define koops_parser_reset abrt_koops_parser_reset
+void koops_parser_reset(struct abrt_koops_parser *parser);
+/* Feeds a line stripped of the log level and jiffies; NULL stands for a line
+ * left out which still counts toward the oops length limits */
+#define koops_parser_feed_line abrt_koops_parser_feed_line
+void koops_parser_feed_line(struct abrt_koops_parser *parser, GList **oops_list, const char *line, int level);
+/* Feeds a kernel log line, e.g. "<4>[ 12.345] BUG: ..." */
+#define koops_parser_feed_kernel_line abrt_koops_parser_feed_kernel_line
+void koops_parser_feed_kernel_line(struct abrt_koops_parser *parser, GList **oops_list, const char *line);
+/* Returns the kernel message part of a syslog file or dmesg output line or
+ * NULL if the line is not a kernel message */
+#define koops_syslog_line_kernel_message abrt_koops_syslog_line_kernel_message
+const char *koops_syslog_line_kernel_message(const char *line);
+/* Feeds a line of a syslog file or dmesg output; skips non-kernel lines and
+ * drops all found oopses if the line is abrt's "kernel oopses to Abrt"
+ * marker */
+#define koops_parser_feed_syslog_line abrt_koops_parser_feed_syslog_line
+void koops_parser_feed_syslog_line(struct abrt_koops_parser *parser, GList **oops_list, const char *line);
+/* Analyzes the remaining lines as if the input ended and resets the parser */
+#define koops_parser_finish abrt_koops_parser_finish
+void koops_parser_finish(struct abrt_koops_parser *parser, GList **oops_list);
+
 #define koops_extract_oopses_from_lines abrt_koops_extract_oopses_from_lines
 void koops_extract_oopses_from_lines(GList **oops_list, const struct abrt_koops_line_info *lines_info, int lines_info_size);
 #define koops_extract_oopses abrt_koops_extract_oopses
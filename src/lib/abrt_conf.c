@@ -29,6 +29,14 @@ char *        g_settings_autoreporting_event = NULL;
 bool          g_settings_shortenedreporting = 0;
 bool          g_settings_explorechroots = 0;
 unsigned int  g_settings_debug_level = 0;
+unsigned int  g_settings_retention_size_weight = 1;
+unsigned int  g_settings_retention_age_weight = 1;
+unsigned int  g_settings_retention_count_weight = 0;
+unsigned int  g_settings_retention_reported_weight = 0;
+unsigned int  g_settings_retention_system_weight = 0;
+char *        g_settings_retention_type_weights = NULL;
+char *        g_settings_retention_type_quotas = NULL;
+unsigned int  g_settings_post_create_parallelism = 1;
 
 void free_abrt_conf_data()
 {
@@ -40,6 +48,12 @@ void free_abrt_conf_data()
 
     free(g_settings_autoreporting_event);
     g_settings_autoreporting_event = NULL;
+
+    free(g_settings_retention_type_weights);
+    g_settings_retention_type_weights = NULL;
+
+    free(g_settings_retention_type_quotas);
+    g_settings_retention_type_quotas = NULL;
 }
 
 /* Beware - the function normalizes only slashes - that's the most often
@@ -65,6 +79,22 @@ static char *xstrdup_normalized_path(const char *path)
     return res;
 }
 
+static void parse_unsigned_setting(map_string_t *settings, const char *name, unsigned int *result)
+{
+    const char *value = get_map_string_item_or_NULL(settings, name);
+    if (!value)
+        return;
+
+    char *end;
+    errno = 0;
+    unsigned long ul = strtoul(value, &end, 10);
+    if (errno || end == value || *end != '\0' || ul > INT_MAX)
+        error_msg("Error parsing %s setting: '%s'", name, value);
+    else
+        *result = ul;
+    remove_map_string_item(settings, name);
+}
+
 static void ParseCommon(map_string_t *settings, const char *conf_filename)
 {
     const char *value;
@@ -156,6 +186,30 @@ static void ParseCommon(map_string_t *settings, const char *conf_filename)
         remove_map_string_item(settings, "DebugLevel");
     }
 
+    parse_unsigned_setting(settings, "RetentionSizeWeight", &g_settings_retention_size_weight);
+    parse_unsigned_setting(settings, "RetentionAgeWeight", &g_settings_retention_age_weight);
+    parse_unsigned_setting(settings, "RetentionCountWeight", &g_settings_retention_count_weight);
+    parse_unsigned_setting(settings, "RetentionReportedWeight", &g_settings_retention_reported_weight);
+    parse_unsigned_setting(settings, "RetentionSystemWeight", &g_settings_retention_system_weight);
+
+    value = get_map_string_item_or_NULL(settings, "RetentionTypeWeights");
+    if (value)
+    {
+        g_settings_retention_type_weights = xstrdup(value);
+        remove_map_string_item(settings, "RetentionTypeWeights");
+    }
+
+    value = get_map_string_item_or_NULL(settings, "RetentionTypeQuotas");
+    if (value)
+    {
+        g_settings_retention_type_quotas = xstrdup(value);
+        remove_map_string_item(settings, "RetentionTypeQuotas");
+    }
+
+    parse_unsigned_setting(settings, "PostCreateParallelism", &g_settings_post_create_parallelism);
+    if (g_settings_post_create_parallelism == 0)
+        g_settings_post_create_parallelism = 1;
+
     GHashTableIter iter;
     const char *name;
     /*char *value; - already declared */
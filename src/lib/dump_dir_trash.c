@@ -0,0 +1,283 @@
+/*
+    Copyright (C) 2016  ABRT team
+    Copyright (C) 2016  RedHat Inc
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include <sys/syscall.h>
+#include <sys/resource.h>
+#include "internal_libabrt.h"
+
+/* glibc does not provide any wrapper for ioprio_set(), see
+ * linux/include/linux/ioprio.h */
+#define IOPRIO_CLASS_SHIFT 13
+#define IOPRIO_CLASS_IDLE 3
+#define IOPRIO_WHO_PROCESS 1
+#define IOPRIO_PRIO_VALUE(class, data) (((class) << IOPRIO_CLASS_SHIFT) | (data))
+
+/* Returns malloced path to the trash directory of the dump location where
+ * the dump directory lives */
+static char *trash_dir_for_dump_dir(const char *dump_dir_name)
+{
+    char *location = xstrdup(dump_dir_name);
+    size_t len = strlen(location);
+    /* Trim trailing '/'s, but dont trim name "/" to "" */
+    while (len > 1 && location[len - 1] == '/')
+        location[--len] = '\0';
+
+    char *slash = strrchr(location, '/');
+    if (slash == NULL)
+        strcpy(location, ".");
+    else if (slash == location)
+        slash[1] = '\0';
+    else
+        *slash = '\0';
+
+    char *trash = concat_path_file(location, ABRT_TRASH_DIR_NAME);
+    free(location);
+    return trash;
+}
+
+int dd_trash(struct dump_dir *dd)
+{
+    char *trash = trash_dir_for_dump_dir(dd->dd_dirname);
+    if (mkdir(trash, 0700) != 0 && errno != EEXIST)
+    {
+        perror_msg("Can't create trash directory '%s'", trash);
+        goto delete_now;
+    }
+
+    /* The dump directory must be renamed to a unique name because the same
+     * basename can be trashed again before the trash is emptied. */
+    static unsigned s_trashed_count;
+    const char *base = strrchr(dd->dd_dirname, '/');
+    base = base ? base + 1 : dd->dd_dirname;
+    char *victim = xasprintf("%s/%s.%lu.%lu.%u", trash, base,
+                             (long)getpid(), (long)time(NULL), s_trashed_count++);
+
+    const int r = dd_rename(dd, victim);
+    free(victim);
+    if (r != 0)
+    {
+        error_msg("Can't move '%s' to trash, deleting it now", dd->dd_dirname);
+        goto delete_now;
+    }
+
+    log_debug("Moved '%s' to trash", dd->dd_dirname);
+    free(trash);
+    dd_close(dd);
+    return 0;
+
+ delete_now:
+    free(trash);
+    const int ret = dd_delete(dd);
+    /* dd_delete() leaves the dump directory opened on failure */
+    if (ret != 0)
+        dd_close(dd);
+    return ret;
+}
+
+int trash_dump_dir(const char *dump_dir_name)
+{
+    struct dump_dir *dd = dd_opendir(dump_dir_name, /*flags:*/ 0);
+    if (!dd)
+        return -1;
+
+    return dd_trash(dd);
+}
+
+bool trash_has_items(const char *dump_location)
+{
+    char *trash = concat_path_file(dump_location, ABRT_TRASH_DIR_NAME);
+    DIR *dp = opendir(trash);
+    free(trash);
+    if (dp == NULL)
+        return false;
+
+    bool found = false;
+    struct dirent *dent;
+    while (!found && (dent = readdir(dp)) != NULL)
+        found = !dot_or_dotdot(dent->d_name);
+
+    closedir(dp);
+    return found;
+}
+
+/* Removes the file or the whole directory tree named 'name' in the directory
+ * 'dir_fd'. Does not follow symbolic links. */
+static int remove_tree_at(int dir_fd, const char *name)
+{
+    if (unlinkat(dir_fd, name, /*only files*/0) == 0 || errno == ENOENT)
+        return 0;
+
+    if (errno != EISDIR && errno != EPERM)
+    {
+        perror_msg("Can't remove '%s'", name);
+        return -1;
+    }
+
+    const int fd = openat(dir_fd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0)
+    {
+        perror_msg("Can't open directory '%s'", name);
+        return -1;
+    }
+
+    DIR *dp = fdopendir(fd);
+    if (dp == NULL)
+    {
+        perror_msg("Can't open directory '%s'", name);
+        close(fd);
+        return -1;
+    }
+
+    int r = 0;
+    struct dirent *dent;
+    while ((dent = readdir(dp)) != NULL)
+    {
+        if (dot_or_dotdot(dent->d_name))
+            continue;
+
+        r |= remove_tree_at(fd, dent->d_name);
+    }
+    closedir(dp);
+
+    if (unlinkat(dir_fd, name, AT_REMOVEDIR) != 0 && errno != ENOENT)
+    {
+        perror_msg("Can't remove directory '%s'", name);
+        r = -1;
+    }
+
+    return r;
+}
+
+void empty_trash(const char *dump_location)
+{
+    char *trash = concat_path_file(dump_location, ABRT_TRASH_DIR_NAME);
+    const int fd = open(trash, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0)
+    {
+        if (errno != ENOENT)
+            perror_msg("Can't open trash directory '%s'", trash);
+        free(trash);
+        return;
+    }
+
+    DIR *dp = fdopendir(fd);
+    if (dp == NULL)
+    {
+        perror_msg("Can't open trash directory '%s'", trash);
+        close(fd);
+        free(trash);
+        return;
+    }
+
+    struct dirent *dent;
+    while ((dent = readdir(dp)) != NULL)
+    {
+        if (dot_or_dotdot(dent->d_name))
+            continue;
+
+        log_debug("Removing trashed '%s/%s'", trash, dent->d_name);
+        remove_tree_at(fd, dent->d_name);
+    }
+    closedir(dp);
+    free(trash);
+}
+
+pid_t spawn_trash_cleaner(const char *dump_location)
+{
+    fflush(NULL); /* paranoia */
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        perror_msg("fork");
+        return pid;
+    }
+
+    if (pid == 0)
+    {
+        /* Unlinking of large files can take seconds, do not compete for
+         * disk with processes creating new problem directories. */
+        if (syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPRIO_PRIO_VALUE(IOPRIO_CLASS_IDLE, 0)) != 0)
+            perror_msg("Can't set idle I/O priority");
+        if (setpriority(PRIO_PROCESS, 0, 19) != 0)
+            perror_msg("Can't set nice value");
+
+        empty_trash(dump_location);
+        _exit(0);
+    }
+
+    log_debug("Started trash cleaner (%d) for '%s'", pid, dump_location);
+    return pid;
+}
+
+/* Similar to get_dirsize_find_largest_dir() but ignores the trash directory,
+ * so trashed bytes are considered freed.
+ */
+double dump_location_size_find_largest_dir(const char *dump_location, char **worst_dir, const char *excluded)
+{
+    if (worst_dir)
+        *worst_dir = NULL;
+
+    DIR *dp = opendir(dump_location);
+    if (dp == NULL)
+        return 0;
+
+    const time_t cur_time = time(NULL);
+    double size = 0;
+    double maxsz = 0;
+    struct dirent *dent;
+    while ((dent = readdir(dp)) != NULL)
+    {
+        if (dot_or_dotdot(dent->d_name) || strcmp(dent->d_name, ABRT_TRASH_DIR_NAME) == 0)
+            continue;
+
+        char *dname = concat_path_file(dump_location, dent->d_name);
+        struct stat statbuf;
+        if (lstat(dname, &statbuf) != 0)
+            goto next;
+
+        if (S_ISDIR(statbuf.st_mode))
+        {
+            double sz = get_dirsize(dname);
+            size += sz;
+
+            if (worst_dir && (!excluded || strcmp(excluded, dent->d_name) != 0))
+            {
+                /* Calculate "weighted" size and age
+                 * w = sz_kbytes * age_mins */
+                sz /= 1024;
+                long age = (cur_time - statbuf.st_mtime) / 60;
+                if (age > 1)
+                    sz *= age;
+
+                if (sz > maxsz)
+                {
+                    maxsz = sz;
+                    free(*worst_dir);
+                    *worst_dir = xstrdup(dent->d_name);
+                }
+            }
+        }
+        else
+            size += statbuf.st_size;
+ next:
+        free(dname);
+    }
+    closedir(dp);
+
+    return size;
+}
@@ -68,7 +68,7 @@ void trim_problem_dirs(const char *dirname, double cap_size, const char *exclude
     {
         /* We exclude our own dir from candidates for deletion (3rd param): */
         char *worst_basename = NULL;
-        double cur_size = get_dirsize_find_largest_dir(dirname, &worst_basename, excluded_basename);
+        double cur_size = dump_location_size_find_largest_dir(dirname, &worst_basename, excluded_basename);
         if (cur_size <= cap_size || !worst_basename)
         {
             log_info("cur_size:%.0f cap_size:%.0f, no (more) trimming", cur_size, cap_size);
@@ -79,7 +79,7 @@ void trim_problem_dirs(const char *dirname, double cap_size, const char *exclude
                 dirname, cur_size, cap_size / (1024*1024), worst_basename);
         char *d = concat_path_file(dirname, worst_basename);
         free(worst_basename);
-        delete_dump_dir(d);
+        trash_dump_dir(d);
         free(d);
     }
 }
@@ -0,0 +1,180 @@
+/*
+    Copyright (C) 2016  ABRT team
+    Copyright (C) 2016  RedHat Inc
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include <sys/utsname.h>
+#include "internal_libabrt.h"
+
+/* The cache is valid as long as its key file holds the current key */
+#define HOST_FACTS_KEY_FILE "key"
+
+static char *generate_cpuinfo(void)
+{
+    char *cpuinfo = run_in_shell_and_save_output(0,
+            "command -v lscpu >/dev/null 2>&1 && lscpu", "/", NULL);
+    if (cpuinfo != NULL && cpuinfo[0] != '\0')
+        return cpuinfo;
+
+    free(cpuinfo);
+    return xmalloc_open_read_close("/proc/cpuinfo", /*maxsize:*/ NULL);
+}
+
+static const struct
+{
+    const char *name;
+    char *(*generate)(void);
+} s_host_facts[] = {
+    { HOST_FACT_CPUINFO, generate_cpuinfo },
+};
+
+/* Files whose modification denotes a package transaction */
+static const char *const s_package_db_files[] = {
+    "/var/lib/rpm/Packages",
+    "/var/lib/rpm/rpmdb.sqlite",
+    "/etc/os-release",
+    NULL
+};
+
+static char *host_facts_key(void)
+{
+    struct strbuf *key = strbuf_new();
+
+    char *boot_id = xmalloc_fopen_fgetline_fclose("/proc/sys/kernel/random/boot_id");
+    strbuf_append_strf(key, "boot_id %s\n", boot_id ? boot_id : "");
+    free(boot_id);
+
+    struct utsname uts;
+    if (uname(&uts) == 0)
+        strbuf_append_strf(key, "release %s\n", uts.release);
+
+    for (const char *const *file = s_package_db_files; *file != NULL; ++file)
+    {
+        struct stat st;
+        if (stat(*file, &st) == 0)
+            strbuf_append_strf(key, "%s %lld.%09ld\n", *file,
+                               (long long)st.st_mtim.tv_sec, (long)st.st_mtim.tv_nsec);
+    }
+
+    return strbuf_free_nobuf(key);
+}
+
+/* Replaces the cached file atomically */
+static void host_facts_write_file(const char *name, const char *contents)
+{
+    char *path = concat_path_file(ABRT_HOST_FACTS_DIR, name);
+    char *tmp = xasprintf("%s.%lu.new", path, (long)getpid());
+
+    const int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        log_debug("Can't create '%s': %s", tmp, strerror(errno));
+        goto finito;
+    }
+
+    const size_t len = strlen(contents);
+    const bool written = full_write(fd, contents, len) == len;
+    close(fd);
+
+    if (!written || rename(tmp, path) != 0)
+    {
+        perror_msg("Can't update host fact '%s'", path);
+        unlink(tmp);
+    }
+
+ finito:
+    free(tmp);
+    free(path);
+}
+
+/* Drops the cache if it was created for another key */
+static void host_facts_validate(const char *key)
+{
+    char *key_file = concat_path_file(ABRT_HOST_FACTS_DIR, HOST_FACTS_KEY_FILE);
+    char *cached_key = xmalloc_open_read_close(key_file, /*maxsize:*/ NULL);
+    const bool valid = cached_key != NULL && strcmp(cached_key, key) == 0;
+    free(cached_key);
+
+    if (valid)
+    {
+        free(key_file);
+        return;
+    }
+
+    if (mkdir(ABRT_HOST_FACTS_DIR, 0755) != 0 && errno != EEXIST)
+    {
+        log_debug("Can't create '%s': %s", ABRT_HOST_FACTS_DIR, strerror(errno));
+        free(key_file);
+        return;
+    }
+
+    log_debug("Invalidating host facts");
+
+    /* Remove the key first, so nobody can consider the old facts valid */
+    unlink(key_file);
+    for (size_t i = 0; i < ARRAY_SIZE(s_host_facts); ++i)
+    {
+        char *path = concat_path_file(ABRT_HOST_FACTS_DIR, s_host_facts[i].name);
+        unlink(path);
+        free(path);
+    }
+
+    host_facts_write_file(HOST_FACTS_KEY_FILE, key);
+    free(key_file);
+}
+
+char *host_fact_load(const char *fact)
+{
+    size_t i = 0;
+    while (i < ARRAY_SIZE(s_host_facts) && strcmp(s_host_facts[i].name, fact) != 0)
+        ++i;
+
+    if (i == ARRAY_SIZE(s_host_facts))
+    {
+        error_msg("Unknown host fact '%s'", fact);
+        return NULL;
+    }
+
+    char *key = host_facts_key();
+    host_facts_validate(key);
+    free(key);
+
+    char *path = concat_path_file(ABRT_HOST_FACTS_DIR, fact);
+    char *contents = xmalloc_open_read_close(path, /*maxsize:*/ NULL);
+    free(path);
+    if (contents != NULL)
+        return contents;
+
+    log_debug("Generating host fact '%s'", fact);
+    contents = s_host_facts[i].generate();
+    if (contents != NULL)
+        host_facts_write_file(fact, contents);
+
+    return contents;
+}
+
+int dd_save_host_fact(struct dump_dir *dd, const char *fact, const char *name)
+{
+    /* The element is not hard linked to the cache because dd_chown() and
+     * dd_set_no_owner() change owner of all elements. */
+    char *contents = host_fact_load(fact);
+    if (contents == NULL)
+        return -1;
+
+    dd_save_text(dd, name, contents);
+    free(contents);
+    return 0;
+}
@@ -37,7 +37,8 @@ static void record_oops(GList **oops_list, const struct abrt_koops_line_info* li
 
     len = 2;
     for (q = oopsstart; q <= oopsend; q++)
-        len += strlen(lines_info[q].ptr) + 1;
+        if (lines_info[q].ptr)
+            len += strlen(lines_info[q].ptr) + 1;
 
     /* too short oopses are invalid */
     if (len > SANE_MIN_OOPS_LEN)
@@ -47,6 +48,8 @@ static void record_oops(GList **oops_list, const struct abrt_koops_line_info* li
         char *version = NULL;
         for (q = oopsstart; q <= oopsend; q++)
         {
+            if (!lines_info[q].ptr)
+                continue;
             if (!version)
                 version = koops_extract_version(lines_info[q].ptr);
             if (lines_info[q].ptr[0])
@@ -158,22 +161,38 @@ static const char *const s_koops_suspicious_strings_blacklist[] = {
     NULL
 };
 
-static bool suspicious_line(const char *line)
+enum {
+    KOOPS_SUSPICIOUS   = 1 << 0,
+    KOOPS_BLACKLISTED  = 1 << 1,
+};
+
+static struct abrt_strings_matcher *koops_suspicious_strings_matcher(void)
 {
-    const char *const *str = s_koops_suspicious_strings;
-    for ( ; *str; ++str)
-        if (strstr(line, *str))
-            break;
+    static struct abrt_strings_matcher *s_matcher;
+    if (s_matcher != NULL)
+        return s_matcher;
+
+    s_matcher = strings_matcher_new();
+    for (const char *const *str = s_koops_suspicious_strings; *str; ++str)
+        strings_matcher_add(s_matcher, *str, KOOPS_SUSPICIOUS);
+    for (const char *const *str = s_koops_suspicious_strings_blacklist; *str; ++str)
+        strings_matcher_add(s_matcher, *str, KOOPS_BLACKLISTED);
+    strings_matcher_compile(s_matcher);
+
+    return s_matcher;
+}
 
-    if (!*str)
-        return false;
+static bool suspicious_line(const char *line)
+{
+    const char *matched;
+    const unsigned found = strings_matcher_scan(koops_suspicious_strings_matcher(),
+                                                line, strlen(line),
+                                                /*stop at*/KOOPS_BLACKLISTED, &matched);
 
-    str = s_koops_suspicious_strings_blacklist;
-    for ( ; *str; ++str)
-        if (strstr(line, *str))
-           break;
+    if (found == KOOPS_SUSPICIOUS)
+        log_debug("Suspicious string '%s' found", matched);
 
-    return !*str;
+    return found == KOOPS_SUSPICIOUS;
 }
 
 void koops_print_suspicious_strings(void)
@@ -272,271 +291,382 @@ int koops_line_skip_level(const char **c)
     return linelevel;
 }
 
-void koops_extract_oopses(GList **oops_list, char *buffer, size_t buflen)
-{
-    char *c;
-    int linecount = 0;
-    int lines_info_size = 0;
-    struct abrt_koops_line_info *lines_info = NULL;
+/* The parser looks this many lines ahead for the end-of-trace marker */
+#define KOOPS_LOOKAHEAD_LINES 50
 
-    /* Split buffer into lines */
+struct abrt_koops_parser
+{
+    /* Lines in flight (struct abrt_koops_line_info with malloced ptr), the
+     * first one has the absolute index 'base' */
+    GArray *lines;
+    unsigned long base;
+    /* The absolute index of the next line to analyze */
+    unsigned long next;
+    /* The absolute index of the first line of the current oops or -1 */
+    long oopsstart;
+    int inbacktrace;
+    int prevlevel;
+    /* ARM backtrace regex, match a string similar to r7:df912310 */
+    regex_t arm_regex;
+    int arm_regex_rc;
+};
 
-    if (buflen != 0)
-            buffer[buflen - 1] = '\n';  /* the buffer usually ends with \n, but let's make sure */
-    c = buffer;
-    while (c < buffer + buflen)
-    {
-        char linelevel;
-        char *c9;
-        char *colon;
+struct abrt_koops_parser *koops_parser_new(void)
+{
+    struct abrt_koops_parser *parser = xzalloc(sizeof(*parser));
+    parser->lines = g_array_new(FALSE, FALSE, sizeof(struct abrt_koops_line_info));
+    parser->oopsstart = -1;
+    parser->arm_regex_rc = regcomp(&parser->arm_regex, "r[[:digit:]]{1,}:[a-f[:digit:]]{8}", REG_EXTENDED | REG_NOSUB);
+    return parser;
+}
 
-        linecount++;
-        c9 = (char*)memchr(c, '\n', buffer + buflen - c); /* a \n will always be found */
-        assert(c9);
-        *c9 = '\0'; /* turn the \n into a string termination */
-        if (c9 == c)
-            goto next_line;
-
-        /* Is it a syslog file (/var/log/messages or similar)?
-         * Even though _usually_ it looks like "Nov 19 12:34:38 localhost kernel: xxx",
-         * some users run syslog in non-C locale:
-         * "2010-02-22T09:24:08.156534-08:00 gnu-4 gnome-session[2048]: blah blah"
-         *  ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^ !!!
-         * We detect it by checking for N:NN:NN pattern in first 15 chars
-         * (and this still is not good enough... false positive: "pci 0000:15:00.0: PME# disabled")
-         */
-        colon = strchr(c, ':');
-        if (colon && colon > c && colon < c + 15
-         && isdigit(colon[-1]) /* N:... */
-         && isdigit(colon[1]) /* ...N:NN:... */
-         && isdigit(colon[2])
-         && colon[3] == ':'
-         && isdigit(colon[4]) /* ...N:NN:NN... */
-         && isdigit(colon[5])
-        ) {
-            /* It's syslog file, not a bare dmesg */
+void koops_parser_reset(struct abrt_koops_parser *parser)
+{
+    for (unsigned i = 0; i < parser->lines->len; ++i)
+        free(g_array_index(parser->lines, struct abrt_koops_line_info, i).ptr);
+
+    g_array_set_size(parser->lines, 0);
+    parser->base = 0;
+    parser->next = 0;
+    parser->oopsstart = -1;
+    parser->inbacktrace = 0;
+    parser->prevlevel = 0;
+}
 
-            /* Skip non-kernel lines */
-            char *kernel_str = strstr(c, "kernel: ");
-            if (!kernel_str)
-            {
-                /* if we see our own marker:
-                 * "hostname abrt: Kerneloops: Reported 1 kernel oopses to Abrt"
-                 * we know we submitted everything upto here already */
-                if (strstr(c, "kernel oopses to Abrt"))
-                {
-                    log_debug("Found our marker at line %d", linecount);
-                    free(lines_info);
-                    lines_info = NULL;
-                    lines_info_size = 0;
-                    list_free_with_free(*oops_list);
-                    *oops_list = NULL;
-                }
-                goto next_line;
-            }
-            c = kernel_str + sizeof("kernel: ")-1;
-        }
+void koops_parser_free(struct abrt_koops_parser *parser)
+{
+    if (parser == NULL)
+        return;
+
+    koops_parser_reset(parser);
+    g_array_free(parser->lines, TRUE);
+    if (parser->arm_regex_rc == 0)
+        regfree(&parser->arm_regex);
+    free(parser);
+}
 
-        /* store and remove kernel log level */
-        linelevel = koops_line_skip_level((const char **)&c);
-        koops_line_skip_jiffies((const char **)&c);
+static unsigned long koops_parser_end(const struct abrt_koops_parser *parser)
+{
+    return parser->base + parser->lines->len;
+}
 
-        if ((lines_info_size & 0xfff) == 0)
-        {
-            lines_info = xrealloc(lines_info, (lines_info_size + 0x1000) * sizeof(lines_info[0]));
-        }
-        lines_info[lines_info_size].ptr = c;
-        lines_info[lines_info_size].level = linelevel;
-        lines_info_size++;
-next_line:
-        c = c9 + 1;
-    }
+static const struct abrt_koops_line_info *koops_parser_line(const struct abrt_koops_parser *parser, unsigned long index)
+{
+    return &g_array_index(parser->lines, struct abrt_koops_line_info, index - parser->base);
+}
 
-    koops_extract_oopses_from_lines(oops_list, lines_info, lines_info_size);
-    free(lines_info);
+static void koops_parser_record_oops(struct abrt_koops_parser *parser, GList **oops_list, unsigned long oopsstart, unsigned long oopsend)
+{
+    record_oops(oops_list, (const struct abrt_koops_line_info *)parser->lines->data,
+                oopsstart - parser->base, oopsend - parser->base);
 }
 
-void koops_extract_oopses_from_lines(GList **oops_list, const struct abrt_koops_line_info *lines_info, int lines_info_size)
+/* Forgets the lines which can't be a part of any oops anymore */
+static void koops_parser_drop_lines(struct abrt_koops_parser *parser)
 {
-    /* Analyze lines */
+    const unsigned long keep_from = parser->oopsstart >= 0 ? (unsigned long)parser->oopsstart : parser->next;
+    if (keep_from <= parser->base)
+        return;
 
-    int i;
-    char prevlevel = 0;
-    int oopsstart = -1;
-    int inbacktrace = 0;
-    regex_t arm_regex;
-    int arm_regex_rc = 0;
+    const unsigned count = keep_from - parser->base;
+    for (unsigned i = 0; i < count; ++i)
+        free(g_array_index(parser->lines, struct abrt_koops_line_info, i).ptr);
 
-    /* ARM backtrace regex, match a string similar to r7:df912310 */
-    arm_regex_rc = regcomp(&arm_regex, "r[[:digit:]]{1,}:[a-f[:digit:]]{8}", REG_EXTENDED | REG_NOSUB);
+    g_array_remove_range(parser->lines, 0, count);
+    parser->base = keep_from;
+}
+
+/* Analyzes the line parser->next. All lines up to
+ * parser->next + KOOPS_LOOKAHEAD_LINES - 1 must be available unless the input
+ * has ended.
+ */
+static void koops_parser_step(struct abrt_koops_parser *parser, GList **oops_list)
+{
+    const unsigned long end = koops_parser_end(parser);
+    unsigned long i = parser->next;
+    const char *curline = koops_parser_line(parser, i)->ptr;
 
-    i = 0;
-    while (i < lines_info_size)
+    /* A placeholder of a line not passed to the parser, it only counts
+     * toward the oops length limits below */
+    if (curline == NULL)
     {
-        char *curline = lines_info[i].ptr;
+        parser->next = i + 1;
+        koops_parser_drop_lines(parser);
+        return;
+    }
 
-        if (curline == NULL)
-        {
-            i++;
-            continue;
-        }
-        while (*curline == ' ')
-            curline++;
+    while (*curline == ' ')
+        curline++;
 
-        if (oopsstart < 0)
-        {
-            /* Find start-of-oops markers */
-            if (suspicious_line(curline))
-                oopsstart = i;
+    if (parser->oopsstart < 0)
+    {
+        /* Find start-of-oops markers */
+        if (suspicious_line(curline))
+            parser->oopsstart = i;
 
-            if (oopsstart >= 0)
+        if (parser->oopsstart >= 0)
+        {
+            /* debug information */
+            log_debug("Found oops at line %ld: '%s'", parser->oopsstart, koops_parser_line(parser, parser->oopsstart)->ptr);
+            /* try to find the end marker */
+            unsigned long i2 = i + 1;
+            while (i2 < end && i2 < (i + KOOPS_LOOKAHEAD_LINES))
             {
-                /* debug information */
-                log_debug("Found oops at line %d: '%s'", oopsstart, lines_info[oopsstart].ptr);
-                /* try to find the end marker */
-                int i2 = i + 1;
-                while (i2 < lines_info_size && i2 < (i+50))
+                const char *const line = koops_parser_line(parser, i2)->ptr;
+                if (line && strstr(line, "---[ end trace"))
                 {
-                    if (strstr(lines_info[i2].ptr, "---[ end trace"))
-                    {
-                        inbacktrace = 1;
-                        i = i2;
-                        break;
-                    }
-                    i2++;
+                    parser->inbacktrace = 1;
+                    i = i2;
+                    break;
                 }
+                i2++;
             }
         }
+    }
 
-        /* Are we entering a call trace part? */
-        /* a call trace starts with "Call Trace:" or with the " [<.......>] function+0xFF/0xAA" pattern */
-        if (oopsstart >= 0 && !inbacktrace)
-        {
-            if (strcasestr(curline, "Call Trace:")) /* yes, it must be case-insensitive */
-                inbacktrace = 1;
-            else
-            /* Fatal MCE's have a few lines of useful information between
-             * first "Machine check exception:" line and the final "Kernel panic"
-             * line. Such oops, of course, is only detectable in kdumps (tested)
-             * or possibly pstore-saved logs (I did not try this yet).
-             * In order to capture all these lines, we treat final line
-             * as "backtrace" (which is admittedly a hack):
-             */
-            if (strstr(curline, "Kernel panic - not syncing:") && strcasestr(curline, "Machine check"))
-                inbacktrace = 1;
-            else
-            if (strnlen(curline, 9) > 8
-             && (  (curline[0] == '(' && curline[1] == '[' && curline[2] == '<')
-                || (curline[0] == '[' && curline[1] == '<'))
-             && strstr(curline, ">]")
-             && strstr(curline, "+0x")
-             && strstr(curline, "/0x")
-            ) {
-                inbacktrace = 1;
-            }
+    /* Are we entering a call trace part? */
+    /* a call trace starts with "Call Trace:" or with the " [<.......>] function+0xFF/0xAA" pattern */
+    if (parser->oopsstart >= 0 && !parser->inbacktrace)
+    {
+        if (strcasestr(curline, "Call Trace:")) /* yes, it must be case-insensitive */
+            parser->inbacktrace = 1;
+        else
+        /* Fatal MCE's have a few lines of useful information between
+         * first "Machine check exception:" line and the final "Kernel panic"
+         * line. Such oops, of course, is only detectable in kdumps (tested)
+         * or possibly pstore-saved logs (I did not try this yet).
+         * In order to capture all these lines, we treat final line
+         * as "backtrace" (which is admittedly a hack):
+         */
+        if (strstr(curline, "Kernel panic - not syncing:") && strcasestr(curline, "Machine check"))
+            parser->inbacktrace = 1;
+        else
+        if (strnlen(curline, 9) > 8
+         && (  (curline[0] == '(' && curline[1] == '[' && curline[2] == '<')
+            || (curline[0] == '[' && curline[1] == '<'))
+         && strstr(curline, ">]")
+         && strstr(curline, "+0x")
+         && strstr(curline, "/0x")
+        ) {
+            parser->inbacktrace = 1;
         }
+    }
 
-        /* Are we at the end of an oops? */
-        else if (oopsstart >= 0 && inbacktrace)
+    /* Are we at the end of an oops? */
+    else if (parser->oopsstart >= 0 && parser->inbacktrace)
+    {
+        long oopsend = LONG_MAX;
+
+        /* line needs to start with " [" or have "] [" if it is still a call trace */
+        /* example: "[<ffffffffa006c156>] radeon_get_ring_head+0x16/0x41 [radeon]" */
+        /* example s390: "([<ffffffffa006c156>] 0xdeadbeaf)" */
+        if ((curline[0] != '[' && (curline[0] != '(' || curline[1] != '['))
+         && !strstr(curline, "] [")
+         && !strstr(curline, "--- Exception")
+         && !strstr(curline, "LR =")
+         && !strstr(curline, "<#DF>")
+         && !strstr(curline, "<IRQ>")
+         && !strstr(curline, "<EOI>")
+         && !strstr(curline, "<NMI>")
+         && !strstr(curline, "<<EOE>>")
+         && !strstr(curline, "Comm:")
+         && !strstr(curline, "Hardware name:")
+         && !strstr(curline, "Backtrace:")
+         && strncmp(curline, "Code: ", 6) != 0
+         && strncmp(curline, "RIP ", 4) != 0
+         && strncmp(curline, "RSP ", 4) != 0
+         /* s390 Call Trace ends with 'Last Breaking-Event-Address:'
+          * which is followed by a single frame */
+         && strncmp(curline, "Last Breaking-Event-Address:", strlen("Last Breaking-Event-Address:")) != 0
+         /* ARM dumps registers intertwined with the backtrace */
+         && (parser->arm_regex_rc == 0 ? regexec(&parser->arm_regex, curline, 0, NULL, 0) == REG_NOMATCH : 1)
+        ) {
+            oopsend = i-1; /* not a call trace line */
+        }
+        /* oops lines are always more than 8 chars long */
+        else if (strnlen(curline, 8) < 8)
+            oopsend = i-1;
+        /* single oopses are of the same loglevel */
+        else if (koops_parser_line(parser, i)->level != parser->prevlevel)
+            oopsend = i-1;
+        else if (strstr(curline, "Instruction dump:"))
+            oopsend = i;
+        /* kernel end-of-oops marker (not including marker itself) */
+        else if (strstr(curline, "---[ end trace"))
+            oopsend = i-1;
+        /* if a new oops starts, this one has ended */
+        else if (suspicious_line(curline))
+            oopsend = i-1;
+
+        if (oopsend <= (long)i)
         {
-            int oopsend = INT_MAX;
-
-            /* line needs to start with " [" or have "] [" if it is still a call trace */
-            /* example: "[<ffffffffa006c156>] radeon_get_ring_head+0x16/0x41 [radeon]" */
-            /* example s390: "([<ffffffffa006c156>] 0xdeadbeaf)" */
-            if ((curline[0] != '[' && (curline[0] != '(' || curline[1] != '['))
-             && !strstr(curline, "] [")
-             && !strstr(curline, "--- Exception")
-             && !strstr(curline, "LR =")
-             && !strstr(curline, "<#DF>")
-             && !strstr(curline, "<IRQ>")
-             && !strstr(curline, "<EOI>")
-             && !strstr(curline, "<NMI>")
-             && !strstr(curline, "<<EOE>>")
-             && !strstr(curline, "Comm:")
-             && !strstr(curline, "Hardware name:")
-             && !strstr(curline, "Backtrace:")
-             && strncmp(curline, "Code: ", 6) != 0
-             && strncmp(curline, "RIP ", 4) != 0
-             && strncmp(curline, "RSP ", 4) != 0
-             /* s390 Call Trace ends with 'Last Breaking-Event-Address:'
-              * which is followed by a single frame */
-             && strncmp(curline, "Last Breaking-Event-Address:", strlen("Last Breaking-Event-Address:")) != 0
-             /* ARM dumps registers intertwined with the backtrace */
-             && (arm_regex_rc == 0 ? regexec(&arm_regex, curline, 0, NULL, 0) == REG_NOMATCH : 1)
-            ) {
-                oopsend = i-1; /* not a call trace line */
-            }
-            /* oops lines are always more than 8 chars long */
-            else if (strnlen(curline, 8) < 8)
-                oopsend = i-1;
-            /* single oopses are of the same loglevel */
-            else if (lines_info[i].level != prevlevel)
-                oopsend = i-1;
-            else if (strstr(curline, "Instruction dump:"))
-                oopsend = i;
-            /* kernel end-of-oops marker (not including marker itself) */
-            else if (strstr(curline, "---[ end trace"))
-                oopsend = i-1;
-            /* if a new oops starts, this one has ended */
-            else if (suspicious_line(curline))
-                oopsend = i-1;
-
-            if (oopsend <= i)
-            {
-                log_debug("End of oops at line %d (%d): '%s'", oopsend, i, lines_info[oopsend].ptr);
-                record_oops(oops_list, lines_info, oopsstart, oopsend);
-                oopsstart = -1;
-                inbacktrace = 0;
-            }
+            log_debug("End of oops at line %ld (%lu): '%s'", oopsend, i, koops_parser_line(parser, oopsend)->ptr);
+            koops_parser_record_oops(parser, oops_list, parser->oopsstart, oopsend);
+            parser->oopsstart = -1;
+            parser->inbacktrace = 0;
         }
+    }
 
-        prevlevel = lines_info[i].level;
-        i++;
+    parser->prevlevel = koops_parser_line(parser, i)->level;
+    i++;
+    parser->next = i;
 
-        if (oopsstart >= 0)
+    if (parser->oopsstart >= 0)
+    {
+        /* Do we have a suspiciously long oops? Cancel it.
+         * Bumped from 60 to 80 (see examples/oops_recursive_locking1.test)
+         */
+        if (i - parser->oopsstart > 80)
+        {
+            parser->inbacktrace = 0;
+            parser->oopsstart = -1;
+            log_debug("Dropped oops, too long");
+        }
+        else if (!parser->inbacktrace && i - parser->oopsstart > 40)
         {
-            /* Do we have a suspiciously long oops? Cancel it.
-             * Bumped from 60 to 80 (see examples/oops_recursive_locking1.test)
+            /* Used to drop oopses w/o backtraces, but some of them
+             * (MCEs, for example) don't have backtrace yet we still want to file them.
              */
-            if (i - oopsstart > 80)
-            {
-                inbacktrace = 0;
-                oopsstart = -1;
-                log_debug("Dropped oops, too long");
-                continue;
-            }
-            if (!inbacktrace && i - oopsstart > 40)
-            {
-                /* Used to drop oopses w/o backtraces, but some of them
-                 * (MCEs, for example) don't have backtrace yet we still want to file them.
-                 */
-                log_debug("One-line oops at line %d: '%s'", oopsstart, lines_info[oopsstart].ptr);
-                record_oops(oops_list, lines_info, oopsstart, oopsstart);
-                /*inbacktrace = 0; - already is */
-                oopsstart = -1;
-                continue;
-            }
+            log_debug("One-line oops at line %ld: '%s'", parser->oopsstart, koops_parser_line(parser, parser->oopsstart)->ptr);
+            koops_parser_record_oops(parser, oops_list, parser->oopsstart, parser->oopsstart);
+            /*inbacktrace = 0; - already is */
+            parser->oopsstart = -1;
+        }
+    }
+
+    koops_parser_drop_lines(parser);
+}
+
+void koops_parser_feed_line(struct abrt_koops_parser *parser, GList **oops_list, const char *line, int level)
+{
+    struct abrt_koops_line_info info = {
+        .ptr = line ? xstrdup(line) : NULL,
+        .level = level,
+    };
+    g_array_append_val(parser->lines, info);
+
+    while (parser->next + KOOPS_LOOKAHEAD_LINES <= koops_parser_end(parser))
+        koops_parser_step(parser, oops_list);
+}
+
+void koops_parser_feed_kernel_line(struct abrt_koops_parser *parser, GList **oops_list, const char *line)
+{
+    /* store and remove kernel log level */
+    const int level = koops_line_skip_level(&line);
+    koops_line_skip_jiffies(&line);
+
+    koops_parser_feed_line(parser, oops_list, line, level);
+}
+
+const char *koops_syslog_line_kernel_message(const char *line)
+{
+    /* Is it a syslog file (/var/log/messages or similar)?
+     * Even though _usually_ it looks like "Nov 19 12:34:38 localhost kernel: xxx",
+     * some users run syslog in non-C locale:
+     * "2010-02-22T09:24:08.156534-08:00 gnu-4 gnome-session[2048]: blah blah"
+     *  ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^ !!!
+     * We detect it by checking for N:NN:NN pattern in first 15 chars
+     * (and this still is not good enough... false positive: "pci 0000:15:00.0: PME# disabled")
+     */
+    const char *colon = strchr(line, ':');
+    if (colon && colon > line && colon < line + 15
+     && isdigit(colon[-1]) /* N:... */
+     && isdigit(colon[1]) /* ...N:NN:... */
+     && isdigit(colon[2])
+     && colon[3] == ':'
+     && isdigit(colon[4]) /* ...N:NN:NN... */
+     && isdigit(colon[5])
+    ) {
+        /* It's syslog file, not a bare dmesg */
+
+        /* Skip non-kernel lines */
+        const char *kernel_str = strstr(line, "kernel: ");
+        if (!kernel_str)
+            return NULL;
+
+        line = kernel_str + sizeof("kernel: ")-1;
+    }
+
+    return line;
+}
+
+void koops_parser_feed_syslog_line(struct abrt_koops_parser *parser, GList **oops_list, const char *line)
+{
+    const char *msg = koops_syslog_line_kernel_message(line);
+    if (msg == NULL)
+    {
+        /* if we see our own marker:
+         * "hostname abrt: Kerneloops: Reported 1 kernel oopses to Abrt"
+         * we know we submitted everything upto here already */
+        if (strstr(line, "kernel oopses to Abrt"))
+        {
+            log_debug("Found our marker at line %lu", koops_parser_end(parser));
+            koops_parser_reset(parser);
+            list_free_with_free(*oops_list);
+            *oops_list = NULL;
         }
-    } /* while (i < lines_info_size) */
+        return;
+    }
 
-    regfree(&arm_regex);
+    koops_parser_feed_kernel_line(parser, oops_list, msg);
+}
+
+void koops_parser_finish(struct abrt_koops_parser *parser, GList **oops_list)
+{
+    while (parser->next < koops_parser_end(parser))
+        koops_parser_step(parser, oops_list);
 
     /* process last oops if we have one */
-    if (oopsstart >= 0)
+    if (parser->oopsstart >= 0)
     {
-        if (inbacktrace)
+        if (parser->inbacktrace)
         {
-            int oopsend = i-1;
-            log_debug("End of oops at line %d (end of file): '%s'", oopsend, lines_info[oopsend].ptr);
-            record_oops(oops_list, lines_info, oopsstart, oopsend);
+            const unsigned long oopsend = parser->next - 1;
+            log_debug("End of oops at line %lu (end of file): '%s'", oopsend, koops_parser_line(parser, oopsend)->ptr);
+            koops_parser_record_oops(parser, oops_list, parser->oopsstart, oopsend);
         }
         else
         {
-            log_debug("One-line oops at line %d: '%s'", oopsstart, lines_info[oopsstart].ptr);
-            record_oops(oops_list, lines_info, oopsstart, oopsstart);
+            log_debug("One-line oops at line %ld: '%s'", parser->oopsstart, koops_parser_line(parser, parser->oopsstart)->ptr);
+            koops_parser_record_oops(parser, oops_list, parser->oopsstart, parser->oopsstart);
         }
     }
+
+    koops_parser_reset(parser);
+}
+
+void koops_extract_oopses(GList **oops_list, char *buffer, size_t buflen)
+{
+    struct abrt_koops_parser *parser = koops_parser_new();
+
+    /* Split buffer into lines */
+
+    if (buflen != 0)
+            buffer[buflen - 1] = '\n';  /* the buffer usually ends with \n, but let's make sure */
+    char *c = buffer;
+    while (c < buffer + buflen)
+    {
+        char *c9 = (char*)memchr(c, '\n', buffer + buflen - c); /* a \n will always be found */
+        assert(c9);
+        *c9 = '\0'; /* turn the \n into a string termination */
+        if (c9 != c)
+            koops_parser_feed_syslog_line(parser, oops_list, c);
+        c = c9 + 1;
+    }
+
+    koops_parser_finish(parser, oops_list);
+    koops_parser_free(parser);
+}
+
+void koops_extract_oopses_from_lines(GList **oops_list, const struct abrt_koops_line_info *lines_info, int lines_info_size)
+{
+    struct abrt_koops_parser *parser = koops_parser_new();
+
+    for (int i = 0; i < lines_info_size; ++i)
+        koops_parser_feed_line(parser, oops_list, lines_info[i].ptr, lines_info[i].level);
+
+    koops_parser_finish(parser, oops_list);
+    koops_parser_free(parser);
 }
 
 int koops_hash_str_ext(char result[SHA1_RESULT_LEN*2 + 1], const char *oops_buf, int frame_count, int duphash_flags)
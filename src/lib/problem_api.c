@@ -45,6 +45,9 @@ int for_each_problem_in_dir(const char *path,
         if (dot_or_dotdot(dent->d_name))
             continue; /* skip "." and ".." */
 
+        if (strcmp(dent->d_name, ABRT_TRASH_DIR_NAME) == 0)
+            continue; /* skip dump directories waiting for removal */
+
         char *full_name = concat_path_file(path, dent->d_name);
 
         struct dump_dir *dd = dd_opendir(full_name,   DD_OPEN_FD_ONLY
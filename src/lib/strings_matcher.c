@@ -0,0 +1,273 @@
+/*
+    Copyright (C) 2016  ABRT team
+    Copyright (C) 2016  RedHat Inc
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include "internal_libabrt.h"
+
+/* Aho-Corasick automaton.
+ *
+ * The trie nodes are stored in an array, the node 0 is the root. The root has
+ * a transition for every byte, so the failure links never lead above it. The
+ * other nodes keep their transitions in a sorted array because most of them
+ * have only one child.
+ */
+
+#define ROOT_NODE 0
+#define NO_PATTERN ((unsigned)-1)
+
+struct matcher_edge
+{
+    unsigned char byte;
+    unsigned target;
+};
+
+struct matcher_node
+{
+    GArray *edges;          ///< struct matcher_edge sorted by byte
+    unsigned fail;          ///< the longest proper suffix which is in the trie
+    unsigned pattern;       ///< the longest pattern ending in this node
+    unsigned flags;         ///< flags of all patterns ending in this node
+};
+
+struct abrt_strings_matcher
+{
+    GArray *nodes;          ///< struct matcher_node
+    GPtrArray *patterns;    ///< the added strings
+    GArray *pattern_flags;  ///< unsigned
+    unsigned root_next[256];
+    bool compiled;
+};
+
+static unsigned matcher_new_node(struct abrt_strings_matcher *matcher)
+{
+    struct matcher_node node = {
+        .edges = NULL,
+        .fail = ROOT_NODE,
+        .pattern = NO_PATTERN,
+        .flags = 0,
+    };
+    g_array_append_val(matcher->nodes, node);
+    return matcher->nodes->len - 1;
+}
+
+static struct matcher_node *matcher_node(const struct abrt_strings_matcher *matcher, unsigned index)
+{
+    return &g_array_index(matcher->nodes, struct matcher_node, index);
+}
+
+/* Returns the child of 'node' for 'byte' or ROOT_NODE if there is none */
+static unsigned matcher_node_child(const struct matcher_node *node, unsigned char byte)
+{
+    if (node->edges == NULL)
+        return ROOT_NODE;
+
+    unsigned lo = 0;
+    unsigned hi = node->edges->len;
+    while (lo < hi)
+    {
+        const unsigned mid = (lo + hi) / 2;
+        const struct matcher_edge *edge = &g_array_index(node->edges, struct matcher_edge, mid);
+        if (edge->byte == byte)
+            return edge->target;
+        if (edge->byte < byte)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return ROOT_NODE;
+}
+
+static void matcher_node_add_child(struct matcher_node *node, unsigned char byte, unsigned target)
+{
+    if (node->edges == NULL)
+        node->edges = g_array_new(FALSE, FALSE, sizeof(struct matcher_edge));
+
+    unsigned pos = 0;
+    while (pos < node->edges->len
+           && g_array_index(node->edges, struct matcher_edge, pos).byte < byte)
+        ++pos;
+
+    struct matcher_edge edge = { .byte = byte, .target = target };
+    g_array_insert_val(node->edges, pos, edge);
+}
+
+struct abrt_strings_matcher *strings_matcher_new(void)
+{
+    struct abrt_strings_matcher *matcher = xzalloc(sizeof(*matcher));
+    matcher->nodes = g_array_new(FALSE, FALSE, sizeof(struct matcher_node));
+    matcher->patterns = g_ptr_array_new_with_free_func(free);
+    matcher->pattern_flags = g_array_new(FALSE, FALSE, sizeof(unsigned));
+    matcher_new_node(matcher);
+    return matcher;
+}
+
+void strings_matcher_free(struct abrt_strings_matcher *matcher)
+{
+    if (matcher == NULL)
+        return;
+
+    for (unsigned i = 0; i < matcher->nodes->len; ++i)
+    {
+        struct matcher_node *node = matcher_node(matcher, i);
+        if (node->edges != NULL)
+            g_array_free(node->edges, TRUE);
+    }
+    g_array_free(matcher->nodes, TRUE);
+    g_ptr_array_free(matcher->patterns, TRUE);
+    g_array_free(matcher->pattern_flags, TRUE);
+    free(matcher);
+}
+
+void strings_matcher_add(struct abrt_strings_matcher *matcher, const char *pattern, unsigned flags)
+{
+    if (matcher->compiled)
+        error_msg_and_die("Can't add '%s' to a compiled matcher", pattern);
+
+    if (pattern[0] == '\0')
+    {
+        log_debug("Ignoring an empty pattern");
+        return;
+    }
+
+    unsigned cur = ROOT_NODE;
+    for (const unsigned char *c = (const unsigned char *)pattern; *c != '\0'; ++c)
+    {
+        unsigned next = matcher_node_child(matcher_node(matcher, cur), *c);
+        if (next == ROOT_NODE)
+        {
+            next = matcher_new_node(matcher);
+            /* matcher_new_node() might have moved the nodes */
+            matcher_node_add_child(matcher_node(matcher, cur), *c, next);
+        }
+        cur = next;
+    }
+
+    struct matcher_node *node = matcher_node(matcher, cur);
+    node->flags |= flags;
+    if (node->pattern == NO_PATTERN)
+    {
+        node->pattern = matcher->patterns->len;
+        g_ptr_array_add(matcher->patterns, xstrdup(pattern));
+        g_array_append_val(matcher->pattern_flags, flags);
+    }
+    else
+        g_array_index(matcher->pattern_flags, unsigned, node->pattern) |= flags;
+}
+
+void strings_matcher_add_list(struct abrt_strings_matcher *matcher, GList *patterns, unsigned flags)
+{
+    for (GList *iter = patterns; iter != NULL; iter = g_list_next(iter))
+        strings_matcher_add(matcher, (const char *)iter->data, flags);
+}
+
+void strings_matcher_compile(struct abrt_strings_matcher *matcher)
+{
+    if (matcher->compiled)
+        return;
+
+    struct matcher_node *root = matcher_node(matcher, ROOT_NODE);
+    for (unsigned b = 0; b < 256; ++b)
+        matcher->root_next[b] = matcher_node_child(root, (unsigned char)b);
+
+    /* Breadth-first traversal guarantees that the failure link of a node
+     * is computed before the node's children are visited */
+    GQueue queue = G_QUEUE_INIT;
+    if (root->edges != NULL)
+        for (unsigned i = 0; i < root->edges->len; ++i)
+            g_queue_push_tail(&queue, GUINT_TO_POINTER(g_array_index(root->edges, struct matcher_edge, i).target));
+
+    while (!g_queue_is_empty(&queue))
+    {
+        const unsigned index = GPOINTER_TO_UINT(g_queue_pop_head(&queue));
+        struct matcher_node *node = matcher_node(matcher, index);
+
+        if (node->edges == NULL)
+            continue;
+
+        for (unsigned i = 0; i < node->edges->len; ++i)
+        {
+            const struct matcher_edge *edge = &g_array_index(node->edges, struct matcher_edge, i);
+            struct matcher_node *child = matcher_node(matcher, edge->target);
+
+            unsigned fail = node->fail;
+            unsigned next;
+            while ((next = (fail == ROOT_NODE
+                            ? matcher->root_next[edge->byte]
+                            : matcher_node_child(matcher_node(matcher, fail), edge->byte))) == ROOT_NODE
+                   && fail != ROOT_NODE)
+            {
+                fail = matcher_node(matcher, fail)->fail;
+            }
+
+            child->fail = next;
+
+            /* Patterns ending in the suffix end here too */
+            const struct matcher_node *fail_node = matcher_node(matcher, next);
+            child->flags |= fail_node->flags;
+            if (child->pattern == NO_PATTERN)
+                child->pattern = fail_node->pattern;
+
+            g_queue_push_tail(&queue, GUINT_TO_POINTER(edge->target));
+        }
+    }
+
+    matcher->compiled = true;
+}
+
+unsigned strings_matcher_scan(const struct abrt_strings_matcher *matcher,
+                              const char *buf, size_t len,
+                              unsigned stop_flags, const char **matched)
+{
+    if (!matcher->compiled)
+        error_msg_and_die("The strings matcher is not compiled");
+
+    if (matched != NULL)
+        *matched = NULL;
+
+    unsigned flags = 0;
+    unsigned state = ROOT_NODE;
+    const unsigned char *c = (const unsigned char *)buf;
+    const unsigned char *const end = c + len;
+    for (; c < end; ++c)
+    {
+        unsigned next;
+        while (state != ROOT_NODE
+               && (next = matcher_node_child(matcher_node(matcher, state), *c)) == ROOT_NODE)
+        {
+            state = matcher_node(matcher, state)->fail;
+        }
+
+        if (state == ROOT_NODE)
+            next = matcher->root_next[*c];
+
+        state = next;
+
+        const struct matcher_node *node = matcher_node(matcher, state);
+        if (node->pattern == NO_PATTERN)
+            continue;
+
+        if (matched != NULL && *matched == NULL)
+            *matched = g_ptr_array_index(matcher->patterns, node->pattern);
+
+        flags |= node->flags;
+        if (flags & stop_flags)
+            break;
+    }
+
+    return flags;
+}
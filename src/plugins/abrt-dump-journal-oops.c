@@ -18,9 +18,6 @@
 
 #define ABRT_JOURNAL_WATCH_STATE_FILE VAR_STATE"/abrt-dump-journal-oops.state"
 
-/* Limit number of buffered lines */
-#define ABRT_JOURNAL_MAX_READ_LINES (1024 * 1024)
-
 #define ABRT_JOURNAL_KOOPS_ANALYZER "abrt-journal-koops"
 
 /*
@@ -29,9 +26,9 @@
 
 static GList* abrt_journal_extract_kernel_oops(abrt_journal_t *journal)
 {
-    size_t lines_info_count = 0;
-    size_t lines_info_size = 32;
-    struct abrt_koops_line_info *lines_info = xmalloc(lines_info_size * sizeof(lines_info[0]));
+    /* Only lines of an oops in flight are kept in memory */
+    struct abrt_koops_parser *parser = koops_parser_new();
+    GList *oops_list = NULL;
 
     do
     {
@@ -39,35 +36,16 @@ static GList* abrt_journal_extract_kernel_oops(abrt_journal_t *journal)
         if (line == NULL)
             error_msg_and_die(_("Cannot read journal data."));
 
-        if (lines_info_count == lines_info_size)
-        {
-            lines_info_size *= 2;
-            lines_info = xrealloc(lines_info, lines_info_size * sizeof(lines_info[0]));
-        }
-
-        char *orig_line = line;
-        lines_info[lines_info_count].level = koops_line_skip_level((const char **)&line);
-        koops_line_skip_jiffies((const char **)&line);
-
-        memmove(orig_line, line, strlen(line) + 1);
-
-        lines_info[lines_info_count].ptr = orig_line;
-
-        ++lines_info_count;
+        koops_parser_feed_kernel_line(parser, &oops_list, line);
+        free(line);
     }
-    while (lines_info_count < ABRT_JOURNAL_MAX_READ_LINES
-            && abrt_journal_next(journal) > 0);
+    while (abrt_journal_next(journal) > 0);
 
-    GList *oops_list = NULL;
-    koops_extract_oopses_from_lines(&oops_list, lines_info, lines_info_count);
+    koops_parser_finish(parser, &oops_list);
+    koops_parser_free(parser);
 
     log_debug("Extracted: %d oopses", g_list_length(oops_list));
 
-    for (size_t i = 0; i < lines_info_count; ++i)
-        free(lines_info[i].ptr);
-
-    free(lines_info);
-
     return oops_list;
 }
 
@@ -118,36 +96,7 @@ static void abrt_journal_watch_extract_kernel_oops(abrt_journal_watch_t *watch,
 
 static void watch_journald(abrt_journal_t *journal, const char *dump_location, int flags)
 {
-    GList *koops_strings = koops_suspicious_strings_list();
-
-    char *oops_string_filter_regex = abrt_oops_string_filter_regex();
-    if (oops_string_filter_regex)
-    {
-        regex_t filter_re;
-        if (regcomp(&filter_re, oops_string_filter_regex, REG_NOSUB) != 0)
-            perror_msg_and_die(_("Failed to compile regex"));
-
-        GList *iter = koops_strings;
-        while(iter != NULL)
-        {
-            GList *next = g_list_next(iter);
-
-            const int reti = regexec(&filter_re, (const char *)iter->data, 0, NULL, 0);
-            if (reti == 0)
-                koops_strings = g_list_delete_link(koops_strings, iter);
-            else if (reti != REG_NOMATCH)
-            {
-                char msgbuf[100];
-                regerror(reti, &filter_re, msgbuf, sizeof(msgbuf));
-                error_msg_and_die("Regex match failed: %s", msgbuf);
-            }
-
-            iter = next;
-        }
-
-        regfree(&filter_re);
-        free(oops_string_filter_regex);
-    }
+    GList *koops_strings = abrt_oops_suspicious_strings_list_filtered();
 
     GList *koops_strings_blacklist = koops_suspicious_strings_blacklist();
 
@@ -169,6 +118,7 @@ static void watch_journald(abrt_journal_t *journal, const char *dump_location, i
 
     abrt_journal_watch_run_sync(watch);
     abrt_journal_watch_free(watch);
+    abrt_journal_watch_notify_strings_destroy(&notify_strings_conf);
 
     g_list_free(koops_strings);
 }
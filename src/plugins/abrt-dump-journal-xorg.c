@@ -47,20 +47,19 @@ static GList *abrt_journal_extract_xorg_crashes(abrt_journal_t *journal)
 
     do
     {
-        char *line = abrt_journal_get_log_line(journal);
+        size_t len;
+        const char *line = abrt_journal_get_log_line_data(journal, &len);
         if (line == NULL)
             error_msg_and_die(_("Cannot read journal data."));
 
-        char *p = skip_pfx(line);
-        if (strcmp(p, XORG_SEARCH_STRING) == 0)
+        if (xorg_is_backtrace_start(line, len))
         {
-            struct xorg_crash_info *crash_info = process_xorg_bt(&abrt_journal_get_next_log_line, journal);
+            struct xorg_crash_info *crash_info = process_xorg_bt(&abrt_journal_get_next_log_line_data, journal);
             if (crash_info)
                 crash_info_list = g_list_append(crash_info_list, crash_info);
             else
                 log_warning(_("Failed to parse Backtrace from journal"));
         }
-        free(line);
     }
     while (abrt_journal_next(journal) > 0);
 
@@ -123,6 +122,7 @@ static void watch_journald(abrt_journal_t *journal, const char *dump_location, i
 
     abrt_journal_watch_run_sync(watch);
     abrt_journal_watch_free(watch);
+    abrt_journal_watch_notify_strings_destroy(&notify_strings_conf);
 
     g_list_free(xorg_strings);
 }
@@ -0,0 +1,434 @@
+/*
+ * Copyright (C) 2016  ABRT team
+ * Copyright (C) 2016  RedHat Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#include "libabrt.h"
+#include "abrt-journal.h"
+#include "oops-utils.h"
+#include "xorg-utils.h"
+#include "journal-core-utils.h"
+
+/* The state files of the single purpose tools, so the tools can be replaced
+ * by this one without reading the journal again */
+#define ABRT_JOURNAL_OOPS_STATE_FILE VAR_STATE"/abrt-dump-journal-oops.state"
+#define ABRT_JOURNAL_XORG_STATE_FILE VAR_STATE"/abrt-dump-journal-xorg.state"
+#define ABRT_JOURNAL_CORE_STATE_FILE VAR_STATE"/abrt-dump-journal-core.state"
+#define ABRT_JOURNAL_CORE_THROTTLE_STATE_FILE VAR_STATE"/abrt-dump-journal-core.throttle"
+
+/* Used if CCpp.conf does not say otherwise */
+#define DEFAULT_JOURNAL_THROTTLE 0
+#define DEFAULT_JOURNAL_THROTTLE_BURST 1
+#define DEFAULT_JOURNAL_THROTTLE_SIZE 1024
+
+#define ABRT_JOURNAL_KOOPS_ANALYZER "abrt-journal-koops"
+
+#define XORG_CONF "xorg.conf"
+
+static abrt_journal_scanner_t *s_scanner;
+
+/*
+ * Koops extractor
+ */
+
+enum {
+    KOOPS_STRING_FOUND       = 1 << 0,
+    KOOPS_STRING_BLACKLISTED = 1 << 1,
+};
+
+struct koops_extractor
+{
+    const char *dump_location;
+    int oops_utils_flags;
+    /* Process only oopses found along with a suspicious string */
+    bool notified_only;
+
+    struct abrt_strings_matcher *matcher;
+    struct abrt_koops_parser *parser;
+    GList *oopses;
+    bool notified;
+};
+
+static bool koops_extractor_message(abrt_journal_t *journal, void *data)
+{
+    struct koops_extractor *ke = (struct koops_extractor *)data;
+
+    char *line = abrt_journal_get_log_line(journal);
+    if (line == NULL)
+        error_msg_and_die(_("Cannot read journal data."));
+
+    const unsigned found = strings_matcher_scan(ke->matcher, line, strlen(line),
+                                                /*stop at*/KOOPS_STRING_BLACKLISTED, NULL);
+    if (found == KOOPS_STRING_FOUND)
+        ke->notified = true;
+
+    koops_parser_feed_kernel_line(ke->parser, &ke->oopses, line);
+    free(line);
+
+    return true;
+}
+
+static void koops_extractor_idle(abrt_journal_t *journal, void *data)
+{
+    struct koops_extractor *ke = (struct koops_extractor *)data;
+
+    koops_parser_finish(ke->parser, &ke->oopses);
+
+    if (ke->notified || !ke->notified_only)
+    {
+        log_debug("Extracted: %d oopses", g_list_length(ke->oopses));
+
+        abrt_oops_process_list(ke->oopses, ke->dump_location,
+                               ABRT_JOURNAL_KOOPS_ANALYZER, ke->oops_utils_flags);
+
+        if (g_abrt_oops_sleep_woke_up_on_signal > 0)
+            abrt_journal_scanner_stop(s_scanner);
+    }
+
+    g_list_free_full(ke->oopses, (GDestroyNotify)free);
+    ke->oopses = NULL;
+    ke->notified = false;
+}
+
+/*
+ * Xorg extractor
+ */
+
+struct xorg_extractor
+{
+    const char *dump_location;
+    int xorg_utils_flags;
+
+    struct xorg_crash_collector collector;
+};
+
+static void xorg_extractor_idle(abrt_journal_t *journal, void *data)
+{
+    struct xorg_extractor *xe = (struct xorg_extractor *)data;
+
+    GList *crashes = xorg_crash_collector_finish(&xe->collector);
+    for (GList *iter = crashes; iter != NULL; iter = g_list_next(iter))
+    {
+        xorg_crash_info_create_dump_dir(iter->data, xe->dump_location,
+                                        (xe->xorg_utils_flags & ABRT_XORG_WORLD_READABLE));
+
+        if (xe->xorg_utils_flags & ABRT_XORG_PRINT_STDOUT)
+            xorg_crash_info_print_crash(iter->data);
+
+        if ((xe->xorg_utils_flags & ABRT_XORG_THROTTLE_CREATION)
+            && abrt_xorg_signaled_sleep(1) > 0)
+        {
+            abrt_journal_scanner_stop(s_scanner);
+            break;
+        }
+    }
+    g_list_free_full(crashes, (GDestroyNotify)xorg_crash_info_free);
+}
+
+static bool xorg_extractor_message(abrt_journal_t *journal, void *data)
+{
+    struct xorg_extractor *xe = (struct xorg_extractor *)data;
+
+    size_t len;
+    const char *line = abrt_journal_get_log_line_data(journal, &len);
+    if (line == NULL)
+        error_msg_and_die(_("Cannot read journal data."));
+
+    const unsigned collected = xorg_crash_collector_feed(&xe->collector, line, len);
+    if (collected == 0)
+        return false;
+
+    if (collected < XORG_MAX_COLLECTED_LINES)
+        return true;
+
+    xorg_extractor_idle(journal, data);
+    return false;
+}
+
+static GList *xorg_extractor_load_filters(void)
+{
+    const char *const env_journal_filter = getenv("ABRT_DUMP_JOURNAL_XORG_DEBUG_FILTER");
+    if (env_journal_filter != NULL)
+    {
+        log_debug("Using journal filter from environment variable");
+        return g_list_append(NULL, xstrdup(env_journal_filter));
+    }
+
+    map_string_t *settings = new_map_string();
+    log_notice("Loading settings from '%s'", XORG_CONF);
+    load_abrt_plugin_conf_file(XORG_CONF, settings);
+    log_debug("Loaded '%s'", XORG_CONF);
+    GList *filters = parse_list(get_map_string_item_or_NULL(settings, "JournalFilters"));
+    free_map_string(settings);
+
+    return filters;
+}
+
+/*
+ * Core extractor
+ */
+
+static bool core_extractor_message(abrt_journal_t *journal, void *data)
+{
+    abrt_journal_core_process(journal, (const abrt_watch_core_conf_t *)data);
+    return false;
+}
+
+/* Configures the throttle in the same way as abrt-dump-journal-core -T does */
+static void core_extractor_load_throttle(abrt_watch_core_conf_t *conf)
+{
+    map_string_t *settings = new_map_string();
+    load_abrt_plugin_conf_file("CCpp.conf", settings);
+
+    const char *value = get_map_string_item_or_NULL(settings, "JournalThrottle");
+    conf->awc_throttle = value ? xatoi_positive(value) : DEFAULT_JOURNAL_THROTTLE;
+
+    value = get_map_string_item_or_NULL(settings, "JournalThrottleBurst");
+    if (value)
+        conf->awc_throttle_burst = MAX(xatoi_positive(value), 1);
+
+    value = get_map_string_item_or_NULL(settings, "JournalThrottleSize");
+    if (value)
+        conf->awc_throttle_size = MAX(xatoi_positive(value), 1);
+
+    free_map_string(settings);
+}
+
+int main(int argc, char *argv[])
+{
+    /* I18n */
+    setlocale(LC_ALL, "");
+#if ENABLE_NLS
+    bindtextdomain(PACKAGE, LOCALEDIR);
+    textdomain(PACKAGE);
+#endif
+
+    abrt_init(argv);
+
+    /* Can't keep these strings/structs static: _() doesn't support that */
+    const char *program_usage_string = _(
+        "& [-vsoxtTfe] [-kXC] [-d DIR]/[-D]\n"
+        "\n"
+        "Extract oopses, Xorg crashes and coredumps from systemd-journal in one pass\n"
+        "\n"
+        "All extractors are used if none of -k, -X and -C is given.\n"
+        "\n"
+        "-e is useful only for -f because the following of journal starts by reading \n"
+        "the entire journal if the last seen position is not available.\n"
+        "\n"
+        "The last seen positions are saved in the files of abrt-dump-journal-oops,\n"
+        "abrt-dump-journal-xorg and abrt-dump-journal-core:\n"
+        ABRT_JOURNAL_OOPS_STATE_FILE"\n"
+        ABRT_JOURNAL_XORG_STATE_FILE"\n"
+        ABRT_JOURNAL_CORE_STATE_FILE"\n"
+    );
+    enum {
+        OPT_v = 1 << 0,
+        OPT_s = 1 << 1,
+        OPT_o = 1 << 2,
+        OPT_d = 1 << 3,
+        OPT_D = 1 << 4,
+        OPT_x = 1 << 5,
+        OPT_t = 1 << 6,
+        OPT_e = 1 << 7,
+        OPT_f = 1 << 8,
+        OPT_k = 1 << 9,
+        OPT_X = 1 << 10,
+        OPT_C = 1 << 11,
+        OPT_T = 1 << 12,
+    };
+
+    char *dump_location = NULL;
+
+    /* Keep enum above and order of options below in sync! */
+    struct options program_options[] = {
+        OPT__VERBOSE(&g_verbose),
+        OPT_BOOL(  's', NULL, NULL, _("Log to syslog")),
+        OPT_BOOL(  'o', NULL, NULL, _("Print found oopses and Xorg crashes on standard output")),
+        OPT_STRING('d', NULL, &dump_location, "DIR", _("Create new problem directory in DIR for every problem found")),
+        OPT_BOOL(  'D', NULL, NULL, _("Same as -d DumpLocation, DumpLocation is specified in abrt.conf")),
+        OPT_BOOL(  'x', NULL, NULL, _("Make the oops and Xorg problem directories world readable")),
+        OPT_BOOL(  't', NULL, NULL, _("Throttle oops and Xorg problem directory creation to 1 per second")),
+        OPT_BOOL(  'e', NULL, NULL, _("Start reading systemd-journal from the end")),
+        OPT_BOOL(  'f', NULL, NULL, _("Follow systemd-journal from the last seen positions (if available)")),
+        OPT_BOOL(  'k', NULL, NULL, _("Extract kernel oopses")),
+        OPT_BOOL(  'X', NULL, NULL, _("Extract Xorg crashes")),
+        OPT_BOOL(  'C', NULL, NULL, _("Extract coredumps of systemd-coredump")),
+        OPT_BOOL(  'T', NULL, NULL, _("Throttle coredump problem directory creation as configured in plugins/CCpp.conf")),
+        OPT_END()
+    };
+    unsigned opts = parse_opts(argc, argv, program_options, program_usage_string);
+
+    export_abrt_envvars(0);
+
+    msg_prefix = g_progname;
+    if ((opts & OPT_s) || getenv("ABRT_SYSLOG"))
+    {
+        logmode = LOGMODE_JOURNAL;
+    }
+
+    /* Initialize ABRT configuration */
+    load_abrt_conf();
+
+    if (opts & OPT_D)
+    {
+        if (opts & OPT_d)
+            show_usage_and_die(program_usage_string, program_options);
+        dump_location = g_settings_dump_location;
+    }
+
+    if (!(opts & (OPT_k | OPT_X | OPT_C)))
+        opts |= OPT_k | OPT_X | OPT_C;
+
+    const bool follow = (opts & OPT_f);
+
+    abrt_journal_t *journal = NULL;
+    if (abrt_journal_new(&journal))
+        error_msg_and_die(_("Cannot open systemd-journal"));
+
+    if (abrt_journal_scanner_new(&s_scanner, journal) < 0)
+        error_msg_and_die(_("Failed to initialize systemd-journal scanner"));
+
+    /* Kernel oopses */
+    struct koops_extractor koops_conf = {
+        .dump_location = dump_location,
+        .notified_only = follow,
+    };
+    GList *koops_filter = NULL;
+    struct abrt_journal_extractor koops_extractor = {
+        .name = "oops",
+        .message_cb = koops_extractor_message,
+        .idle_cb = koops_extractor_idle,
+        .data = &koops_conf,
+        .state_file = (follow ? ABRT_JOURNAL_OOPS_STATE_FILE : NULL),
+    };
+
+    if ((opts & OPT_k))
+    {
+        if ((opts & OPT_x))
+            koops_conf.oops_utils_flags |= ABRT_OOPS_WORLD_READABLE;
+        if ((opts & OPT_t))
+            koops_conf.oops_utils_flags |= ABRT_OOPS_THROTTLE_CREATION;
+        if ((opts & OPT_o))
+            koops_conf.oops_utils_flags |= ABRT_OOPS_PRINT_STDOUT;
+
+        GList *koops_strings = abrt_oops_suspicious_strings_list_filtered();
+        GList *koops_strings_blacklist = koops_suspicious_strings_blacklist();
+
+        koops_conf.matcher = strings_matcher_new();
+        strings_matcher_add_list(koops_conf.matcher, koops_strings, KOOPS_STRING_FOUND);
+        strings_matcher_add_list(koops_conf.matcher, koops_strings_blacklist, KOOPS_STRING_BLACKLISTED);
+        strings_matcher_compile(koops_conf.matcher);
+
+        g_list_free(koops_strings_blacklist);
+        g_list_free(koops_strings);
+
+        koops_conf.parser = koops_parser_new();
+
+        const char *const env_journal_filter = getenv("ABRT_DUMP_JOURNAL_OOPS_DEBUG_FILTER");
+        koops_filter = g_list_append(koops_filter,
+                (env_journal_filter ? (gpointer)env_journal_filter : (gpointer)"SYSLOG_IDENTIFIER=kernel"));
+        koops_extractor.matches = koops_filter;
+
+        if (abrt_journal_scanner_add_extractor(s_scanner, &koops_extractor) < 0)
+            error_msg_and_die(_("Cannot filter systemd-journal to kernel data"));
+    }
+
+    /* Xorg crashes */
+    struct xorg_extractor xorg_conf = {
+        .dump_location = dump_location,
+        .collector = XORG_CRASH_COLLECTOR_INIT,
+    };
+    GList *xorg_filter = NULL;
+    struct abrt_journal_extractor xorg_extractor = {
+        .name = "xorg",
+        .message_cb = xorg_extractor_message,
+        .idle_cb = xorg_extractor_idle,
+        .data = &xorg_conf,
+        .state_file = (follow ? ABRT_JOURNAL_XORG_STATE_FILE : NULL),
+    };
+
+    if ((opts & OPT_X))
+    {
+        if ((opts & OPT_x))
+            xorg_conf.xorg_utils_flags |= ABRT_XORG_WORLD_READABLE;
+        if ((opts & OPT_t))
+            xorg_conf.xorg_utils_flags |= ABRT_XORG_THROTTLE_CREATION;
+        if ((opts & OPT_o))
+            xorg_conf.xorg_utils_flags |= ABRT_XORG_PRINT_STDOUT;
+
+        xorg_filter = xorg_extractor_load_filters();
+        xorg_extractor.matches = xorg_filter;
+
+        if (xorg_filter == NULL)
+            log_notice("Not extracting Xorg crashes, %s has no JournalFilters", XORG_CONF);
+        else if (abrt_journal_scanner_add_extractor(s_scanner, &xorg_extractor) < 0)
+            error_msg_and_die(_("Cannot filter systemd-journal to Xorg data"));
+    }
+
+    /* Coredumps */
+    abrt_watch_core_conf_t core_conf = {
+        .awc_dump_location = dump_location,
+        .awc_throttle = 0,
+        .awc_throttle_burst = DEFAULT_JOURNAL_THROTTLE_BURST,
+        .awc_throttle_size = DEFAULT_JOURNAL_THROTTLE_SIZE,
+    };
+    GList *core_filter = NULL;
+    struct abrt_journal_extractor core_extractor = {
+        .name = "core",
+        .message_cb = core_extractor_message,
+        .data = &core_conf,
+        .state_file = (follow ? ABRT_JOURNAL_CORE_STATE_FILE : NULL),
+    };
+
+    if ((opts & OPT_C))
+    {
+        const char *const env_journal_filter = getenv("ABRT_DUMP_JOURNAL_CORE_DEBUG_FILTER");
+        core_filter = g_list_append(core_filter,
+               (env_journal_filter ? (gpointer)env_journal_filter : (gpointer)"SYSLOG_IDENTIFIER=systemd-coredump"));
+        core_extractor.matches = core_filter;
+
+        if ((opts & OPT_T))
+        {
+            core_extractor_load_throttle(&core_conf);
+            /* Shared with abrt-dump-journal-core like the last seen position */
+            if (follow)
+                core_conf.awc_throttle_state_file = ABRT_JOURNAL_CORE_THROTTLE_STATE_FILE;
+        }
+
+        if (abrt_journal_scanner_add_extractor(s_scanner, &core_extractor) < 0)
+            error_msg_and_die(_("Cannot filter systemd-journal to systemd-coredump data"));
+    }
+
+    if (follow)
+        abrt_journal_scanner_restore_positions(s_scanner, (opts & OPT_e));
+    else if ((opts & OPT_e) && abrt_journal_seek_tail(journal) < 0)
+        error_msg_and_die(_("Cannot seek to the end of journal"));
+
+    abrt_journal_scanner_run_sync(s_scanner, follow);
+
+    abrt_journal_core_save_throttle(&core_conf);
+
+    abrt_journal_scanner_free(s_scanner);
+    abrt_journal_free(journal);
+
+    g_list_free(core_filter);
+    g_list_free_full(xorg_filter, free);
+    g_list_free(koops_filter);
+
+    koops_parser_free(koops_conf.parser);
+    strings_matcher_free(koops_conf.matcher);
+
+    free_abrt_conf_data();
+
+    return EXIT_SUCCESS;
+}
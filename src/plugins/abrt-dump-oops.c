@@ -17,50 +17,364 @@
        Arjan van de Ven <arjan@linux.intel.com>
  */
 #include <syslog.h>
+#include <poll.h>
+#include <sys/mman.h>
 #include "libabrt.h"
 #include "oops-utils.h"
+#include "oops-scan.h"
 
-#define MAX_SCAN_BLOCK  (4*1024*1024)
-#define READ_AHEAD          (10*1024)
+#define SCAN_BLOCK (64*1024)
 #define ABRT_DUMP_OOPS_ANALYZER "abrt-oops"
 
+/* Smaller files are not worth starting threads */
+#define PARALLEL_SCAN_MIN_SIZE (16*1024*1024)
+
+#define KMSG_PATH "/dev/kmsg"
+/* The kernel never returns a record longer than 8KiB */
+#define KMSG_RECORD_MAX (8*1024)
+#define KMSG_WATCH_STATE_FILE VAR_STATE"/abrt-dump-oops-kmsg.state"
+
+/* Scans 'size' bytes of a large regular file from the offset 'offset' in
+ * parallel and moves the file offset behind the scanned data. Returns false
+ * if the file can't be mapped.
+ */
+static bool scan_syslog_file_parallel(GList **oops_list, int fd, off_t offset, size_t size)
+{
+    /* mmap() needs a page aligned offset */
+    const off_t map_offset = offset - offset % sysconf(_SC_PAGESIZE);
+    const size_t skip = offset - map_offset;
+
+    void *buffer = mmap(NULL, skip + size, PROT_READ, MAP_PRIVATE, fd, map_offset);
+    if (buffer == MAP_FAILED)
+    {
+        log_notice("Can't map the file, scanning it serially: %s", strerror(errno));
+        return false;
+    }
+
+    madvise(buffer, skip + size, MADV_SEQUENTIAL);
+    abrt_oops_scan_syslog_buffer(oops_list, (char *)buffer + skip, size, /*one per CPU*/0);
+    munmap(buffer, skip + size);
+
+    /* The caller (e.g. abrt-watch-log) expects the data to be consumed */
+    if (lseek(fd, offset + size, SEEK_SET) < 0)
+        perror_msg("Can't seek behind the scanned data");
+
+    return true;
+}
+
+/* Reads the file block by block and feeds its lines to the streaming oops
+ * parser, so memory usage does not depend on the file size. Large regular
+ * files are scanned in parallel.
+ */
 static void scan_syslog_file(GList **oops_list, int fd)
 {
+    /* Scan from the current offset, abrt-watch-log passes the file
+     * positioned at the beginning of the new data */
     struct stat st;
-    struct stat *statbuf = &st;
-
-    /* Try to not allocate an absurd amount of memory */
-    int sz = MAX_SCAN_BLOCK - READ_AHEAD;
-    /* If it's a real file, estimate size after cur pos */
-    off_t cur_pos = lseek(fd, 0, SEEK_CUR);
-    if (cur_pos >= 0 && fstat(fd, statbuf) == 0 && S_ISREG(statbuf->st_mode))
+    const off_t offset = lseek(fd, 0, SEEK_CUR);
+    if (offset >= 0 && fstat(fd, &st) == 0 && S_ISREG(st.st_mode)
+        && st.st_size - offset >= PARALLEL_SCAN_MIN_SIZE && st.st_size - offset <= SIZE_MAX
+        && scan_syslog_file_parallel(oops_list, fd, offset, (size_t)(st.st_size - offset)))
     {
-        off_t size_to_read = statbuf->st_size - cur_pos;
-        if (size_to_read >= 0 && sz > size_to_read)
-            sz = size_to_read;
+        return;
     }
 
-    /*
-     * In theory we have a race here, since someone can spew
-     * to /var/log/messages before we read it in...
-     * We try to deal with it by reading READ_AHEAD extra.
-     */
-    sz += READ_AHEAD;
-    char *buffer = xzalloc(sz);
+    struct abrt_koops_parser *parser = koops_parser_new();
+    /* The incomplete last line of the previous block */
+    struct strbuf *partial = strbuf_new();
+    char *buffer = xmalloc(SCAN_BLOCK);
 
     for (;;)
     {
-        int r = full_read(fd, buffer, sz-1);
+        ssize_t r = safe_read(fd, buffer, SCAN_BLOCK);
         if (r <= 0)
             break;
-        log_debug("Read %u bytes", r);
-        koops_extract_oopses(oops_list, buffer, r);
-//TODO: rewind to last newline?
+        log_debug("Read %u bytes", (unsigned)r);
+
+        char *c = buffer;
+        char *const end = buffer + r;
+        char *eol;
+        while ((eol = memchr(c, '\n', end - c)) != NULL)
+        {
+            *eol = '\0';
+            if (partial->len != 0)
+            {
+                strbuf_append_str(partial, c);
+                koops_parser_feed_syslog_line(parser, oops_list, partial->buf);
+                strbuf_clear(partial);
+            }
+            else if (eol != c)
+                koops_parser_feed_syslog_line(parser, oops_list, c);
+            c = eol + 1;
+        }
+
+        if (c != end)
+            strbuf_append_strf(partial, "%.*s", (int)(end - c), c);
     }
 
+    if (partial->len != 0)
+        koops_parser_feed_syslog_line(parser, oops_list, partial->buf);
+
+    koops_parser_finish(parser, oops_list);
+
     free(buffer);
+    strbuf_free(partial);
+    koops_parser_free(parser);
+}
+
+/*
+ * /dev/kmsg reader
+ *
+ * Every read() returns one record:
+ * "PRIORITY,SEQNUM,TIMESTAMP,FLAGS[,...];MESSAGE\n[ KEY=VALUE\n]..."
+ * where PRIORITY is (facility << 3 | level) and non-printable characters of
+ * MESSAGE are escaped as \xHH.
+ */
+
+/* The last processed record, sequence numbers start over on every boot */
+struct kmsg_position
+{
+    char *boot_id;
+    unsigned long long seqnum;
+    bool valid;
+};
+
+static char *kmsg_current_boot_id(void)
+{
+    char *boot_id = xmalloc_fopen_fgetline_fclose("/proc/sys/kernel/random/boot_id");
+    return boot_id ? boot_id : xstrdup("");
+}
+
+/* Returns the message of the record or NULL if it is not a kernel message */
+static char *kmsg_parse_record(char *record, int *level, unsigned long long *seqnum)
+{
+    char *msg = strchr(record, ';');
+    if (msg == NULL)
+        return NULL;
+
+    *msg++ = '\0';
+    *strchrnul(msg, '\n') = '\0';
+
+    char *end;
+    errno = 0;
+    const unsigned long priority = strtoul(record, &end, 10);
+    if (errno || *end != ',')
+        return NULL;
+
+    *seqnum = strtoull(end + 1, &end, 10);
+    if (errno || (*end != ',' && *end != '\0'))
+        return NULL;
+
+    /* Skip messages written to /dev/kmsg from user space */
+    if ((priority >> 3) != LOG_KERN)
+        return NULL;
+
+    *level = priority & LOG_PRIMASK;
+
+    /* Unescape \xHH in place */
+    char *dst = msg;
+    for (const char *src = msg; *src != '\0'; ++dst)
+    {
+        if (src[0] == '\\' && src[1] == 'x' && isxdigit(src[2]) && isxdigit(src[3]))
+        {
+            const char hex[3] = { src[2], src[3], '\0' };
+            *dst = (char)strtoul(hex, NULL, 16);
+            src += 4;
+        }
+        else
+            *dst = *src++;
+    }
+    *dst = '\0';
+
+    return msg;
+}
+
+/* Feeds the records available without blocking to the oops parser.
+ *
+ * Returns the number of fed records.
+ */
+static unsigned scan_kmsg(int fd, struct abrt_koops_parser *parser, GList **oops_list,
+        struct kmsg_position *pos)
+{
+    char record[KMSG_RECORD_MAX + 1];
+    unsigned fed = 0;
+
+    for (;;)
+    {
+        const ssize_t r = read(fd, record, KMSG_RECORD_MAX);
+        if (r < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            /* The record we wanted to read has been overwritten */
+            if (errno == EPIPE)
+            {
+                log_warning(_("Kernel messages were lost before they were read"));
+                continue;
+            }
+            if (errno != EAGAIN)
+                perror_msg(_("Can't read '%s'"), KMSG_PATH);
+            break;
+        }
+        if (r == 0)
+            break;
+
+        record[r] = '\0';
+
+        int level;
+        unsigned long long seqnum;
+        char *msg = kmsg_parse_record(record, &level, &seqnum);
+        if (msg == NULL)
+            continue;
+
+        if (pos->valid && seqnum <= pos->seqnum)
+            continue;
+
+        pos->seqnum = seqnum;
+        pos->valid = true;
+        ++fed;
+
+        /* Multi-line messages have the new lines escaped */
+        for (char *line = msg; *line != '\0'; )
+        {
+            char *eol = strchrnul(line, '\n');
+            const bool last = (*eol == '\0');
+            *eol = '\0';
+            if (eol != line)
+                koops_parser_feed_line(parser, oops_list, line, level);
+            line = last ? eol : eol + 1;
+        }
+    }
+
+    return fed;
+}
+
+static void kmsg_restore_position(struct kmsg_position *pos, const char *file_name)
+{
+    char *contents = xmalloc_open_read_close(file_name, /*maxsize:*/ NULL);
+    if (contents == NULL)
+    {
+        log_notice(_("Not restoring /dev/kmsg position: can't read '%s'"), file_name);
+        return;
+    }
+
+    char boot_id[64];
+    unsigned long long seqnum;
+    if (sscanf(contents, "%63s %llu", boot_id, &seqnum) != 2)
+        error_msg(_("Ignoring malformed /dev/kmsg position file '%s'"), file_name);
+    else if (strcmp(boot_id, pos->boot_id) != 0)
+        log_notice("Ignoring /dev/kmsg position from another boot");
+    else
+    {
+        pos->seqnum = seqnum;
+        pos->valid = true;
+        log_debug("Restored /dev/kmsg position %llu", seqnum);
+    }
+
+    free(contents);
+}
+
+static void kmsg_save_position(const struct kmsg_position *pos, const char *file_name)
+{
+    if (!pos->valid)
+        return;
+
+    /* The position file must never be seen half written */
+    char *tmp = xasprintf("%s.new", file_name);
+    const int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW, 0600);
+    if (fd < 0)
+    {
+        perror_msg(_("Cannot save /dev/kmsg position: open('%s')"), tmp);
+        free(tmp);
+        return;
+    }
+
+    char *contents = xasprintf("%s %llu\n", pos->boot_id, pos->seqnum);
+    const bool written = full_write_str(fd, contents) == strlen(contents);
+    if (fsync(fd) != 0 || close(fd) != 0 || !written || rename(tmp, file_name) != 0)
+    {
+        perror_msg(_("Cannot save /dev/kmsg position to '%s'"), file_name);
+        unlink(tmp);
+    }
+
+    free(contents);
+    free(tmp);
+}
+
+static volatile sig_atomic_t s_kmsg_watch_terminated;
+static void kmsg_watch_terminate(int signum)
+{
+    signum = signum;
+    s_kmsg_watch_terminated = 1;
+}
+
+static void kmsg_process_oopses(GList **oops_list, const char *dump_location, int flags)
+{
+    if (*oops_list == NULL)
+        return;
+
+    abrt_oops_process_list(*oops_list, dump_location, ABRT_DUMP_OOPS_ANALYZER, flags);
+    list_free_with_free(*oops_list);
+    *oops_list = NULL;
+
+    if (g_abrt_oops_sleep_woke_up_on_signal > 0)
+        s_kmsg_watch_terminated = 1;
+}
+
+/* Processes new kernel messages until a signal arrives. */
+static void watch_kmsg(int fd, struct kmsg_position *pos, const char *dump_location, int flags)
+{
+    /* Exit gracefully: */
+    /* services usually exit on SIGTERM and SIGHUP */
+    signal(SIGTERM, kmsg_watch_terminate);
+    signal(SIGHUP, kmsg_watch_terminate);
+    /* Ctrl-C for easier debugging */
+    signal(SIGINT, kmsg_watch_terminate);
+
+    struct abrt_koops_parser *parser = koops_parser_new();
+    GList *oops_list = NULL;
+    bool parser_pending = false;
+
+    struct pollfd pollfd = { .fd = fd, .events = POLLIN };
+    while (!s_kmsg_watch_terminated)
+    {
+        if (scan_kmsg(fd, parser, &oops_list, pos) != 0)
+            parser_pending = true;
+
+        /* Oopses complete before the end of the read messages */
+        kmsg_process_oopses(&oops_list, dump_location, flags);
+
+        /* Give the kernel one second to print the rest of an oops */
+        const int r = poll(&pollfd, 1, parser_pending ? 1000 : -1);
+        if (r < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            perror_msg_and_die("poll('%s')", KMSG_PATH);
+        }
+
+        if (r == 0)
+        {
+            koops_parser_finish(parser, &oops_list);
+            parser_pending = false;
+            kmsg_process_oopses(&oops_list, dump_location, flags);
+
+            /* All fed messages have been processed */
+            kmsg_save_position(pos, KMSG_WATCH_STATE_FILE);
+        }
+    }
+
+    koops_parser_finish(parser, &oops_list);
+    kmsg_process_oopses(&oops_list, dump_location, flags);
+    kmsg_save_position(pos, KMSG_WATCH_STATE_FILE);
+
+    koops_parser_free(parser);
 }
 
+/*
+ * /dev/kmsg reader end
+ */
+
 int main(int argc, char **argv)
 {
     /* I18n */
@@ -75,8 +389,15 @@ int main(int argc, char **argv)
     /* Can't keep these strings/structs static: _() doesn't support that */
     const char *program_usage_string = _(
         "& [-vusoxm] [-d DIR]/[-D] [FILE]\n"
+        "or:\n"
+        "& -k [-vsoxtfe] [-d DIR]/[-D]\n"
         "\n"
-        "Extract oops from FILE (or standard input)"
+        "Extract oops from FILE (or standard input)\n"
+        "\n"
+        "With -k, extract oops from "KMSG_PATH". -f continues with new messages\n"
+        "starting after the last seen message which is saved in\n"
+        KMSG_WATCH_STATE_FILE". If the last seen message is not available,\n"
+        "all messages are read, or only new ones if -e is given."
     );
     enum {
         OPT_v = 1 << 0,
@@ -88,6 +409,9 @@ int main(int argc, char **argv)
         OPT_x = 1 << 6,
         OPT_t = 1 << 7,
         OPT_m = 1 << 8,
+        OPT_k = 1 << 9,
+        OPT_f = 1 << 10,
+        OPT_e = 1 << 11,
     };
     char *problem_dir = NULL;
     char *dump_location = NULL;
@@ -105,6 +429,9 @@ int main(int argc, char **argv)
         OPT_BOOL(  'x', NULL, NULL, _("Make the problem directory world readable")),
         OPT_BOOL(  't', NULL, NULL, _("Throttle problem directory creation to 1 per second")),
         OPT_BOOL(  'm', NULL, NULL, _("Print search string(s) to stdout and exit")),
+        OPT_BOOL(  'k', NULL, NULL, _("Read kernel messages from "KMSG_PATH)),
+        OPT_BOOL(  'f', NULL, NULL, _("Follow "KMSG_PATH" from the last seen message (if available)")),
+        OPT_BOOL(  'e', NULL, NULL, _("Start reading "KMSG_PATH" from the end")),
         OPT_END()
     };
     unsigned opts = parse_opts(argc, argv, program_options, program_usage_string);
@@ -160,11 +487,47 @@ int main(int argc, char **argv)
         oops_utils_flags |= ABRT_OOPS_PRINT_STDOUT;
 
     argv += optind;
-    if (argv[0])
-        xmove_fd(xopen(argv[0], O_RDONLY), STDIN_FILENO);
+    if ((opts & (OPT_f|OPT_e)) && !(opts & OPT_k))
+        show_usage_and_die(program_usage_string, program_options);
 
     GList *oops_list = NULL;
-    scan_syslog_file(&oops_list, STDIN_FILENO);
+    if (opts & OPT_k)
+    {
+        if (argv[0] || ((opts & OPT_f) && (opts & OPT_u)))
+            show_usage_and_die(program_usage_string, program_options);
+
+        const int kmsg_fd = xopen(KMSG_PATH, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+
+        struct kmsg_position pos = { .boot_id = kmsg_current_boot_id() };
+        if (opts & OPT_f)
+            kmsg_restore_position(&pos, KMSG_WATCH_STATE_FILE);
+
+        if (!pos.valid && (opts & OPT_e) && lseek(kmsg_fd, 0, SEEK_END) < 0)
+            perror_msg_and_die(_("Cannot seek to the end of '%s'"), KMSG_PATH);
+
+        if (opts & OPT_f)
+        {
+            watch_kmsg(kmsg_fd, &pos, dump_location, oops_utils_flags);
+            close(kmsg_fd);
+            free(pos.boot_id);
+            return EXIT_SUCCESS;
+        }
+
+        struct abrt_koops_parser *parser = koops_parser_new();
+        scan_kmsg(kmsg_fd, parser, &oops_list, &pos);
+        koops_parser_finish(parser, &oops_list);
+        koops_parser_free(parser);
+
+        close(kmsg_fd);
+        free(pos.boot_id);
+    }
+    else
+    {
+        if (argv[0])
+            xmove_fd(xopen(argv[0], O_RDONLY), STDIN_FILENO);
+
+        scan_syslog_file(&oops_list, STDIN_FILENO);
+    }
 
     unsigned errors = 0;
     if (opts & OPT_u)
@@ -87,14 +87,19 @@ int main(int argc, char **argv)
     if (argv[0])
         xmove_fd(xopen(argv[0], O_RDONLY), STDIN_FILENO);
 
+    /* The log is read, not mapped: a log truncated by rotation would kill
+     * us with SIGBUS. Reading starts at the current offset, abrt-watch-log
+     * passes the log positioned at the beginning of the new data. */
+    struct xorg_log_stream stream = XORG_LOG_STREAM_INIT(stdin);
+
     int bt_count = 0;
-    char *line = NULL;
-    while ((line = xmalloc_fgetline(stdin)) != NULL)
+    const char *line;
+    size_t len;
+    while ((line = xorg_log_stream_next_line(&stream, &len)) != NULL)
     {
-        char *p = skip_pfx(line);
-        if (strcmp(p, "Backtrace:") == 0)
+        if (xorg_is_backtrace_start(line, len))
         {
-            struct xorg_crash_info *crash_info = process_xorg_bt(&xorg_get_next_line_from_fd, stdin);
+            struct xorg_crash_info *crash_info = process_xorg_bt(xorg_log_stream_next_line, &stream);
             if (crash_info)
             {
                 if (opts & OPT_o)
@@ -107,7 +112,6 @@ int main(int argc, char **argv)
             else
                 log_warning(_("Failed to parse Backtrace from log file"));
         }
-        free(line);
     }
 
     return 0;
@@ -17,6 +17,7 @@
 #include <poll.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <inttypes.h>
 
 #include "abrt-journal.h"
 #include "libabrt.h"
@@ -207,13 +208,22 @@ char *abrt_journal_get_log_line(abrt_journal_t *journal)
     return abrt_journal_get_string_field(journal, "MESSAGE", NULL);
 }
 
-char *abrt_journal_get_next_log_line(void *data)
+const char *abrt_journal_get_log_line_data(abrt_journal_t *journal, size_t *len)
+{
+    const char *data;
+    if (abrt_journal_get_field(journal, "MESSAGE", (const void **)&data, len) < 0)
+        return NULL;
+
+    return data;
+}
+
+const char *abrt_journal_get_next_log_line_data(void *data, size_t *len)
 {
     abrt_journal_t *journal = (abrt_journal_t *)data;
     if (abrt_journal_next(journal) <= 0)
         return NULL;
 
-    return abrt_journal_get_log_line(journal);
+    return abrt_journal_get_log_line_data(journal, len);
 }
 
 int abrt_journal_get_cursor(abrt_journal_t *journal, char **cursor)
@@ -255,6 +265,14 @@ int abrt_journal_seek_tail(abrt_journal_t *journal)
     return 0;
 }
 
+int abrt_journal_test_cursor(abrt_journal_t *journal, const char *cursor)
+{
+    const int r = sd_journal_test_cursor(journal->j, cursor);
+    if (r < 0)
+        log_notice("Failed to test journal cursor '%s': %s", cursor, strerror(-r));
+    return r;
+}
+
 int abrt_journal_next(abrt_journal_t *journal)
 {
     const int r = sd_journal_next(journal->j);
@@ -263,6 +281,46 @@ int abrt_journal_next(abrt_journal_t *journal)
     return r;
 }
 
+/* The cursor is written to a temporary file which then replaces the state
+ * file, so a crash can't leave a truncated cursor behind */
+static int abrt_journal_save_cursor(const char *file_name, const char *crsr)
+{
+    char *tmp_name = xasprintf("%s.new", file_name);
+    int state_fd = open(tmp_name,
+            O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC,
+            ABRT_JOURNAL_WATCH_STATE_FILE_MODE);
+
+    if (state_fd < 0)
+    {
+        perror_msg(_("Cannot save journal watch's position: open('%s')"), tmp_name);
+        free(tmp_name);
+        return -1;
+    }
+
+    const size_t len = strlen(crsr);
+    if (full_write(state_fd, crsr, len) != len || fsync(state_fd) != 0)
+    {
+        perror_msg(_("Cannot save journal watch's position: write('%s')"), tmp_name);
+        close(state_fd);
+        goto cleanup;
+    }
+    close(state_fd);
+
+    if (rename(tmp_name, file_name) != 0)
+    {
+        perror_msg(_("Cannot save journal watch's position: rename('%s')"), tmp_name);
+        goto cleanup;
+    }
+
+    free(tmp_name);
+    return 0;
+
+cleanup:
+    unlink(tmp_name);
+    free(tmp_name);
+    return -1;
+}
+
 int abrt_journal_save_current_position(abrt_journal_t *journal, const char *file_name)
 {
     char *crsr = NULL;
@@ -275,24 +333,14 @@ int abrt_journal_save_current_position(abrt_journal_t *journal, const char *file
         return r;
     }
 
-    int state_fd = open(file_name,
-            O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW,
-            ABRT_JOURNAL_WATCH_STATE_FILE_MODE);
-
-    if (state_fd < 0)
-    {
-        perror_msg(_("Cannot save journal watch's position: open('%s')"), file_name);
-        return -1;
-    }
-
-    full_write_str(state_fd, crsr);
-    close(state_fd);
+    abrt_journal_save_cursor(file_name, crsr);
 
     free(crsr);
     return 0;
 }
 
-int abrt_journal_restore_position(abrt_journal_t *journal, const char *file_name)
+/* Returns malloced cursor read from the file or NULL */
+static char *abrt_journal_load_cursor(const char *file_name)
 {
     struct stat buf;
     if (lstat(file_name, &buf) < 0)
@@ -303,27 +351,29 @@ int abrt_journal_restore_position(abrt_journal_t *journal, const char *file_name
         else
             perror_msg(_("Cannot restore journal watch's position form file '%s'"), file_name);
 
-        return -errno;
+        return NULL;
     }
 
     if (!(buf.st_mode & S_IFREG))
     {
         error_msg(_("Cannot restore journal watch's position: path '%s' is not regular file"), file_name);
-        return -EMEDIUMTYPE;
+        errno = EMEDIUMTYPE;
+        return NULL;
     }
 
     if (buf.st_size > ABRT_JOURNAL_WATCH_STATE_FILE_MAX_SZ)
     {
         error_msg(_("Cannot restore journal watch's position: file '%s' exceeds %dB size limit"),
                 file_name, ABRT_JOURNAL_WATCH_STATE_FILE_MAX_SZ);
-        return -EFBIG;
+        errno = EFBIG;
+        return NULL;
     }
 
     int state_fd = open(file_name, O_RDONLY | O_NOFOLLOW);
     if (state_fd < 0)
     {
         perror_msg(_("Cannot restore journal watch's position: open('%s')"), file_name);
-        return -errno;
+        return NULL;
     }
 
     char *crsr = xmalloc(buf.st_size + 1);
@@ -333,17 +383,28 @@ int abrt_journal_restore_position(abrt_journal_t *journal, const char *file_name
     {
         error_msg(_("Cannot restore journal watch's position: cannot read entire file '%s'"), file_name);
         close(state_fd);
-        return -errno;
+        free(crsr);
+        return NULL;
     }
 
     crsr[sz] = '\0';
     close(state_fd);
 
+    return crsr;
+}
+
+int abrt_journal_restore_position(abrt_journal_t *journal, const char *file_name)
+{
+    char *crsr = abrt_journal_load_cursor(file_name);
+    if (crsr == NULL)
+        return errno ? -errno : -EIO;
+
     const int r = abrt_journal_set_cursor(journal, crsr);
     if (r < 0)
     {
         /* abrt_journal_set_cursor() prints error message in verbose mode */
         error_msg(_("Failed to move the journal to a cursor from file '%s'"), file_name);
+        free(crsr);
         return r;
     }
 
@@ -375,6 +436,15 @@ struct abrt_journal_watch
 
     abrt_journal_watch_callback callback;
     void *callback_data;
+
+    /* Checkpoint policy */
+    char *checkpoint_file;
+    unsigned checkpoint_max_count;
+    unsigned checkpoint_max_interval;
+    /* The last processed message which has not been saved yet */
+    char *checkpoint_cursor;
+    unsigned checkpoint_pending;
+    gint64 checkpoint_deadline;
 };
 
 int abrt_journal_watch_new(abrt_journal_watch_t **watch, abrt_journal_t *journal, abrt_journal_watch_callback callback, void *callback_data)
@@ -391,6 +461,8 @@ int abrt_journal_watch_new(abrt_journal_watch_t **watch, abrt_journal_t *journal
 
 void abrt_journal_watch_free(abrt_journal_watch_t *watch)
 {
+    free(watch->checkpoint_file);
+    free(watch->checkpoint_cursor);
     watch->j = (void *)0xDEADBEAF;
     free(watch);
 }
@@ -400,6 +472,56 @@ abrt_journal_t *abrt_journal_watch_get_journal(abrt_journal_watch_t *watch)
     return watch->j;
 }
 
+void abrt_journal_watch_set_checkpoint(abrt_journal_watch_t *watch,
+                                       const char *file_name,
+                                       unsigned max_count,
+                                       unsigned max_interval)
+{
+    free(watch->checkpoint_file);
+    watch->checkpoint_file = xstrdup(file_name);
+    watch->checkpoint_max_count = max_count ? max_count : 1;
+    watch->checkpoint_max_interval = max_interval;
+}
+
+static void abrt_journal_watch_flush_checkpoint(abrt_journal_watch_t *watch)
+{
+    if (watch->checkpoint_pending == 0)
+        return;
+
+    log_debug("Saving journal position after %u messages", watch->checkpoint_pending);
+
+    /* Don't retry in a loop if the state file can't be written, the next
+     * checkpoint will try it again */
+    abrt_journal_save_cursor(watch->checkpoint_file, watch->checkpoint_cursor);
+    watch->checkpoint_pending = 0;
+}
+
+void abrt_journal_watch_checkpoint(abrt_journal_watch_t *watch)
+{
+    assert(watch->checkpoint_file != NULL || !"ABRT watch has no checkpoint file");
+
+    char *crsr = NULL;
+    if (abrt_journal_get_cursor(watch->j, &crsr) < 0)
+    {
+        /* abrt_journal_get_cursor() prints error message in verbose mode */
+        error_msg(_("Cannot save journal watch's position"));
+        return;
+    }
+
+    free(watch->checkpoint_cursor);
+    watch->checkpoint_cursor = crsr;
+
+    const gint64 now = g_get_monotonic_time();
+    if (watch->checkpoint_pending++ == 0)
+        watch->checkpoint_deadline = now + (gint64)watch->checkpoint_max_interval * G_USEC_PER_SEC;
+
+    if (watch->checkpoint_pending >= watch->checkpoint_max_count
+        || now >= watch->checkpoint_deadline)
+    {
+        abrt_journal_watch_flush_checkpoint(watch);
+    }
+}
+
 int abrt_journal_watch_run_sync(abrt_journal_watch_t *watch)
 {
     sigset_t mask;
@@ -434,7 +556,22 @@ int abrt_journal_watch_run_sync(abrt_journal_watch_t *watch)
         }
         else if (r == 0)
         {
-            ppoll(&pollfd, 1, NULL, &mask);
+            /* Don't sleep longer than the unsaved checkpoint may wait */
+            struct timespec timeout;
+            struct timespec *ptimeout = NULL;
+            if (watch->checkpoint_pending)
+            {
+                const gint64 left = MAX(watch->checkpoint_deadline - g_get_monotonic_time(), 0);
+                timeout.tv_sec = left / G_USEC_PER_SEC;
+                timeout.tv_nsec = (left % G_USEC_PER_SEC) * 1000;
+                ptimeout = &timeout;
+            }
+
+            ppoll(&pollfd, 1, ptimeout, &mask);
+
+            if (watch->checkpoint_pending && g_get_monotonic_time() >= watch->checkpoint_deadline)
+                abrt_journal_watch_flush_checkpoint(watch);
+
             r = sd_journal_process(watch->j->j);
             if (r < 0)
             {
@@ -447,6 +584,10 @@ int abrt_journal_watch_run_sync(abrt_journal_watch_t *watch)
         watch->callback(watch, watch->callback_data);
     }
 
+    /* Termination signals end the loop here, don't lose the processed
+     * messages */
+    abrt_journal_watch_flush_checkpoint(watch);
+
     return r;
 }
 
@@ -459,30 +600,440 @@ void abrt_journal_watch_stop(abrt_journal_watch_t *watch)
  * ABRT systemd-journal watch - end
  */
 
+enum {
+    NOTIFY_STRING_FOUND       = 1 << 0,
+    NOTIFY_STRING_BLACKLISTED = 1 << 1,
+};
+
 void abrt_journal_watch_notify_strings(abrt_journal_watch_t *watch, void *data)
 {
     struct abrt_journal_watch_notify_strings *conf = (struct abrt_journal_watch_notify_strings *)data;
 
+    if (conf->matcher == NULL)
+    {
+        conf->matcher = strings_matcher_new();
+        strings_matcher_add_list(conf->matcher, conf->strings, NOTIFY_STRING_FOUND);
+        strings_matcher_add_list(conf->matcher, conf->blacklisted_strings, NOTIFY_STRING_BLACKLISTED);
+        strings_matcher_compile(conf->matcher);
+    }
+
     char message[JOURNALD_MAX_FIELD_SIZE + 1];
 
     if (abrt_journal_get_string_field(abrt_journal_watch_get_journal(watch), "MESSAGE", (char *)message) == NULL)
         error_msg_and_die("Cannot read journal data.");
 
-    GList *cur = conf->strings;
-    for (; cur; cur = g_list_next(cur))
-        if (strstr(message, cur->data) != NULL)
-            break;
+    const unsigned found = strings_matcher_scan(conf->matcher, message, strlen(message),
+                                                /*stop at*/NOTIFY_STRING_BLACKLISTED, NULL);
 
-    GList *blacklist_cur = conf->blacklisted_strings;
-    if (cur)
-        for (; blacklist_cur; blacklist_cur = g_list_next(blacklist_cur))
-            if (strstr(message, blacklist_cur->data) != NULL)
-                break;
-
-    if (cur && !blacklist_cur)
+    if (found == NOTIFY_STRING_FOUND)
         conf->decorated_cb(watch, conf->decorated_cb_data);
 }
 
+void abrt_journal_watch_notify_strings_destroy(struct abrt_journal_watch_notify_strings *conf)
+{
+    strings_matcher_free(conf->matcher);
+    conf->matcher = NULL;
+}
+
 /*
  * ABRT systemd-journal strings notifier - end
  */
+
+/*
+ * ABRT systemd-journal scanner
+ */
+
+struct abrt_journal_match
+{
+    char *field;
+    char *value;
+    size_t value_len;
+};
+
+struct abrt_journal_scanner_extractor
+{
+    struct abrt_journal_extractor *extractor;
+    /* struct abrt_journal_match sorted by field */
+    GArray *matches;
+    /* Messages up to the message at this cursor were processed in the
+     * previous run */
+    char *resume_cursor;
+    /* Messages not newer than this are skipped ('-e' without a cursor) */
+    uint64_t skip_until_usec;
+    /* Cursor of the last passed message and whether it has been saved */
+    char *cursor;
+    bool cursor_saved;
+    /* The extractor waits for the idle call back */
+    bool pending;
+};
+
+struct abrt_journal_scanner
+{
+    abrt_journal_t *journal;
+    GPtrArray *extractors; /* struct abrt_journal_scanner_extractor */
+    bool stopped;
+};
+
+static int abrt_journal_match_cmp(gconstpointer a, gconstpointer b)
+{
+    return strcmp(((const struct abrt_journal_match *)a)->field,
+                  ((const struct abrt_journal_match *)b)->field);
+}
+
+static void abrt_journal_scanner_extractor_free(struct abrt_journal_scanner_extractor *ex)
+{
+    for (unsigned i = 0; i < ex->matches->len; ++i)
+        free(g_array_index(ex->matches, struct abrt_journal_match, i).field);
+    g_array_free(ex->matches, TRUE);
+    free(ex->resume_cursor);
+    free(ex->cursor);
+    free(ex);
+}
+
+int abrt_journal_scanner_new(abrt_journal_scanner_t **scanner, abrt_journal_t *journal)
+{
+    *scanner = xzalloc(sizeof(**scanner));
+    (*scanner)->journal = journal;
+    (*scanner)->extractors = g_ptr_array_new_with_free_func((GDestroyNotify)abrt_journal_scanner_extractor_free);
+    return 0;
+}
+
+void abrt_journal_scanner_free(abrt_journal_scanner_t *scanner)
+{
+    if (scanner == NULL)
+        return;
+
+    g_ptr_array_free(scanner->extractors, TRUE);
+    free(scanner);
+}
+
+int abrt_journal_scanner_add_extractor(abrt_journal_scanner_t *scanner, struct abrt_journal_extractor *extractor)
+{
+    assert(extractor->message_cb != NULL || !"ABRT journal extractor needs valid callback ptr");
+
+    struct abrt_journal_scanner_extractor *ex = xzalloc(sizeof(*ex));
+    ex->extractor = extractor;
+    ex->matches = g_array_new(FALSE, FALSE, sizeof(struct abrt_journal_match));
+    ex->cursor_saved = true;
+
+    for (GList *l = extractor->matches; l != NULL; l = l->next)
+    {
+        const char *filter = l->data;
+        const char *eq = strchr(filter, '=');
+        if (eq == NULL || eq == filter)
+        {
+            error_msg(_("Invalid journal filter '%s' of '%s'"), filter, extractor->name);
+            abrt_journal_scanner_extractor_free(ex);
+            return -EINVAL;
+        }
+
+        struct abrt_journal_match match;
+        match.field = xstrdup(filter);
+        match.field[eq - filter] = '\0';
+        match.value = match.field + (eq - filter) + 1;
+        match.value_len = strlen(match.value);
+        g_array_append_val(ex->matches, match);
+    }
+    g_array_sort(ex->matches, abrt_journal_match_cmp);
+
+    /* Messages of all extractors are read, i.e. the extractors' matches are
+     * joined with OR */
+    if (scanner->extractors->len != 0)
+    {
+        const int r = sd_journal_add_disjunction(scanner->journal->j);
+        if (r < 0)
+        {
+            log_notice("Failed to add journal disjunction: %s", strerror(-r));
+            abrt_journal_scanner_extractor_free(ex);
+            return r;
+        }
+    }
+
+    const int r = abrt_journal_set_journal_filter(scanner->journal, extractor->matches);
+    if (r < 0)
+    {
+        abrt_journal_scanner_extractor_free(ex);
+        return r;
+    }
+
+    g_ptr_array_add(scanner->extractors, ex);
+    return 0;
+}
+
+/* Journal semantics: the values of a field are ORed and the fields are ANDed */
+static bool abrt_journal_scanner_extractor_matches(abrt_journal_t *journal, struct abrt_journal_scanner_extractor *ex)
+{
+    unsigned i = 0;
+    while (i < ex->matches->len)
+    {
+        const struct abrt_journal_match *first = &g_array_index(ex->matches, struct abrt_journal_match, i);
+
+        const char *data = NULL;
+        size_t data_len = 0;
+        const int r = sd_journal_get_data(journal->j, first->field, (const void **)&data, &data_len);
+
+        bool found = false;
+        for (; i < ex->matches->len; ++i)
+        {
+            const struct abrt_journal_match *m = &g_array_index(ex->matches, struct abrt_journal_match, i);
+            if (strcmp(m->field, first->field) != 0)
+                break;
+
+            /* data is "FIELD=value" */
+            const size_t pfx_len = strlen(m->field) + 1;
+            found = found || (r >= 0
+                              && data_len == pfx_len + m->value_len
+                              && memcmp(data + pfx_len, m->value, m->value_len) == 0);
+        }
+
+        if (!found)
+            return false;
+    }
+
+    return true;
+}
+
+/* Gets the time stamp of the message at the cursor */
+static int abrt_journal_cursor_usec(abrt_journal_t *journal, const char *cursor, uint64_t *usec)
+{
+    int r = sd_journal_seek_cursor(journal->j, cursor);
+    if (r >= 0)
+        r = sd_journal_next(journal->j);
+    if (r > 0)
+        r = sd_journal_test_cursor(journal->j, cursor);
+    if (r > 0)
+        r = sd_journal_get_realtime_usec(journal->j, usec);
+    else if (r == 0)
+        r = -ENOENT;
+
+    return r;
+}
+
+int abrt_journal_scanner_restore_positions(abrt_journal_scanner_t *scanner, bool from_tail)
+{
+    uint64_t now_usec = g_get_real_time();
+    uint64_t start_usec = UINT64_MAX;
+    bool from_head = false;
+
+    for (unsigned i = 0; i < scanner->extractors->len; ++i)
+    {
+        struct abrt_journal_scanner_extractor *ex = g_ptr_array_index(scanner->extractors, i);
+
+        char *cursor = ex->extractor->state_file ? abrt_journal_load_cursor(ex->extractor->state_file) : NULL;
+        if (cursor != NULL)
+        {
+            /* The time stamp is used only to find the start of reading,
+             * several messages can share it */
+            uint64_t cursor_usec;
+            const int r = abrt_journal_cursor_usec(scanner->journal, cursor, &cursor_usec);
+            if (r >= 0)
+            {
+                log_debug("%s continues after %s", ex->extractor->name, cursor);
+                ex->resume_cursor = cursor;
+                start_usec = MIN(start_usec, cursor_usec);
+                continue;
+            }
+
+            error_msg(_("Failed to move the journal to a cursor from file '%s'"), ex->extractor->state_file);
+            free(cursor);
+        }
+
+        if (from_tail)
+        {
+            ex->skip_until_usec = now_usec;
+            start_usec = MIN(start_usec, now_usec);
+        }
+        else
+            from_head = true;
+    }
+
+    int r;
+    if (from_head || start_usec == UINT64_MAX)
+        r = sd_journal_seek_head(scanner->journal->j);
+    else
+        r = sd_journal_seek_realtime_usec(scanner->journal->j, start_usec);
+
+    if (r < 0)
+        log_notice("Failed to seek journal: %s", strerror(-r));
+
+    return r;
+}
+
+static void abrt_journal_scanner_save_positions(abrt_journal_scanner_t *scanner)
+{
+    for (unsigned i = 0; i < scanner->extractors->len; ++i)
+    {
+        struct abrt_journal_scanner_extractor *ex = g_ptr_array_index(scanner->extractors, i);
+        if (ex->cursor_saved || ex->extractor->state_file == NULL)
+            continue;
+
+        ex->cursor_saved = abrt_journal_save_cursor(ex->extractor->state_file, ex->cursor) == 0;
+    }
+}
+
+/* Lets the extractors finish analysis of the passed messages */
+static void abrt_journal_scanner_idle(abrt_journal_scanner_t *scanner)
+{
+    for (unsigned i = 0; i < scanner->extractors->len; ++i)
+    {
+        struct abrt_journal_scanner_extractor *ex = g_ptr_array_index(scanner->extractors, i);
+        if (!ex->pending)
+            continue;
+
+        ex->pending = false;
+        if (ex->extractor->idle_cb != NULL)
+            ex->extractor->idle_cb(scanner->journal, ex->extractor->data);
+    }
+}
+
+/* Passes the current message to the interested extractors */
+static void abrt_journal_scanner_dispatch(abrt_journal_scanner_t *scanner)
+{
+    uint64_t usec = 0;
+    if (sd_journal_get_realtime_usec(scanner->journal->j, &usec) < 0)
+        usec = UINT64_MAX;
+
+    char *cursor = NULL;
+    for (unsigned i = 0; i < scanner->extractors->len; ++i)
+    {
+        struct abrt_journal_scanner_extractor *ex = g_ptr_array_index(scanner->extractors, i);
+
+        if (ex->resume_cursor != NULL)
+        {
+            /* Skip the messages up to and including the last seen one */
+            if (sd_journal_test_cursor(scanner->journal->j, ex->resume_cursor) > 0)
+            {
+                log_debug("%s reached its last seen message", ex->extractor->name);
+                free(ex->resume_cursor);
+                ex->resume_cursor = NULL;
+            }
+            continue;
+        }
+
+        if (usec <= ex->skip_until_usec)
+            continue;
+
+        if (!abrt_journal_scanner_extractor_matches(scanner->journal, ex))
+            continue;
+
+        if (ex->extractor->message_cb(scanner->journal, ex->extractor->data))
+            ex->pending = true;
+
+        if (cursor == NULL && abrt_journal_get_cursor(scanner->journal, &cursor) < 0)
+            continue;
+
+        free(ex->cursor);
+        ex->cursor = xstrdup(cursor);
+        ex->cursor_saved = false;
+    }
+
+    free(cursor);
+}
+
+/* The last seen messages must have been passed before the end of journal.
+ * If some of them were not, e.g. the journal was rotated, the extractors
+ * continue with the new messages. */
+static void abrt_journal_scanner_resume_all(abrt_journal_scanner_t *scanner)
+{
+    for (unsigned i = 0; i < scanner->extractors->len; ++i)
+    {
+        struct abrt_journal_scanner_extractor *ex = g_ptr_array_index(scanner->extractors, i);
+        if (ex->resume_cursor == NULL)
+            continue;
+
+        log_warning(_("The last seen message of '%s' was not found, continuing with new messages"),
+                    ex->extractor->name);
+        free(ex->resume_cursor);
+        ex->resume_cursor = NULL;
+    }
+}
+
+static bool abrt_journal_scanner_pending(abrt_journal_scanner_t *scanner)
+{
+    for (unsigned i = 0; i < scanner->extractors->len; ++i)
+        if (((struct abrt_journal_scanner_extractor *)g_ptr_array_index(scanner->extractors, i))->pending)
+            return true;
+
+    return false;
+}
+
+int abrt_journal_scanner_run_sync(abrt_journal_scanner_t *scanner, bool follow)
+{
+    sigset_t mask;
+    sigfillset(&mask);
+
+    /* Exit gracefully: */
+    /* services usually exit on SIGTERM and SIGHUP */
+    sigdelset(&mask, SIGTERM);
+    signal(SIGTERM, signal_loop_to_terminate);
+    sigdelset(&mask, SIGHUP);
+    signal(SIGHUP, signal_loop_to_terminate);
+    /* Ctrl-C for easier debugging */
+    sigdelset(&mask, SIGINT);
+    signal(SIGINT, signal_loop_to_terminate);
+
+    /* Die on kill $PID */
+    sigdelset(&mask, SIGKILL);
+
+    struct pollfd pollfd;
+    pollfd.fd = sd_journal_get_fd(scanner->journal->j);
+    pollfd.events = sd_journal_get_events(scanner->journal->j);
+
+    int r = 0;
+    while (!s_loop_terminated && !scanner->stopped)
+    {
+        r = sd_journal_next(scanner->journal->j);
+        if (r < 0)
+        {
+            log_warning("Failed to iterate to next entry: %s", strerror(-r));
+            break;
+        }
+        else if (r > 0)
+        {
+            abrt_journal_scanner_dispatch(scanner);
+            continue;
+        }
+
+        /* All messages have been read */
+        abrt_journal_scanner_resume_all(scanner);
+        if (!follow)
+            break;
+
+        const bool pending = abrt_journal_scanner_pending(scanner);
+        if (!pending)
+            abrt_journal_scanner_save_positions(scanner);
+
+        /* Give systemd-journal one second to suck in the rest of the
+         * messages the extractors wait for */
+        struct timespec timeout = { .tv_sec = 1, .tv_nsec = 0 };
+        const int p = ppoll(&pollfd, 1, pending ? &timeout : NULL, &mask);
+        if (p == 0)
+        {
+            abrt_journal_scanner_idle(scanner);
+            continue;
+        }
+
+        r = sd_journal_process(scanner->journal->j);
+        if (r < 0)
+        {
+            log_warning("Failed to get journal changes: %s\n", strerror(-r));
+            break;
+        }
+        r = 0;
+    }
+
+    abrt_journal_scanner_idle(scanner);
+    if (follow)
+        abrt_journal_scanner_save_positions(scanner);
+
+    return r;
+}
+
+void abrt_journal_scanner_stop(abrt_journal_scanner_t *scanner)
+{
+    scanner->stopped = true;
+}
+
+/*
+ * ABRT systemd-journal scanner - end
+ */
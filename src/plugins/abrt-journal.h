@@ -16,6 +16,8 @@
 #define _ABRT_JOURNAL_H_
 
 #include <glib.h>
+#include <stdbool.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -68,7 +70,12 @@ char *abrt_journal_get_string_field(abrt_journal_t *journal,
 
 char *abrt_journal_get_log_line(abrt_journal_t *journal);
 
-char *abrt_journal_get_next_log_line(void *data);
+/* Returns MESSAGE field data which are not NUL terminated and which are valid
+ * only until the journal position changes */
+const char *abrt_journal_get_log_line_data(abrt_journal_t *journal, size_t *len);
+
+/* Moves to the next message, can be passed to process_xorg_bt() */
+const char *abrt_journal_get_next_log_line_data(void *data, size_t *len);
 
 int abrt_journal_get_cursor(abrt_journal_t *journal, char **cursor);
 
@@ -76,6 +83,9 @@ int abrt_journal_set_cursor(abrt_journal_t *journal, const char *cursor);
 
 int abrt_journal_seek_tail(abrt_journal_t *journal);
 
+/* Returns a positive number if the current message is at the cursor */
+int abrt_journal_test_cursor(abrt_journal_t *journal, const char *cursor);
+
 int abrt_journal_next(abrt_journal_t *journal);
 
 int abrt_journal_save_current_position(abrt_journal_t *journal,
@@ -106,6 +116,22 @@ void abrt_journal_watch_free(abrt_journal_watch_t *watch);
  */
 abrt_journal_t *abrt_journal_watch_get_journal(abrt_journal_watch_t *watch);
 
+/*
+ * Enables coalescing of position saves done by abrt_journal_watch_checkpoint().
+ * The position is saved in file_name after max_count processed messages, at
+ * latest max_interval seconds after the first unsaved one and when the loop
+ * in abrt_journal_watch_run_sync() terminates.
+ */
+void abrt_journal_watch_set_checkpoint(abrt_journal_watch_t *watch,
+                                       const char *file_name,
+                                       unsigned max_count,
+                                       unsigned max_interval);
+
+/*
+ * Marks the current message as processed.
+ */
+void abrt_journal_watch_checkpoint(abrt_journal_watch_t *watch);
+
 /*
  * Starts reading journal messages and waiting for new messages in a loop.
  *
@@ -130,10 +156,77 @@ struct abrt_journal_watch_notify_strings
     void *decorated_cb_data;
     GList *strings;
     GList *blacklisted_strings;
+    /* Built from the lists above on the first message */
+    struct abrt_strings_matcher *matcher;
 };
 
 void abrt_journal_watch_notify_strings(abrt_journal_watch_t *watch, void *data);
 
+/*
+ * Releases the resources allocated by abrt_journal_watch_notify_strings()
+ */
+void abrt_journal_watch_notify_strings_destroy(struct abrt_journal_watch_notify_strings *conf);
+
+/*
+ * A systemd-journal scanner which reads every message once and passes it to
+ * all extractors interested in the message. Each extractor has its own last
+ * seen position.
+ */
+struct abrt_journal_extractor
+{
+    /* Used in messages */
+    const char *name;
+    /* Journal filters, e.g. 'SYSLOG_IDENTIFIER=kernel'. A message passes if it
+     * matches one of the filters of every field. */
+    GList *matches;
+    /* Called for every message passing the filters with the journal moved to
+     * the message. Returns true if the extractor holds data of the message
+     * that will be processed in idle_cb. */
+    bool (*message_cb)(abrt_journal_t *journal, void *data);
+    /* Called after one second without new messages if message_cb returned
+     * true since the last call and before the scanner returns. */
+    void (*idle_cb)(abrt_journal_t *journal, void *data);
+    void *data;
+    /* Where the last seen position is saved when following journal; may be
+     * NULL */
+    const char *state_file;
+};
+
+struct abrt_journal_scanner;
+typedef struct abrt_journal_scanner abrt_journal_scanner_t;
+
+int abrt_journal_scanner_new(abrt_journal_scanner_t **scanner, abrt_journal_t *journal);
+
+void abrt_journal_scanner_free(abrt_journal_scanner_t *scanner);
+
+/*
+ * Adds the extractor's filters to the journal's filter. The extractor must
+ * exist until the scanner is freed.
+ */
+int abrt_journal_scanner_add_extractor(abrt_journal_scanner_t *scanner,
+                                       struct abrt_journal_extractor *extractor);
+
+/*
+ * Moves the journal to the oldest last seen position of the extractors.
+ * Extractors without the last seen position start from the beginning of
+ * journal or from the end if from_tail is true.
+ */
+int abrt_journal_scanner_restore_positions(abrt_journal_scanner_t *scanner,
+                                           bool from_tail);
+
+/*
+ * Reads journal messages until the end of journal or, if follow is true,
+ * waits for new messages in a loop and saves the last seen positions.
+ *
+ * SIGTERM and SIGINT terminates the loop gracefully.
+ */
+int abrt_journal_scanner_run_sync(abrt_journal_scanner_t *scanner, bool follow);
+
+/*
+ * Can be used to terminate the loop in abrt_journal_scanner_run_sync()
+ */
+void abrt_journal_scanner_stop(abrt_journal_scanner_t *scanner);
+
 #ifdef __cplusplus
 }
 #endif
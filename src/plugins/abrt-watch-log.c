@@ -17,34 +17,212 @@
     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 #include <sys/inotify.h>
+#include <poll.h>
 #include "libabrt.h"
+#include "oops-utils.h"
+#include "xorg-utils.h"
 
 #define MAX_SCAN_BLOCK  (4*1024*1024)
 #define READ_AHEAD          (10*1024)
+/* The initial size of the scanner's read buffer */
+#define READ_BLOCK          (64*1024)
 
-static unsigned page_size;
+/* A burst of log lines is considered complete after this many milliseconds
+ * without a change of the log */
+#define SETTLE_TIMEOUT_MS   200
+/* ... but a log which never stops growing is processed at least this often */
+#define MAX_SETTLE_MS       1000
 
-static bool memstr(void *buf, unsigned size, const char *str)
+#define ABRT_DUMP_OOPS_ANALYZER "abrt-oops"
+
+static volatile sig_atomic_t s_terminated;
+
+static void handle_signal(int signo)
+{
+    s_terminated = 1;
+}
+
+/*
+ * In-process log scanners
+ *
+ * The complete lines are passed to the scanner as soon as they are written.
+ * The scanner analyzes the lines it holds when the log stays quiet for
+ * SETTLE_TIMEOUT_MS.
+ */
+struct log_scanner
+{
+    const char *name;
+    /* Gets a complete line without the new line character. The line can be
+     * modified but not kept. Returns true if the scanner holds data for idle
+     * call back. */
+    bool (*line_cb)(char *line);
+    void (*idle_cb)(void);
+};
+
+static const char *s_dump_location;
+static bool s_world_readable;
+static bool s_throttle_creation;
+
+static struct abrt_koops_parser *s_koops_parser;
+static GList *s_oopses;
+
+static bool oops_scanner_line(char *line)
+{
+    koops_parser_feed_syslog_line(s_koops_parser, &s_oopses, line);
+    return true;
+}
+
+static void oops_scanner_idle(void)
+{
+    koops_parser_finish(s_koops_parser, &s_oopses);
+    if (s_oopses == NULL)
+        return;
+
+    const int flags = (s_world_readable ? ABRT_OOPS_WORLD_READABLE : 0)
+                    | (s_throttle_creation ? ABRT_OOPS_THROTTLE_CREATION : 0);
+    abrt_oops_process_list(s_oopses, s_dump_location, ABRT_DUMP_OOPS_ANALYZER, flags);
+
+    g_list_free_full(s_oopses, (GDestroyNotify)free);
+    s_oopses = NULL;
+}
+
+static struct xorg_crash_collector s_xorg_collector = XORG_CRASH_COLLECTOR_INIT;
+
+static void xorg_scanner_idle(void)
 {
-    int len = strlen(str);
-    while ((int)size >= len)
+    GList *crashes = xorg_crash_collector_finish(&s_xorg_collector);
+    for (GList *iter = crashes; iter != NULL; iter = g_list_next(iter))
     {
-        //log("LOOKING FOR:'%s'", str);
-        char *first = memchr(buf, (unsigned char)str[0], size - len + 1);
-        if (!first)
+        xorg_crash_info_create_dump_dir(iter->data, s_dump_location, s_world_readable);
+
+        if (s_throttle_creation && abrt_xorg_signaled_sleep(1) > 0)
             break;
-        //log("FOUND:'%.66s'", first);
-        first++;
-        if (len <= 1 || strncmp(first, str + 1, len - 1) == 0)
-            return true;
-        size -= (first - (char*)buf);
-        //log("SKIP TO:'%.66s' %d chars", first, (int)(first - (char*)buf));
-        buf = first;
     }
+    g_list_free_full(crashes, (GDestroyNotify)xorg_crash_info_free);
+}
+
+static bool xorg_scanner_line(char *line)
+{
+    const unsigned collected = xorg_crash_collector_feed(&s_xorg_collector, line, strlen(line));
+    if (collected == 0)
+        return false;
+
+    if (collected < XORG_MAX_COLLECTED_LINES)
+        return true;
+
+    xorg_scanner_idle();
     return false;
 }
 
-static void run_scanner_prog(int fd, struct stat *statbuf, GList *match_list, char **prog)
+static const struct log_scanner s_scanners[] = {
+    { "oops", oops_scanner_line, oops_scanner_idle },
+    { "xorg", xorg_scanner_line, xorg_scanner_idle },
+};
+
+/*
+ * Passes the complete lines between the current position and the end of the
+ * file to the scanner and moves the position behind the last complete line.
+ *
+ * Returns true if the scanner holds data for its idle call back.
+ */
+static bool run_scanner(int fd, struct stat *statbuf, const struct log_scanner *scanner)
+{
+    /* fstat(fd, &statbuf) was just done by caller */
+
+    off_t cur_pos = lseek(fd, 0, SEEK_CUR);
+    if (statbuf->st_size <= cur_pos)
+    {
+        /* If file was truncated, treat it as a new file.
+         * (changing inode# causes caller to think that file was closed or renamed)
+         */
+        if (statbuf->st_size < cur_pos)
+            statbuf->st_ino++;
+        return false; /* we are at EOF, nothing to do */
+    }
+
+    log_info("File grew by %llu bytes, from %llu to %llu",
+        (long long)(statbuf->st_size - cur_pos),
+        (long long)(cur_pos),
+        (long long)(statbuf->st_size));
+
+    /* The log is read rather than mapped, because accessing a mapping of
+     * a truncated file kills the process by SIGBUS */
+    static char *buf;
+    static size_t buf_size;
+    /* Bytes in buf, they start at cur_pos */
+    size_t len = 0;
+
+    bool pending = false;
+    while (cur_pos + (off_t)len < statbuf->st_size)
+    {
+        if (len == buf_size)
+        {
+            /* A line longer than the whole block is not a log line */
+            if (buf_size >= MAX_SCAN_BLOCK)
+            {
+                cur_pos += len;
+                len = 0;
+                continue;
+            }
+
+            buf_size = buf_size ? buf_size * 2 : READ_BLOCK;
+            buf = xrealloc(buf, buf_size);
+        }
+
+        const size_t want = MIN(buf_size - len, (size_t)(statbuf->st_size - cur_pos - len));
+        const ssize_t r = pread(fd, buf + len, want, cur_pos + len);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r < 0)
+            perror_msg("Can't read the log file");
+        if (r <= 0)
+            break; /* the file was truncated in the meantime */
+
+        len += r;
+
+        char *line = buf;
+        char *eol;
+        while ((eol = memchr(line, '\n', buf + len - line)) != NULL)
+        {
+            *eol = '\0';
+            pending = scanner->line_cb(line) || pending;
+            line = eol + 1;
+        }
+
+        /* Keep the incomplete line */
+        const size_t consumed = line - buf;
+        memmove(buf, line, len - consumed);
+        len -= consumed;
+        cur_pos += consumed;
+    }
+
+    lseek(fd, cur_pos, SEEK_SET);
+    return pending;
+}
+
+/*
+ * Waits for inotify events; returns false if the timeout expired
+ */
+static bool wait_for_change(int inotify_fd, int timeout_ms)
+{
+    struct pollfd pfd = { .fd = inotify_fd, .events = POLLIN };
+    const int r = poll(&pfd, 1, timeout_ms);
+    if (r < 0 && errno != EINTR) /* I saw EINTR here on strace attach */
+        perror_msg("Error polling inotify fd");
+    if (r <= 0)
+        return false;
+
+    /* we don't actually check what happened to file -
+     * the code will handle all possibilities.
+     */
+    char buf[4096];
+    while (read(inotify_fd, buf, sizeof(buf)) > 0)
+        continue;
+
+    return true;
+}
+
+static void run_scanner_prog(int fd, struct stat *statbuf, struct abrt_strings_matcher *matcher, char **prog)
 {
     /* fstat(fd, &statbuf) was just done by caller */
 
@@ -64,37 +242,41 @@ static void run_scanner_prog(int fd, struct stat *statbuf, GList *match_list, ch
         (long long)(cur_pos),
         (long long)(statbuf->st_size));
 
-    if (match_list && (statbuf->st_size - cur_pos) < MAX_SCAN_BLOCK)
+    if (matcher && (statbuf->st_size - cur_pos) < MAX_SCAN_BLOCK)
     {
+        /* Read, not mapped: a mapping of a truncated file raises SIGBUS */
         size_t length = statbuf->st_size - cur_pos;
+        char *start = xmalloc(length);
+        size_t have = 0;
+        while (have < length)
+        {
+            const ssize_t r = pread(fd, start + have, length - have, cur_pos + have);
+            if (r < 0 && errno == EINTR)
+                continue;
+            if (r <= 0)
+                break;
+            have += r;
+        }
 
-        off_t mapofs = cur_pos & ~(off_t)(page_size - 1);
-        size_t maplen = statbuf->st_size - mapofs;
-        void *map = mmap(NULL, maplen, PROT_READ, MAP_SHARED, fd, mapofs);
-
-        if (map != MAP_FAILED)
+        if (have != 0)
         {
-            char *start = (char*)map + (cur_pos & (page_size - 1));
-            for (GList *l = match_list; l; l = l->next)
+            log_debug("Searching in '%.*s'", have > 20 ? 20 : (int)have, start);
+
+            /* All strings are searched for in a single pass */
+            const char *matched;
+            if (strings_matcher_scan(matcher, start, have, /*stop at*/1, &matched))
             {
-                log_debug("Searching for '%s' in '%.*s'",
-                                (char*)l->data,
-                                length > 20 ? 20 : (int)length, start
-                );
-                if (memstr(start, length, (char*)l->data))
-                {
-                    log_debug("FOUND:'%s'", (char*)l->data);
-                    goto found;
-                }
+                log_debug("FOUND:'%s'", matched);
+                goto found;
             }
             /* None of the strings are found */
             log_debug("NOT FOUND");
-            munmap(map, maplen);
-            lseek(fd, statbuf->st_size, SEEK_SET);
+            free(start);
+            lseek(fd, cur_pos + have, SEEK_SET);
             return;
- found: ;
-            munmap(map, maplen);
         }
+ found:
+        free(start);
     }
 
     fflush(NULL); /* paranoia */
@@ -133,25 +315,40 @@ int main(int argc, char **argv)
 
     abrt_init(argv);
 
-    page_size = sysconf(_SC_PAGE_SIZE);
-
     GList *match_list = NULL;
 
     /* Can't keep these strings/structs static: _() doesn't support that */
     const char *program_usage_string = _(
         "& [-vs] [-F STR]... FILE PROG [ARGS]\n"
+        "or: & [-vsxt] [-d DIR]/[-D] -S SCANNER FILE\n"
+        "\n"
+        "Watch log file FILE, run PROG when it grows or is replaced\n"
         "\n"
-        "Watch log file FILE, run PROG when it grows or is replaced"
+        "With -S, the built-in SCANNER ('oops' or 'xorg') analyzes the new lines\n"
+        "instead of PROG"
     );
     enum {
         OPT_v = 1 << 0,
         OPT_s = 1 << 1,
+        OPT_F = 1 << 2,
+        OPT_S = 1 << 3,
+        OPT_d = 1 << 4,
+        OPT_D = 1 << 5,
+        OPT_x = 1 << 6,
+        OPT_t = 1 << 7,
     };
+    const char *scanner_name = NULL;
+    char *dump_location = NULL;
     /* Keep enum above and order of options below in sync! */
     struct options program_options[] = {
         OPT__VERBOSE(&g_verbose),
         OPT_BOOL('s', NULL, NULL              , _("Log to syslog")),
         OPT_LIST('F', NULL, &match_list, "STR", _("Don't run PROG if STRs aren't found")),
+        OPT_STRING('S', NULL, &scanner_name, "SCANNER", _("Analyze new lines with the built-in SCANNER")),
+        OPT_STRING('d', NULL, &dump_location, "DIR", _("Create new problem directory in DIR for every problem found")),
+        OPT_BOOL(  'D', NULL, NULL, _("Same as -d DumpLocation, DumpLocation is specified in abrt.conf")),
+        OPT_BOOL(  'x', NULL, NULL, _("Make the problem directory world readable")),
+        OPT_BOOL(  't', NULL, NULL, _("Throttle problem directory creation to 1 per second")),
         OPT_END()
     };
     unsigned opts = parse_opts(argc, argv, program_options, program_usage_string);
@@ -165,9 +362,47 @@ int main(int argc, char **argv)
     }
 
     argv += optind;
-    if (!argv[0] || !argv[1])
+    if (!argv[0] || (!scanner_name && !argv[1]) || (scanner_name && argv[1]))
         show_usage_and_die(program_usage_string, program_options);
 
+    const struct log_scanner *scanner = NULL;
+    if (scanner_name)
+    {
+        for (size_t i = 0; i < ARRAY_SIZE(s_scanners); ++i)
+            if (strcmp(s_scanners[i].name, scanner_name) == 0)
+                scanner = &s_scanners[i];
+
+        if (scanner == NULL)
+            error_msg_and_die(_("Unknown scanner '%s'"), scanner_name);
+
+        if (opts & OPT_D)
+        {
+            if (opts & OPT_d)
+                show_usage_and_die(program_usage_string, program_options);
+            load_abrt_conf();
+            dump_location = g_settings_dump_location;
+            g_settings_dump_location = NULL;
+            free_abrt_conf_data();
+        }
+
+        s_dump_location = dump_location;
+        s_world_readable = (opts & OPT_x);
+        s_throttle_creation = (opts & OPT_t);
+        s_koops_parser = koops_parser_new();
+
+        if (match_list)
+            log_notice("Ignoring -F, the scanner reads all lines");
+        g_list_free(match_list);
+        match_list = NULL;
+
+        /* Exit gracefully, the scanner may hold lines of an oops: */
+        /* services usually exit on SIGTERM and SIGHUP */
+        signal(SIGTERM, handle_signal);
+        signal(SIGHUP, handle_signal);
+        /* Ctrl-C for easier debugging */
+        signal(SIGINT, handle_signal);
+    }
+
     /* We want to support -F "`echo foo; echo bar`" -
      * need to split strings by newline, and be careful about
      * possible last empty string: "foo\nbar\n" = "foo", "bar",
@@ -184,18 +419,36 @@ int main(int argc, char **argv)
         l = g_list_append(l, eol); /* in fact, always returns unchanged l */
     }
 
+    struct abrt_strings_matcher *matcher = NULL;
+    if (match_list)
+    {
+        matcher = strings_matcher_new();
+        strings_matcher_add_list(matcher, match_list, 1);
+        strings_matcher_compile(matcher);
+    }
+
     const char *filename = *argv++;
+    char *dir_name = g_path_get_dirname(filename);
 
-    int inotify_fd = inotify_init();
+    int inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
     if (inotify_fd == -1)
         perror_msg_and_die("inotify_init failed");
-    close_on_exec_on(inotify_fd);
+
+    /* The directory is watched for creation of the file, so a missing or
+     * rotated file is opened as soon as it appears */
+    int wd_dir = inotify_add_watch(inotify_fd, dir_name, IN_CREATE | IN_MOVED_TO);
+    if (wd_dir < 0)
+        perror_msg("inotify_add_watch failed on '%s'", dir_name);
 
     struct stat statbuf;
     int file_fd = -1;
     int wd = -1;
+    /* The scanner holds lines waiting for the log to settle */
+    bool pending = false;
+    /* When the scanner got the first of the lines it holds */
+    gint64 pending_since = 0;
 
-    while (1)
+    while (!s_terminated)
     {
         /* If file is already opened, scan it from current pos */
         if (file_fd >= 0)
@@ -203,7 +456,10 @@ int main(int argc, char **argv)
             memset(&statbuf, 0, sizeof(statbuf));
             if (fstat(file_fd, &statbuf) != 0)
                 goto close_fd;
-            run_scanner_prog(file_fd, &statbuf, match_list, argv);
+            if (scanner)
+                pending = run_scanner(file_fd, &statbuf, scanner) || pending;
+            else
+                run_scanner_prog(file_fd, &statbuf, matcher, argv);
 
             /* Was file deleted or replaced? */
             ino_t fd_ino = statbuf.st_ino;
@@ -222,7 +478,7 @@ int main(int argc, char **argv)
         /* If file isn't opened, try to open it and scan */
         if (file_fd < 0)
         {
-            file_fd = open(filename, O_RDONLY);
+            file_fd = open(filename, O_RDONLY | O_CLOEXEC);
             if (file_fd >= 0)
             {
                 log_info("Opened '%s'", filename);
@@ -246,38 +502,72 @@ int main(int argc, char **argv)
                     /* Note that statbuf is filled by fstat by now,
                      * run_scanner_prog needs that
                      */
-                    run_scanner_prog(file_fd, &statbuf, match_list, argv);
+                    if (scanner)
+                        pending = run_scanner(file_fd, &statbuf, scanner) || pending;
+                    else
+                        run_scanner_prog(file_fd, &statbuf, matcher, argv);
                 }
             }
         }
 
-        /* Even if log file grows all the time, say, a new line every 5 ms,
-         * we don't want to scan it all the time. Sleep a bit and let it grow
-         * in bigger increments.
-         * Sleep longer if file does not exist.
+        if (pending && pending_since == 0)
+            pending_since = g_get_monotonic_time();
+
+        /* A log which keeps growing never settles */
+        const gint64 pending_ms = pending ? (g_get_monotonic_time() - pending_since) / 1000 : 0;
+        if (pending && pending_ms >= MAX_SETTLE_MS)
+        {
+            log_debug("'%s' keeps growing, analyzing the lines", filename);
+            scanner->idle_cb();
+            pending = false;
+            pending_since = 0;
+        }
+
+        /* Now wait for it to change, be moved, deleted or created.
+         * Fall back to polling if inotify can't tell us.
          */
-        sleep(file_fd >= 0 ? 1 : 59);
+        int timeout_ms = -1;
+        if (pending)
+            timeout_ms = MIN(SETTLE_TIMEOUT_MS, MAX_SETTLE_MS - pending_ms);
+        else if (file_fd >= 0 && wd < 0)
+            timeout_ms = 1000;
+        else if (file_fd < 0 && wd_dir < 0)
+            timeout_ms = 59 * 1000;
+
+        log_debug("Waiting for '%s' to change", filename);
+        if (!wait_for_change(inotify_fd, timeout_ms))
+        {
+            if (pending)
+            {
+                log_debug("'%s' settled", filename);
+                scanner->idle_cb();
+                pending = false;
+                pending_since = 0;
+            }
+            continue;
+        }
+        log_debug("Change in '%s' detected", filename);
+
+        if (scanner)
+            continue;
 
-        /* Now wait for it to change, be moved or deleted */
-        if (wd >= 0)
+        /* Let them finish writing to the log file. otherwise
+         * we may end up trying to analyze partial oops.
+         * Even if log file grows all the time, say, a new line every 5 ms,
+         * we don't want to run PROG all the time.
+         */
+        for (int waited_ms = 0;
+             waited_ms < MAX_SETTLE_MS && wait_for_change(inotify_fd, SETTLE_TIMEOUT_MS);
+             waited_ms += SETTLE_TIMEOUT_MS)
         {
-            char buf[4096];
-            log_debug("Waiting for '%s' to change", filename);
-            /* We block here: */
-            int len = read(inotify_fd, buf, sizeof(buf));
-            if (len < 0 && errno != EINTR) /* I saw EINTR here on strace attach */
-                perror_msg("Error reading inotify fd");
-            /* we don't actually check what happened to file -
-             * the code will handle all possibilities.
-             */
-            log_debug("Change in '%s' detected", filename);
-            /* Let them finish writing to the log file. otherwise
-             * we may end up trying to analyze partial oops.
-             */
-            sleep(1);
+            continue;
         }
 
-    } /* while (1) */
+    } /* while (!s_terminated) */
+
+    /* Do not lose the lines of the last burst */
+    if (pending)
+        scanner->idle_cb();
 
     return 0;
 }
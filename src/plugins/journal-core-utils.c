@@ -0,0 +1,618 @@
+/*
+ * Copyright (C) 2014  ABRT team
+ * Copyright (C) 2014  RedHat Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include "libabrt.h"
+#include "journal-core-utils.h"
+
+/* <linux/fs.h> collides with <sys/mount.h> */
+#ifndef FICLONE
+#define FICLONE _IOW(0x94, 9, int)
+#endif
+
+/* copy_file_range() copies at most this number of bytes in one call */
+#define COPY_FILE_RANGE_CHUNK (1024 * 1024 * 1024)
+
+/*
+ * A journal message is a set of key value pairs in the following format:
+ *   FIELD_NAME=${binary data}
+ *
+ * A journal message contains many fields useful in syslog but ABRT doesn't
+ * need all of them. So the following list defines mapping between journal
+ * fields and ABRT problem items.
+ *
+ * ABRT goes through the list and for each item reads journal field called
+ * 'item.name' and saves its contents in $DUMP_DIRECTORY/'item.file'.
+ */
+struct field_mapping {
+    const char *name;
+    const char *file;
+} fields [] = {
+    { .name = "COREDUMP_EXE",         .file = FILENAME_EXECUTABLE, },
+    { .name = "COREDUMP_CMDLINE",     .file = FILENAME_CMDLINE, },
+    { .name = "COREDUMP_PROC_STATUS", .file = FILENAME_PROC_PID_STATUS, },
+    { .name = "COREDUMP_PROC_MAPS",   .file = FILENAME_MAPS, },
+    { .name = "COREDUMP_PROC_LIMITS", .file = FILENAME_LIMITS, },
+    { .name = "COREDUMP_PROC_CGROUP", .file = FILENAME_CGROUP, },
+    { .name = "COREDUMP_ENVIRON",     .file = FILENAME_ENVIRON, },
+    { .name = "COREDUMP_CWD",         .file = FILENAME_PWD, },
+    { .name = "COREDUMP_ROOT",        .file = FILENAME_ROOTDIR, },
+    { .name = "COREDUMP_OPEN_FDS",    .file = FILENAME_OPEN_FDS, },
+    { .name = "COREDUMP_UID",         .file = FILENAME_UID, },
+    //{ .name = "COREDUMP_GID",         .file = FILENAME_GID, },
+    { .name = "COREDUMP_PID",         .file = FILENAME_PID, },
+};
+
+/*
+ * Something like 'struct problem_data' but optimized for copying data from
+ * journald to ABRT.
+ *
+ * 'struct problem_data' allocates a new memory for every single item and I
+ * found that very inefficient in this case.
+ *
+ * The following structure holds data that we already retreived from journald
+ * so we won't need to retrieve the data again.
+ *
+ * Why we retrieve data before we store them? Because we do some checking
+ * before we start saving data in ABRT. We check whether the signal is one of
+ * those we are interested in or whether the executable crashes too often to
+ * ignore the current crash ...
+ */
+struct crash_info
+{
+    abrt_journal_t *ci_journal;
+
+    int ci_signal_no;
+    const char *ci_signal_name;
+    char *ci_executable_path;          ///< /full/path/to/executable
+    const char *ci_executable_name;    ///< executable
+    uid_t ci_uid;
+    pid_t ci_pid;
+
+    struct field_mapping *ci_mapping;
+    size_t ci_mapping_items;
+};
+
+/*
+ * Per-executable throttle of problem creation.
+ *
+ * Every executable has a token bucket holding at most 'burst' tokens which
+ * is refilled by one token every 'interval' seconds. A problem is created
+ * only if it can take a token from the bucket of the crashed executable.
+ *
+ * The bucket is represented by a single time stamp, the time when the bucket
+ * is full again (this is the generic cell rate algorithm). A full bucket is
+ * the same as no bucket, so the entries of full buckets can be dropped
+ * without losing anything.
+ */
+static GHashTable *s_throttle_buckets; ///< executable -> time_t *full_at
+static bool s_throttle_dirty;
+static time_t s_throttle_saved;
+
+static time_t
+throttle_capacity(const abrt_watch_core_conf_t *conf)
+{
+    return (time_t)MAX(conf->awc_throttle_burst, 1) * conf->awc_throttle;
+}
+
+static void
+throttle_insert(const char *executable, time_t full_at)
+{
+    time_t *value = xmalloc(sizeof(*value));
+    *value = full_at;
+    g_hash_table_replace(s_throttle_buckets, xstrdup(executable), value);
+}
+
+static void
+throttle_load(const abrt_watch_core_conf_t *conf)
+{
+    s_throttle_buckets = g_hash_table_new_full(g_str_hash, g_str_equal, free, free);
+
+    if (conf->awc_throttle_state_file == NULL)
+        return;
+
+    FILE *fp = fopen(conf->awc_throttle_state_file, "r");
+    if (fp == NULL)
+    {
+        if (errno != ENOENT)
+            perror_msg("Can't open '%s'", conf->awc_throttle_state_file);
+        return;
+    }
+
+    const time_t now = time(NULL);
+    const time_t capacity = throttle_capacity(conf);
+
+    char *line;
+    while ((line = xmalloc_fgetline(fp)) != NULL)
+    {
+        /* <time when the bucket is full> <executable> */
+        long long full_at;
+        int executable_start = 0;
+        if (sscanf(line, "%lld %n", &full_at, &executable_start) != 1 || line[executable_start] == '\0')
+            log_notice("Ignoring invalid throttle record '%s'", line);
+        else if (full_at > now
+                 && g_hash_table_size(s_throttle_buckets) < conf->awc_throttle_size)
+            /* A clock set back must not block the executable forever */
+            throttle_insert(line + executable_start, MIN((time_t)full_at, now + capacity));
+
+        free(line);
+    }
+
+    fclose(fp);
+
+    log_debug("Loaded %u throttled executables", g_hash_table_size(s_throttle_buckets));
+}
+
+static void
+throttle_save(const abrt_watch_core_conf_t *conf)
+{
+    const char *file_name = conf->awc_throttle_state_file;
+    char *tmp_name = xasprintf("%s.new", file_name);
+
+    const int fd = open(tmp_name, O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC, 0600);
+    FILE *fp = fd < 0 ? NULL : fdopen(fd, "w");
+    if (fp == NULL)
+    {
+        perror_msg("Can't save throttle state: open('%s')", tmp_name);
+        if (fd >= 0)
+            close(fd);
+        goto finito;
+    }
+
+    const time_t now = time(NULL);
+    GHashTableIter iter;
+    gpointer executable;
+    gpointer full_at;
+    g_hash_table_iter_init(&iter, s_throttle_buckets);
+    while (g_hash_table_iter_next(&iter, &executable, &full_at))
+        if (*(time_t *)full_at > now)
+            fprintf(fp, "%lld %s\n", (long long)*(time_t *)full_at, (const char *)executable);
+
+    if (fflush(fp) != 0 || fsync(fileno(fp)) != 0)
+    {
+        perror_msg("Can't save throttle state: write('%s')", tmp_name);
+        fclose(fp);
+        unlink(tmp_name);
+        goto finito;
+    }
+    fclose(fp);
+
+    if (rename(tmp_name, file_name) != 0)
+    {
+        perror_msg("Can't save throttle state: rename('%s')", tmp_name);
+        unlink(tmp_name);
+        goto finito;
+    }
+
+    s_throttle_dirty = false;
+
+finito:
+    s_throttle_saved = time(NULL);
+    free(tmp_name);
+}
+
+static gboolean
+throttle_bucket_is_full(gpointer executable, gpointer full_at, gpointer now)
+{
+    return *(time_t *)full_at <= *(time_t *)now;
+}
+
+/* Drops the full buckets or the fullest one if there is no full bucket */
+static void
+throttle_make_room(time_t now)
+{
+    if (g_hash_table_foreach_remove(s_throttle_buckets, throttle_bucket_is_full, &now) != 0)
+        return;
+
+    gpointer fullest = NULL;
+    time_t fullest_at = 0;
+    GHashTableIter iter;
+    gpointer executable;
+    gpointer full_at;
+    g_hash_table_iter_init(&iter, s_throttle_buckets);
+    while (g_hash_table_iter_next(&iter, &executable, &full_at))
+    {
+        if (fullest == NULL || *(time_t *)full_at < fullest_at)
+        {
+            fullest = executable;
+            fullest_at = *(time_t *)full_at;
+        }
+    }
+
+    if (fullest != NULL)
+        g_hash_table_remove(s_throttle_buckets, fullest);
+}
+
+/*
+ * Returns 0 if the bucket of the executable has a token; otherwise the number
+ * of seconds until it gets one.
+ */
+static time_t
+throttle_wait_time(const abrt_watch_core_conf_t *conf, const char *executable, time_t now)
+{
+    const time_t *full_at = g_hash_table_lookup(s_throttle_buckets, executable);
+    if (full_at == NULL)
+        return 0;
+
+    /* The bucket has a token if it is going to be full in less time than
+     * refilling of the other tokens takes */
+    const time_t not_before = *full_at - throttle_capacity(conf) + conf->awc_throttle;
+    return not_before > now ? not_before - now : 0;
+}
+
+static void
+throttle_take_token(const abrt_watch_core_conf_t *conf, const char *executable, time_t now)
+{
+    const time_t *full_at = g_hash_table_lookup(s_throttle_buckets, executable);
+    const time_t start = (full_at != NULL && *full_at > now) ? *full_at : now;
+
+    if (full_at == NULL && g_hash_table_size(s_throttle_buckets) >= conf->awc_throttle_size)
+        throttle_make_room(now);
+
+    throttle_insert(executable, start + conf->awc_throttle);
+    s_throttle_dirty = true;
+}
+
+void
+abrt_journal_core_save_throttle(const abrt_watch_core_conf_t *conf)
+{
+    if (s_throttle_dirty && conf->awc_throttle_state_file != NULL)
+        throttle_save(conf);
+}
+
+/*
+ * Converts a journal message into an intermediate ABRT problem (struct crash_info).
+ *
+ * Refuses to create the problem in the following cases:
+ * - the crashed executable has 'abrt' prefix
+ * - the signals is not fatal (see signal_is_fatal())
+ * - the journal message misses one of the following fields
+ *   - COREDUMP_SIGNAL
+ *   - COREDUMP_EXE
+ *   - COREDUMP_UID
+ *   - COREDUMP_PROC_STATUS
+ * - if any data does not have an expected format
+ */
+static int
+abrt_journal_core_retrieve_information(abrt_journal_t *journal, struct crash_info *info)
+{
+    if (abrt_journal_get_int_field(journal, "COREDUMP_SIGNAL", &(info->ci_signal_no)) != 0)
+    {
+        log_info("Failed to get signal number from journal message");
+        return -EINVAL;
+    }
+
+    if (!signal_is_fatal(info->ci_signal_no, &(info->ci_signal_name)))
+    {
+        log_info("Signal '%d' is not fatal: ignoring crash", info->ci_signal_no);
+        return 1;
+    }
+
+    info->ci_executable_path = abrt_journal_get_string_field(journal, "COREDUMP_EXE", NULL);
+    if (info->ci_executable_path == NULL)
+    {
+        log_notice("Could not get crashed 'executable'.");
+        return -ENOENT;
+    }
+
+    info->ci_executable_name = strrchr(info->ci_executable_path, '/');
+    if (info->ci_executable_name == NULL)
+    {
+        info->ci_executable_name = info->ci_executable_path;
+    }
+    else if(strncmp(++(info->ci_executable_name), "abrt", 4) == 0)
+    {
+        error_msg("Ignoring crash of ABRT executable '%s'", info->ci_executable_path);
+        return 1;
+    }
+
+    if (abrt_journal_get_unsigned_field(journal, "COREDUMP_UID", &(info->ci_uid)))
+    {
+        log_info("Failed to get UID from journal message");
+        return -EINVAL;
+    }
+
+    /* This is not fatal, the pid is used only in dumpdir name */
+    if (abrt_journal_get_int_field(journal, "COREDUMP_PID", &(info->ci_pid)))
+    {
+        log_notice("Failed to get PID from journal message.");
+        info->ci_pid = getpid();
+    }
+
+    char *proc_status = abrt_journal_get_string_field(journal, "COREDUMP_PROC_STATUS", NULL);
+    if (proc_status == NULL)
+    {
+        log_info("Failed to get /proc/[pid]/status from journal message");
+        return -ENOENT;
+    }
+
+    uid_t tmp_fsuid = get_fsuid(proc_status);
+    if (tmp_fsuid < 0)
+        return -EINVAL;
+
+    if (tmp_fsuid != info->ci_uid)
+    {
+        /* use root for suided apps unless it's explicitly set to UNSAFE */
+        info->ci_uid = (dump_suid_policy() != DUMP_SUID_UNSAFE) ? 0 : tmp_fsuid;
+    }
+
+    return 0;
+}
+
+/*
+ * Copies the uncompressed core file of systemd-coredump without passing its
+ * contents through user space. On file systems supporting reflinks the core
+ * file shares the blocks with the original one; otherwise the kernel copies
+ * the data with copy_file_range(). The plain read/write copy is used only if
+ * none of them is available, e.g. when the dump location is on another file
+ * system on an older kernel.
+ */
+static int
+copy_coredump_file(struct dump_dir *dd, const char *coredump_path)
+{
+    const int src_fd = open(coredump_path, O_RDONLY | O_CLOEXEC);
+    if (src_fd < 0)
+    {
+        perror_msg("Can't open '%s'", coredump_path);
+        return -1;
+    }
+
+    const int dst_fd = dd_open_item(dd, FILENAME_COREDUMP, O_RDWR);
+    if (dst_fd < 0)
+    {
+        perror_msg("Can't create '%s' in '%s'", FILENAME_COREDUMP, dd->dd_dirname);
+        close(src_fd);
+        return -1;
+    }
+
+    int r = -1;
+
+    if (ioctl(dst_fd, FICLONE, src_fd) == 0)
+    {
+        log_debug("Core file '%s' has been reflinked", coredump_path);
+        r = 0;
+        goto finito;
+    }
+
+#ifdef __NR_copy_file_range
+    off_t copied = 0;
+    ssize_t n;
+    while ((n = syscall(__NR_copy_file_range, src_fd, NULL, dst_fd, NULL, COPY_FILE_RANGE_CHUNK, 0)) > 0)
+        copied += n;
+
+    if (n == 0)
+    {
+        log_debug("Core file '%s' has been copied in kernel (%llu bytes)", coredump_path, (unsigned long long)copied);
+        r = 0;
+        goto finito;
+    }
+
+    if (copied != 0 || (errno != ENOSYS && errno != EXDEV && errno != EINVAL && errno != EOPNOTSUPP))
+    {
+        perror_msg("Can't copy '%s'", coredump_path);
+        goto finito;
+    }
+#endif
+
+    if (copyfd_eof(src_fd, dst_fd, COPYFD_SPARSE) >= 0)
+        r = 0;
+
+finito:
+    if (close(dst_fd) != 0 && r == 0)
+    {
+        perror_msg("Can't save '%s' in '%s'", FILENAME_COREDUMP, dd->dd_dirname);
+        r = -1;
+    }
+    close(src_fd);
+
+    return r;
+}
+
+/*
+ * Initializes ABRT problem directory and save the relevant journal message
+ * fileds in that directory.
+ */
+static int
+save_systemd_coredump_in_dump_directory(struct dump_dir *dd, struct crash_info *info)
+{
+    char coredump_path[PATH_MAX + 1] = { '\0' };
+    if (coredump_path != abrt_journal_get_string_field(info->ci_journal, "COREDUMP_FILENAME", coredump_path))
+        log_debug("Processing coredumpctl entry without a real file");
+
+    const size_t len = strlen(coredump_path);
+    if (   (len >= 3
+            && coredump_path[len - 3] == '.'
+            && coredump_path[len - 2] == 'x'
+            && coredump_path[len - 1] == 'z')
+        || (len >= 4
+            && coredump_path[len - 4] == '.'
+            && coredump_path[len - 3] == 'l'
+            && coredump_path[len - 2] == 'z'
+            && coredump_path[len - 1] == '4'))
+    {
+        if (dd_copy_file_unpack(dd, FILENAME_COREDUMP, coredump_path))
+            return -1;
+    }
+    else if (len > 0)
+    {
+        if (copy_coredump_file(dd, coredump_path))
+            return -1;
+    }
+    else
+    {
+        const char *data = NULL;
+        size_t data_len = 0;
+        int r = abrt_journal_get_field(info->ci_journal, "COREDUMP", (const void **)&data, &data_len);
+        if (r < 0)
+        {
+            log_info("Ignoring coredumpctl entry without core dump file.");
+            return -1;
+        }
+
+        dd_save_binary(dd, FILENAME_COREDUMP, data, data_len);
+    }
+
+    dd_save_text(dd, FILENAME_ABRT_VERSION, VERSION);
+    dd_save_text(dd, FILENAME_TYPE, "CCpp");
+    dd_save_text(dd, FILENAME_ANALYZER, "abrt-journal-core");
+
+    char *reason;
+    if (info->ci_signal_name == NULL)
+        reason = xasprintf("%s killed by signal %d", info->ci_executable_name, info->ci_signal_no);
+    else
+        reason = xasprintf("%s killed by SIG%s", info->ci_executable_name, info->ci_signal_name);
+
+    dd_save_text(dd, FILENAME_REASON, reason);
+    free(reason);
+
+    char *cursor = NULL;
+    if (abrt_journal_get_cursor(info->ci_journal, &cursor) == 0)
+        dd_save_text(dd, "journald_cursor", cursor);
+    free(cursor);
+
+    for (size_t i = 0; i < info->ci_mapping_items; ++i)
+    {
+        const char *data;
+        size_t data_len;
+        struct field_mapping *f = info->ci_mapping + i;
+
+        if (abrt_journal_get_field(info->ci_journal, f->name, (const void **)&data, &data_len))
+        {
+            log_info("systemd-coredump journald message misses field: '%s'", f->name);
+            continue;
+        }
+
+        dd_save_binary(dd, f->file, data, data_len);
+    }
+
+    return 0;
+}
+
+static int
+abrt_journal_core_to_abrt_problem(struct crash_info *info, const char *dump_location)
+{
+    struct dump_dir *dd = create_dump_dir_ext(dump_location, "ccpp", info->ci_pid, /*fs owner*/0,
+            (save_data_call_back)save_systemd_coredump_in_dump_directory, info);
+
+    if (dd != NULL)
+    {
+        char *path = xstrdup(dd->dd_dirname);
+        dd_close(dd);
+        notify_new_path(path);
+        log_debug("ABRT daemon has been notified about directory: '%s'", path);
+        free(path);
+    }
+
+    return dd == NULL;
+}
+
+/*
+ * Creates an abrt problem from a journal message
+ */
+int
+abrt_journal_dump_core(abrt_journal_t *journal, const char *dump_location)
+{
+    struct crash_info info = { 0 };
+    info.ci_journal = journal;
+    info.ci_mapping = fields;
+    info.ci_mapping_items = sizeof(fields)/sizeof(*fields);
+
+    /* Compatibility hack, a watch's callback gets the journal already moved
+     * to a next message. */
+    abrt_journal_next(journal);
+
+    /* This the watch call back mentioned in the comment above. We use the
+     * following function also in abrt_journal_watch_cores(). */
+    int r = abrt_journal_core_retrieve_information(journal, &info);
+    if (r != 0)
+    {
+        if (r < 0)
+            error_msg(_("Failed to obtain all required information from journald"));
+
+        goto dump_cleanup;
+    }
+
+    r = abrt_journal_core_to_abrt_problem(&info, dump_location);
+
+dump_cleanup:
+    if (info.ci_executable_path != NULL)
+        free(info.ci_executable_path);
+
+    return r;
+}
+
+/*
+ * A function called when a new journal core is detected.
+ *
+ * The function retrieves information from journal, checks the throttle bucket
+ * of the crashed executable and if there is a token creates an ABRT problem
+ * from the journal message. Finally takes the token from the bucket.
+ */
+void
+abrt_journal_core_process(abrt_journal_t *journal, const abrt_watch_core_conf_t *conf)
+{
+    struct crash_info info = { 0 };
+    info.ci_journal = journal;
+    info.ci_mapping = fields;
+    info.ci_mapping_items = sizeof(fields)/sizeof(*fields);
+
+    int r = abrt_journal_core_retrieve_information(journal, &info);
+    if (r)
+    {
+        if (r < 0)
+            error_msg(_("Failed to obtain all required information from journald"));
+
+        goto watch_cleanup;
+    }
+
+    // do not dump too often
+    //   ignore crashes of a single executable exceeding its token bucket
+    const time_t current = time(NULL);
+    if (conf->awc_throttle > 0)
+    {
+        if (s_throttle_buckets == NULL)
+            throttle_load(conf);
+
+        const time_t wait = throttle_wait_time(conf, info.ci_executable_path, current);
+        if (wait > 0)
+        {
+            /* We don't want to update the bucket here. */
+            error_msg(_("Not saving repeating crash of '%s', next one can be saved in %llds"),
+                      info.ci_executable_path, (long long)wait);
+            goto watch_cleanup;
+        }
+    }
+
+    if (abrt_journal_core_to_abrt_problem(&info, conf->awc_dump_location))
+    {
+        error_msg(_("Failed to save detect problem data in abrt database"));
+        goto watch_cleanup;
+    }
+
+    if (conf->awc_throttle > 0)
+    {
+        throttle_take_token(conf, info.ci_executable_path, current);
+
+        /* Keep the state file reasonably fresh during crash storms */
+        if (current != s_throttle_saved)
+            abrt_journal_core_save_throttle(conf);
+    }
+
+watch_cleanup:
+    if (info.ci_executable_path != NULL)
+        free(info.ci_executable_path);
+
+    return;
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2016  ABRT team
+ * Copyright (C) 2016  RedHat Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#ifndef _ABRT_JOURNAL_CORE_UTILS_H_
+#define _ABRT_JOURNAL_CORE_UTILS_H_
+
+#include "abrt-journal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * ABRT watch core configuration
+ */
+typedef struct
+{
+    const char *awc_dump_location;
+    /* A problem of an executable is created at most once per awc_throttle
+     * seconds after a burst of awc_throttle_burst problems; 0 disables the
+     * throttle */
+    int awc_throttle;
+    unsigned awc_throttle_burst;
+    /* The maximal number of throttled executables */
+    unsigned awc_throttle_size;
+    /* Where the throttle is persisted; may be NULL */
+    const char *awc_throttle_state_file;
+}
+abrt_watch_core_conf_t;
+
+/*
+ * Creates an abrt problem from the next journal message
+ *
+ * Returns non-0 value if the problem was not created.
+ */
+int abrt_journal_dump_core(abrt_journal_t *journal, const char *dump_location);
+
+/*
+ * Creates an abrt problem from the current journal message unless the
+ * throttle of the crashed executable is exhausted.
+ */
+void abrt_journal_core_process(abrt_journal_t *journal, const abrt_watch_core_conf_t *conf);
+
+/*
+ * Saves the throttle state in conf->awc_throttle_state_file if it has changed
+ * since the last save.
+ */
+void abrt_journal_core_save_throttle(const abrt_watch_core_conf_t *conf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*_ABRT_JOURNAL_CORE_UTILS_H_*/
@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2026  ABRT team
+ * Copyright (C) 2026  RedHat Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#include "libabrt.h"
+#include "oops-scan.h"
+
+#define OOPS_SCAN_MAX_THREADS 8
+/* How many kernel lines after the last suspicious one are analyzed? It must
+ * be more than the longest oops (80 lines) plus the parser's look ahead
+ * (50 lines), so every oops ends before the region does.
+ */
+#define OOPS_SCAN_REGION_TAIL 200
+
+/*
+ * Worker threads search chunks of the buffer for lines containing any of
+ * the suspicious strings or the abrt's marker. Only regions around such lines
+ * are fed to the oops parser. Outside of an oops the parser remembers only the
+ * log level of the previous kernel line, so each region starts with the
+ * kernel line preceding the first suspicious line, and the results are the
+ * same as if the whole file was fed to the parser.
+ */
+
+enum {
+    SCAN_SUSPICIOUS = 1 << 0,
+    SCAN_MARKER     = 1 << 1,
+};
+
+struct scan_chunk
+{
+    const char *begin;
+    const char *end;
+    const struct abrt_strings_matcher *matcher;
+    GArray *candidates; /* offsets of the interesting lines, relative to begin */
+};
+
+static gpointer scan_chunk_thread(gpointer data)
+{
+    struct scan_chunk *chunk = data;
+
+    const char *line = chunk->begin;
+    while (line < chunk->end)
+    {
+        const char *eol = memchr(line, '\n', chunk->end - line);
+        if (eol == NULL)
+            eol = chunk->end;
+
+        if (strings_matcher_scan(chunk->matcher, line, eol - line, SCAN_SUSPICIOUS|SCAN_MARKER, NULL))
+        {
+            const size_t offset = line - chunk->begin;
+            g_array_append_val(chunk->candidates, offset);
+        }
+
+        line = eol + 1;
+    }
+
+    return NULL;
+}
+
+/* Returns the beginning of the line following 'pos' */
+static const char *next_line(const char *pos, const char *end)
+{
+    const char *eol = memchr(pos, '\n', end - pos);
+    return eol ? eol + 1 : end;
+}
+
+/* Returns the beginning of the line preceding the line starting at 'line' */
+static const char *prev_line(const char *line, const char *begin)
+{
+    const char *pos = line - 1;
+    while (pos > begin && pos[-1] != '\n')
+        --pos;
+    return pos;
+}
+
+/* Returns the offsets of the interesting lines in ascending order */
+static GArray *find_candidate_lines(const char *buffer, size_t size, unsigned threads)
+{
+    struct abrt_strings_matcher *matcher = strings_matcher_new();
+    GList *suspicious = koops_suspicious_strings_list();
+    strings_matcher_add_list(matcher, suspicious, SCAN_SUSPICIOUS);
+    g_list_free(suspicious);
+    strings_matcher_add(matcher, "kernel oopses to Abrt", SCAN_MARKER);
+    strings_matcher_compile(matcher);
+
+    log_debug("Scanning %zu bytes in %u threads", size, threads);
+
+    struct scan_chunk *chunks = xzalloc(threads * sizeof(*chunks));
+    GThread **workers = xzalloc(threads * sizeof(*workers));
+
+    /* Split the buffer at line boundaries */
+    const char *const end = buffer + size;
+    const char *begin = buffer;
+    for (unsigned i = 0; i < threads; ++i)
+    {
+        chunks[i].begin = begin;
+        chunks[i].end = (i + 1 == threads) ? end : next_line(MAX(begin, buffer + size / threads * (i + 1)), end);
+        chunks[i].matcher = matcher;
+        chunks[i].candidates = g_array_new(FALSE, FALSE, sizeof(size_t));
+        begin = chunks[i].end;
+
+        workers[i] = g_thread_new("abrt-scan", scan_chunk_thread, &chunks[i]);
+    }
+
+    GArray *candidates = g_array_new(FALSE, FALSE, sizeof(size_t));
+    for (unsigned i = 0; i < threads; ++i)
+    {
+        g_thread_join(workers[i]);
+
+        const size_t chunk_offset = chunks[i].begin - buffer;
+        for (unsigned j = 0; j < chunks[i].candidates->len; ++j)
+        {
+            const size_t offset = chunk_offset + g_array_index(chunks[i].candidates, size_t, j);
+            g_array_append_val(candidates, offset);
+        }
+        g_array_free(chunks[i].candidates, TRUE);
+    }
+
+    free(workers);
+    free(chunks);
+    strings_matcher_free(matcher);
+
+    return candidates;
+}
+
+void abrt_oops_scan_syslog_buffer(GList **oops_list, const char *buffer, size_t size, unsigned threads)
+{
+    if (threads == 0)
+    {
+        const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus < 1 ? 1 : cpus > OOPS_SCAN_MAX_THREADS ? OOPS_SCAN_MAX_THREADS : cpus;
+    }
+
+    GArray *candidates = find_candidate_lines(buffer, size, threads);
+    log_debug("Found %u suspicious lines", candidates->len);
+
+    struct abrt_koops_parser *parser = koops_parser_new();
+    struct strbuf *line = strbuf_new();
+    const char *const end = buffer + size;
+    /* The end of the last analyzed region */
+    const char *analyzed = buffer;
+
+    unsigned cand = 0;
+    while (cand < candidates->len)
+    {
+        const char *region = buffer + g_array_index(candidates, size_t, cand);
+
+        /* Start with the preceding kernel line to get its log level right */
+        bool lead_found = false;
+        while (!lead_found && region > analyzed)
+        {
+            region = prev_line(region, analyzed);
+            const char *eol = memchr(region, '\n', end - region);
+            strbuf_clear(line);
+            strbuf_append_strf(line, "%.*s", (int)(eol - region), region);
+            lead_found = line->len != 0 && koops_syslog_line_kernel_message(line->buf) != NULL;
+        }
+
+        /* The previous region has ended. Otherwise the parser continues with
+         * the previous region because it already has the preceding line. */
+        if (lead_found)
+            koops_parser_finish(parser, oops_list);
+
+        unsigned tail = OOPS_SCAN_REGION_TAIL;
+        const char *pos = region;
+        while (pos < end && tail != 0)
+        {
+            const char *eol = memchr(pos, '\n', end - pos);
+            if (eol == NULL)
+                eol = end;
+
+            const bool is_candidate = cand < candidates->len
+                                      && buffer + g_array_index(candidates, size_t, cand) == pos;
+            if (is_candidate)
+            {
+                tail = OOPS_SCAN_REGION_TAIL;
+                ++cand;
+            }
+
+            if (eol != pos)
+            {
+                strbuf_clear(line);
+                strbuf_append_strf(line, "%.*s", (int)(eol - pos), pos);
+                if (!is_candidate && koops_syslog_line_kernel_message(line->buf) != NULL)
+                    --tail;
+                koops_parser_feed_syslog_line(parser, oops_list, line->buf);
+            }
+
+            pos = (eol == end) ? end : eol + 1;
+        }
+
+        analyzed = pos;
+    }
+
+    koops_parser_finish(parser, oops_list);
+
+    strbuf_free(line);
+    koops_parser_free(parser);
+    g_array_free(candidates, TRUE);
+}
@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2026  ABRT team
+ * Copyright (C) 2026  RedHat Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#ifndef _ABRT_OOPS_SCAN_H_
+#define _ABRT_OOPS_SCAN_H_
+
+#include "libabrt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Scans a syslog file or dmesg output in memory in parallel
+ *
+ * The found oopses are appended to the list in the same order as if all lines
+ * were fed to koops_parser_feed_syslog_line().
+ *
+ * @param threads The number of worker threads, 0 means one per CPU
+ */
+void abrt_oops_scan_syslog_buffer(GList **oops_list, const char *buffer, size_t size, unsigned threads);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*_ABRT_OOPS_SCAN_H_*/
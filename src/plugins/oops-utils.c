@@ -19,12 +19,327 @@
 #include <satyr/frame.h>
 #include <satyr/normalize.h>
 
+#include <sys/file.h>
+
 #include "oops-utils.h"
 #include "libabrt.h"
 
+/* Recently dumped oopses shared by all oops extractors. One-shot extractors
+ * (e.g. abrt-dump-oops run by abrt-watch-log) exit before abrtd processes
+ * the problems they create, so the occurrences not yet added to the
+ * problems' counts must outlive them. */
+#define ABRT_OOPS_RECENT_STATE_FILE VAR_STATE"/abrt-oops-recent.state"
+
+/* Recently dumped oopses, the most recently seen first */
+struct abrt_oops_recent
+{
+    char hash[SHA1_RESULT_LEN*2 + 1];
+    char *path;
+    /* Occurrences not yet added to FILENAME_COUNT of the problem */
+    unsigned unsaved_cnt;
+    /* Occurrences seen by this process and not yet stored in the state */
+    unsigned local_cnt;
+    /* The entry has changes not yet stored in the state */
+    bool local;
+};
+
+static GQueue s_recent_oopses = G_QUEUE_INIT;
+static GHashTable *s_recent_oopses_index; /* hash -> GList link in s_recent_oopses */
+
+static void abrt_oops_recent_free(struct abrt_oops_recent *recent)
+{
+    if (recent->unsaved_cnt + recent->local_cnt != 0)
+        log_notice("Forgetting %u occurrences of '%s'",
+                   recent->unsaved_cnt + recent->local_cnt, recent->path);
+
+    free(recent->path);
+    free(recent);
+}
+
+static void abrt_oops_recent_forget(GList *link)
+{
+    struct abrt_oops_recent *recent = link->data;
+    g_hash_table_remove(s_recent_oopses_index, recent->hash);
+    g_queue_delete_link(&s_recent_oopses, link);
+    abrt_oops_recent_free(recent);
+}
+
+static struct abrt_oops_recent *abrt_oops_recent_new(const char *hash, const char *path, unsigned unsaved_cnt)
+{
+    struct abrt_oops_recent *recent = xzalloc(sizeof(*recent));
+    strcpy(recent->hash, hash);
+    recent->path = xstrdup(path);
+    recent->unsaved_cnt = unsaved_cnt;
+    return recent;
+}
+
+static void abrt_oops_recent_push_head(struct abrt_oops_recent *recent)
+{
+    g_queue_push_head(&s_recent_oopses, recent);
+    g_hash_table_insert(s_recent_oopses_index, recent->hash, g_queue_peek_head_link(&s_recent_oopses));
+}
+
+static void abrt_oops_recent_push_tail(struct abrt_oops_recent *recent)
+{
+    g_queue_push_tail(&s_recent_oopses, recent);
+    g_hash_table_insert(s_recent_oopses_index, recent->hash, g_queue_peek_tail_link(&s_recent_oopses));
+}
+
+/* Opens and locks the state file. Returns -1 if the state cannot be used; the
+ * oopses are remembered only by this process in that case. */
+static int abrt_oops_recent_lock(void)
+{
+    const int fd = open(ABRT_OOPS_RECENT_STATE_FILE, O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC, 0600);
+    if (fd < 0)
+    {
+        log_debug("Can't open '%s': %s", ABRT_OOPS_RECENT_STATE_FILE, strerror(errno));
+        return -1;
+    }
+
+    if (flock(fd, LOCK_EX) != 0)
+    {
+        perror_msg("Can't lock '%s'", ABRT_OOPS_RECENT_STATE_FILE);
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+/* Replaces the remembered oopses with the contents of the locked state file,
+ * which other extractors might have updated, and applies the changes of this
+ * process not yet stored in the state.
+ *
+ * Returns false if the state cannot be read.
+ */
+static bool abrt_oops_recent_merge(int fd)
+{
+    if (lseek(fd, 0, SEEK_SET) != 0)
+    {
+        perror_msg("Can't read '%s'", ABRT_OOPS_RECENT_STATE_FILE);
+        return false;
+    }
+
+    char *contents = xmalloc_read(fd, /*maxsize:*/ NULL);
+    if (contents == NULL)
+    {
+        perror_msg("Can't read '%s'", ABRT_OOPS_RECENT_STATE_FILE);
+        return false;
+    }
+
+    GQueue local = s_recent_oopses;
+    g_queue_init(&s_recent_oopses);
+    if (s_recent_oopses_index != NULL)
+        g_hash_table_destroy(s_recent_oopses_index);
+    s_recent_oopses_index = g_hash_table_new(g_str_hash, g_str_equal);
+
+    /* Lines: "<hash> <unsaved count> <path>" */
+    char *saveptr = NULL;
+    for (char *line = strtok_r(contents, "\n", &saveptr);
+         line != NULL && g_queue_get_length(&s_recent_oopses) < ABRT_OOPS_RECENT_COUNT;
+         line = strtok_r(NULL, "\n", &saveptr))
+    {
+        char hash[SHA1_RESULT_LEN*2 + 1];
+        unsigned unsaved_cnt;
+        int path_pos = 0;
+        if (sscanf(line, "%40s %u %n", hash, &unsaved_cnt, &path_pos) != 2
+            || strlen(hash) != SHA1_RESULT_LEN*2 || path_pos == 0 || line[path_pos] != '/')
+        {
+            log_notice("Ignoring malformed line in '%s': %s", ABRT_OOPS_RECENT_STATE_FILE, line);
+            continue;
+        }
+
+        if (g_hash_table_lookup(s_recent_oopses_index, hash) == NULL)
+            abrt_oops_recent_push_tail(abrt_oops_recent_new(hash, line + path_pos, unsaved_cnt));
+    }
+    free(contents);
+
+    /* The oldest first, so the most recent ends up at the head */
+    struct abrt_oops_recent *recent;
+    while ((recent = g_queue_pop_tail(&local)) != NULL)
+    {
+        if (recent->local)
+        {
+            GList *link = g_hash_table_lookup(s_recent_oopses_index, recent->hash);
+            if (link != NULL)
+            {
+                struct abrt_oops_recent *stored = link->data;
+                stored->local_cnt += recent->local_cnt;
+                stored->local = true;
+                g_queue_unlink(&s_recent_oopses, link);
+                g_queue_push_head_link(&s_recent_oopses, link);
+            }
+            else
+            {
+                /* The occurrences stored earlier are accounted by the
+                 * extractor which dropped the entry */
+                struct abrt_oops_recent *added = abrt_oops_recent_new(recent->hash, recent->path, 0);
+                added->local_cnt = recent->local_cnt;
+                added->local = true;
+                abrt_oops_recent_push_head(added);
+            }
+        }
+
+        /* Accounted in the merged entries */
+        recent->unsaved_cnt = 0;
+        recent->local_cnt = 0;
+        abrt_oops_recent_free(recent);
+    }
+
+    return true;
+}
+
+/* Loads the oopses remembered by all extractors */
+static void abrt_oops_recent_load(void)
+{
+    const int fd = abrt_oops_recent_lock();
+    if (fd < 0)
+        return;
+
+    abrt_oops_recent_merge(fd);
+    close(fd);
+}
+
+static void abrt_oops_recent_remember(const char *hash, const char *path)
+{
+    if (s_recent_oopses_index == NULL)
+        s_recent_oopses_index = g_hash_table_new(g_str_hash, g_str_equal);
+
+    while (g_queue_get_length(&s_recent_oopses) >= ABRT_OOPS_RECENT_COUNT)
+        abrt_oops_recent_forget(g_queue_peek_tail_link(&s_recent_oopses));
+
+    struct abrt_oops_recent *recent = abrt_oops_recent_new(hash, path, 0);
+    recent->local = true;
+    abrt_oops_recent_push_head(recent);
+}
+
+/* Adds the unsaved occurrences to the problem's count.
+ *
+ * The count is not touched until the problem is processed by abrtd because
+ * abrtd considers problems with FILENAME_COUNT as already processed. The
+ * problem is not waited for if it is locked (e.g. processed by abrtd), its
+ * occurrences are saved next time.
+ *
+ * Returns false if the problem does not exist anymore.
+ */
+static bool abrt_oops_recent_save(struct abrt_oops_recent *recent)
+{
+    struct dump_dir *dd = dd_opendir(recent->path, DD_FAIL_QUIETLY_ENOENT | DD_DONT_WAIT_FOR_LOCK);
+    if (dd == NULL)
+        return access(recent->path, F_OK) == 0;
+
+    char *count_str = dd_load_text_ext(dd, FILENAME_COUNT,
+            DD_FAIL_QUIETLY_ENOENT | DD_LOAD_TEXT_RETURN_NULL_ON_FAILURE);
+    if (count_str != NULL)
+    {
+        unsigned long count = strtoul(count_str, NULL, 10) + recent->unsaved_cnt;
+        char new_count_str[sizeof(long)*3 + 2];
+        sprintf(new_count_str, "%lu", count);
+        dd_save_text(dd, FILENAME_COUNT, new_count_str);
+
+        char last_ocr[sizeof(long)*3 + 2];
+        sprintf(last_ocr, "%lu", (long)time(NULL));
+        dd_save_text(dd, FILENAME_LAST_OCCURRENCE, last_ocr);
+
+        log_info("Oops '%s' occurred %lu times", recent->path, count);
+        recent->unsaved_cnt = 0;
+        free(count_str);
+    }
+
+    dd_close(dd);
+    return true;
+}
+
+/* Returns true if the oops has been recently dumped and records the occurrence */
+static bool abrt_oops_recent_occurred(const char *hash)
+{
+    if (s_recent_oopses_index == NULL)
+        return false;
+
+    GList *link = g_hash_table_lookup(s_recent_oopses_index, hash);
+    if (link == NULL)
+        return false;
+
+    struct abrt_oops_recent *recent = link->data;
+    if (access(recent->path, F_OK) != 0)
+    {
+        log_notice("Recently dumped oops '%s' has been removed", recent->path);
+        abrt_oops_recent_forget(link);
+        return false;
+    }
+
+    recent->local_cnt++;
+    recent->local = true;
+    g_queue_unlink(&s_recent_oopses, link);
+    g_queue_push_head_link(&s_recent_oopses, link);
+    return true;
+}
+
+/* Saves the recorded occurrences, those of not yet processed problems are
+ * saved next time */
+static void abrt_oops_recent_save_all(void)
+{
+    GList *link = g_queue_peek_head_link(&s_recent_oopses);
+    while (link != NULL)
+    {
+        GList *next = g_list_next(link);
+        struct abrt_oops_recent *recent = link->data;
+        recent->unsaved_cnt += recent->local_cnt;
+        recent->local_cnt = 0;
+        recent->local = false;
+        if (recent->unsaved_cnt != 0 && !abrt_oops_recent_save(recent))
+        {
+            log_notice("Recently dumped oops '%s' has been removed", recent->path);
+            recent->unsaved_cnt = 0;
+            abrt_oops_recent_forget(link);
+        }
+        link = next;
+    }
+
+    while (g_queue_get_length(&s_recent_oopses) > ABRT_OOPS_RECENT_COUNT)
+        abrt_oops_recent_forget(g_queue_peek_tail_link(&s_recent_oopses));
+}
+
+/* Merges the changes of this process with the state updated by the other
+ * extractors in the meantime, saves the occurrences and stores the state */
+static void abrt_oops_recent_store(void)
+{
+    const int fd = abrt_oops_recent_lock();
+    if (fd < 0 || !abrt_oops_recent_merge(fd))
+    {
+        abrt_oops_recent_save_all();
+        if (fd >= 0)
+            close(fd);
+        return;
+    }
+
+    abrt_oops_recent_save_all();
+
+    struct strbuf *contents = strbuf_new();
+    for (GList *link = g_queue_peek_head_link(&s_recent_oopses); link != NULL; link = g_list_next(link))
+    {
+        struct abrt_oops_recent *recent = link->data;
+        strbuf_append_strf(contents, "%s %u %s\n", recent->hash, recent->unsaved_cnt, recent->path);
+    }
+
+    if (lseek(fd, 0, SEEK_SET) != 0
+        || ftruncate(fd, 0) != 0
+        || full_write(fd, contents->buf, contents->len) != contents->len)
+    {
+        perror_msg("Can't write '%s'", ABRT_OOPS_RECENT_STATE_FILE);
+    }
+
+    strbuf_free(contents);
+    close(fd);
+}
+
+static unsigned abrt_oops_create_dump_dirs_ext(GList *oops_list, const char *dump_location,
+        const char *analyzer, int flags, unsigned *repeated_cnt);
+
 int abrt_oops_process_list(GList *oops_list, const char *dump_location, const char *analyzer, int flags)
 {
     unsigned errors = 0;
+    unsigned repeated_cnt = 0;
 
     int oops_cnt = g_list_length(oops_list);
     if (oops_cnt != 0)
@@ -47,7 +362,7 @@ int abrt_oops_process_list(GList *oops_list, const char *dump_location, const ch
         if (dump_location != NULL)
         {
             log("Creating problem directories");
-            errors = abrt_oops_create_dump_dirs(oops_list, dump_location, analyzer, flags);
+            errors = abrt_oops_create_dump_dirs_ext(oops_list, dump_location, analyzer, flags, &repeated_cnt);
             if (errors)
                 log("%d errors while dumping oopses", errors);
             /*
@@ -58,7 +373,7 @@ int abrt_oops_process_list(GList *oops_list, const char *dump_location, const ch
              */
             syslog(LOG_WARNING,
                     "Reported %u kernel oopses to Abrt",
-                    oops_cnt
+                    oops_cnt - repeated_cnt
             );
         }
     }
@@ -66,8 +381,9 @@ int abrt_oops_process_list(GList *oops_list, const char *dump_location, const ch
     /* If we are run by a log watcher, this delays log rescan
      * (because log watcher waits to us to terminate)
      * and possibly prevents dreaded "abrt storm".
+     * Repeated oopses are cheap, they do not count.
      */
-    int unreported_cnt = oops_cnt - ABRT_OOPS_MAX_DUMPED_COUNT;
+    int unreported_cnt = oops_cnt - (int)repeated_cnt - ABRT_OOPS_MAX_DUMPED_COUNT;
     if (g_abrt_oops_sleep_woke_up_on_signal <= 0 &&
             (unreported_cnt > 0 && (flags & ABRT_OOPS_THROTTLE_CREATION)))
     {
@@ -84,12 +400,23 @@ int abrt_oops_process_list(GList *oops_list, const char *dump_location, const ch
 
 /* returns number of errors */
 unsigned abrt_oops_create_dump_dirs(GList *oops_list, const char *dump_location, const char *analyzer, int flags)
+{
+    return abrt_oops_create_dump_dirs_ext(oops_list, dump_location, analyzer, flags, /*repeated_cnt*/NULL);
+}
+
+static unsigned abrt_oops_create_dump_dirs_ext(GList *oops_list, const char *dump_location,
+        const char *analyzer, int flags, unsigned *repeated_cnt)
 {
     const int oops_cnt = g_list_length(oops_list);
     unsigned countdown = ABRT_OOPS_MAX_DUMPED_COUNT; /* do not report hundreds of oopses */
+    unsigned repeated = 0;
 
     log_notice("Saving %u oopses as problem dirs", oops_cnt >= countdown ? countdown : oops_cnt);
 
+    /* The state is locked only while it is read and written, other
+     * extractors are not blocked by the throttling below */
+    abrt_oops_recent_load();
+
     char *cmdline_str = xmalloc_fopen_fgetline_fclose("/proc/cmdline");
     char *fips_enabled = xmalloc_fopen_fgetline_fclose("/proc/sys/crypto/fips_enabled");
     char *proc_modules = xmalloc_open_read_close("/proc/modules", /*maxsize:*/ NULL);
@@ -103,6 +430,19 @@ unsigned abrt_oops_create_dump_dirs(GList *oops_list, const char *dump_location,
     unsigned errors = 0;
     while (idx < oops_cnt)
     {
+        const char *oops = (const char *)g_list_nth_data(oops_list, idx);
+        char hash[SHA1_RESULT_LEN*2 + 1];
+        /* The first line is the kernel version */
+        const char *backtrace = strchrnul(oops, '\n');
+        const bool hashed = koops_hash_str(hash, *backtrace ? backtrace + 1 : backtrace) == 0;
+        if (hashed && abrt_oops_recent_occurred(hash))
+        {
+            log_debug("Oops %u is a repeated occurrence", idx);
+            ++repeated;
+            ++idx;
+            continue;
+        }
+
         char base[sizeof("oops-YYYY-MM-DD-hh:mm:ss-%lu-%lu") + 2 * sizeof(long)*3];
         sprintf(base, "oops-%s-%lu-%lu", iso_date, (long)my_pid, (long)idx);
         char *path = concat_path_file(dump_location, base);
@@ -127,6 +467,8 @@ unsigned abrt_oops_create_dump_dirs(GList *oops_list, const char *dump_location,
                 dd_set_no_owner(dd);
             dd_close(dd);
             notify_new_path(path);
+            if (hashed)
+                abrt_oops_recent_remember(hash, path);
         }
         else
             errors++;
@@ -146,6 +488,11 @@ unsigned abrt_oops_create_dump_dirs(GList *oops_list, const char *dump_location,
     free(fips_enabled);
     free(suspend_stats);
 
+    abrt_oops_recent_store();
+
+    if (repeated_cnt)
+        *repeated_cnt = repeated;
+
     return errors;
 }
 
@@ -315,3 +662,39 @@ char *abrt_oops_string_filter_regex(void)
 
     return NULL;
 }
+
+GList *abrt_oops_suspicious_strings_list_filtered(void)
+{
+    GList *koops_strings = koops_suspicious_strings_list();
+
+    char *oops_string_filter_regex = abrt_oops_string_filter_regex();
+    if (oops_string_filter_regex)
+    {
+        regex_t filter_re;
+        if (regcomp(&filter_re, oops_string_filter_regex, REG_NOSUB) != 0)
+            perror_msg_and_die(_("Failed to compile regex"));
+
+        GList *iter = koops_strings;
+        while(iter != NULL)
+        {
+            GList *next = g_list_next(iter);
+
+            const int reti = regexec(&filter_re, (const char *)iter->data, 0, NULL, 0);
+            if (reti == 0)
+                koops_strings = g_list_delete_link(koops_strings, iter);
+            else if (reti != REG_NOMATCH)
+            {
+                char msgbuf[100];
+                regerror(reti, &filter_re, msgbuf, sizeof(msgbuf));
+                error_msg_and_die("Regex match failed: %s", msgbuf);
+            }
+
+            iter = next;
+        }
+
+        regfree(&filter_re);
+        free(oops_string_filter_regex);
+    }
+
+    return koops_strings;
+}
@@ -23,6 +23,12 @@
  */
 #define ABRT_OOPS_MAX_DUMPED_COUNT  5
 
+/* How many recently dumped oopses to remember?
+ * A repeated occurrence of a remembered oops only increments the count of
+ * the problem created for its first occurrence.
+ */
+#define ABRT_OOPS_RECENT_COUNT  64
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -40,6 +46,9 @@ unsigned abrt_oops_create_dump_dirs(GList *oops_list, const char *dump_location,
 void abrt_oops_save_data_in_dump_dir(struct dump_dir *dd, char *oops, const char *proc_modules);
 int abrt_oops_signaled_sleep(int seconds);
 char *abrt_oops_string_filter_regex(void);
+/* Suspicious strings without those filtered out by oops.conf, free the list
+ * with g_list_free() */
+GList *abrt_oops_suspicious_strings_list_filtered(void);
 
 #ifdef __cplusplus
 }
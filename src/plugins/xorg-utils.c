@@ -15,12 +15,6 @@
 #include "libabrt.h"
 #include "xorg-utils.h"
 
-/* I want to use -Werror, but gcc-4.4 throws a curveball:
- * "warning: ignoring return value of 'ftruncate', declared with attribute warn_unused_result"
- * and (void) cast is not enough to shut it up! Oh God...
- */
-#define IGNORE_RESULT(func_call) do { if (func_call) /* nothing */; } while (0)
-
 #define DEFAULT_XORG_CRASH_REASON "Display server crashed"
 
 int abrt_xorg_signaled_sleep(int seconds)
@@ -39,53 +33,90 @@ int abrt_xorg_signaled_sleep(int seconds)
 }
 
 
+static struct xorg_crash_info *xorg_crash_info_from_arena(GString *arena, size_t reason, size_t exe)
+{
+    struct xorg_crash_info *crash_info = xmalloc(sizeof(*crash_info));
+    crash_info->backtrace = 0;
+    crash_info->reason = reason;
+    crash_info->exe = exe;
+    crash_info->arena = g_string_free(arena, FALSE);
+    return crash_info;
+}
+
+struct xorg_crash_info *xorg_crash_info_new(const char *backtrace, const char *reason, const char *exe)
+{
+    GString *arena = g_string_new(backtrace);
+    g_string_append_c(arena, '\0');
+
+    const size_t reason_ofs = arena->len;
+    g_string_append(arena, reason);
+
+    size_t exe_ofs = XORG_CRASH_INFO_NO_EXE;
+    if (exe != NULL)
+    {
+        g_string_append_c(arena, '\0');
+        exe_ofs = arena->len;
+        g_string_append(arena, exe);
+    }
+
+    return xorg_crash_info_from_arena(arena, reason_ofs, exe_ofs);
+}
+
 void xorg_crash_info_free(struct xorg_crash_info *crash_info)
 {
     if (crash_info == NULL)
         return;
-    free(crash_info->backtrace);
-    free(crash_info->reason);
-    free(crash_info->exe);
+    g_free(crash_info->arena);
     free(crash_info);
 }
 
-char *skip_pfx(char *str)
+static const char *xorg_crash_info_exe(const struct xorg_crash_info *crash_info)
+{
+    if (crash_info->exe == XORG_CRASH_INFO_NO_EXE)
+        return NULL;
+    return crash_info->arena + crash_info->exe;
+}
+
+/* Works on lines which are not NUL terminated, updates 'len' */
+static const char *skip_pfx_len(const char *str, size_t *len)
 {
-    if (str[0] == '[')
+    const char *const end = str + *len;
+
+    if (str < end && str[0] == '[')
     {
-        char *q = strchr(str, ']');
+        const char *q = memchr(str, ']', end - str);
         if (q)
             str = q + 1;
     }
 
-    if (str[0] == ' ')
+    if (str < end && str[0] == ' ')
         ++str;
 
     /* if there is (EE), ignore it */
-    if (strncmp(str, "(EE)", 4) == 0)
+    if (end - str >= 4 && strncmp(str, "(EE)", 4) == 0)
         /* if ' ' follows (EE), ignore it too */
-        return str + (4 + (str[4] == ' '));
+        str += 4 + (end - str > 4 && str[4] == ' ');
 
+    *len = end - str;
     return str;
 }
 
-static char *list2lines(GList *list)
+char *skip_pfx(char *str)
 {
-    struct strbuf *s = strbuf_new();
-    while (list)
-    {
-        strbuf_append_str(s, (char*)list->data);
-        strbuf_append_char(s, '\n');
-        free(list->data);
-        list = g_list_delete_link(list, list);
-    }
-    return strbuf_free_nobuf(s);
+    size_t len = strlen(str);
+    return (char *)skip_pfx_len(str, &len);
+}
+
+bool xorg_is_backtrace_start(const char *line, size_t len)
+{
+    line = skip_pfx_len(line, &len);
+    return len == strlen(XORG_SEARCH_STRING) && memcmp(line, XORG_SEARCH_STRING, len) == 0;
 }
 
 void xorg_crash_info_print_crash(struct xorg_crash_info *crash_info)
 {
-    char *reason = crash_info->reason;
-    printf("%s%s%s\n", crash_info->backtrace, reason ? reason : "", reason ? "\n" : "");
+    /* The backtrace ends with a new line */
+    printf("%s%s\n", crash_info->arena + crash_info->backtrace, crash_info->arena + crash_info->reason);
 }
 
 int xorg_crash_info_save_in_dump_dir(struct xorg_crash_info *crash_info, struct dump_dir *dd)
@@ -93,22 +124,23 @@ int xorg_crash_info_save_in_dump_dir(struct xorg_crash_info *crash_info, struct
     dd_save_text(dd, FILENAME_ABRT_VERSION, VERSION);
     dd_save_text(dd, FILENAME_ANALYZER, "abrt-xorg");
     dd_save_text(dd, FILENAME_TYPE, "xorg");
-    dd_save_text(dd, FILENAME_REASON, crash_info->reason);
-    dd_save_text(dd, FILENAME_BACKTRACE, crash_info->backtrace);
+    dd_save_text(dd, FILENAME_REASON, crash_info->arena + crash_info->reason);
+    dd_save_text(dd, FILENAME_BACKTRACE, crash_info->arena + crash_info->backtrace);
     /*
      * Reporters usually need component name to file a bug.
      * It is usually derived from executable.
      * We _guess_ X server's executable name as a last resort.
      * Better ideas?
      */
-    if (!crash_info->exe)
+    const char *exe = xorg_crash_info_exe(crash_info);
+    if (!exe)
     {
         if (access("/usr/bin/Xorg", X_OK) == 0)
-            crash_info->exe = xstrdup("/usr/bin/Xorg");
+            exe = "/usr/bin/Xorg";
         else
-            crash_info->exe = xstrdup("/usr/bin/X");
+            exe = "/usr/bin/X";
     }
-    dd_save_text(dd, FILENAME_EXECUTABLE, crash_info->exe);
+    dd_save_text(dd, FILENAME_EXECUTABLE, exe);
 
     return 0;
 }
@@ -136,10 +168,40 @@ void xorg_crash_info_create_dump_dir(struct xorg_crash_info *crash_info, const c
     free(path);
 }
 
-char *xorg_get_next_line_from_fd(void *fd)
+const char *xorg_log_region_next_line(void *region, size_t *len)
 {
-    FILE *f = (FILE *)fd;
-    return xmalloc_fgetline(f);
+    struct xorg_log_region *r = (struct xorg_log_region *)region;
+    if (r->pos >= r->end)
+        return NULL;
+
+    const char *line = r->pos;
+    const char *eol = memchr(line, '\n', r->end - line);
+    if (eol == NULL)
+        eol = r->end;
+
+    *len = eol - line;
+    r->pos = (eol < r->end ? eol + 1 : eol);
+    return line;
+}
+
+const char *xorg_log_stream_next_line(void *stream, size_t *len)
+{
+    struct xorg_log_stream *s = (struct xorg_log_stream *)stream;
+    ssize_t r = getline(&s->buffer, &s->size, s->file);
+    if (r < 0)
+    {
+        /* Don't keep the buffer after the last line */
+        free(s->buffer);
+        s->buffer = NULL;
+        s->size = 0;
+        return NULL;
+    }
+
+    if (r > 0 && s->buffer[r - 1] == '\n')
+        --r;
+
+    *len = r;
+    return s->buffer;
 }
 
 
@@ -165,23 +227,28 @@ char *xorg_get_next_line_from_fd(void *fd)
 [ 60244.273] (EE) Segmentation fault at address 0x7f61d93f6160
 [ 60244.273] (EE) 
  */
-struct xorg_crash_info *process_xorg_bt(char *(*get_next_line)(void *), void *data)
+struct xorg_crash_info *process_xorg_bt(xorg_next_line_fn get_next_line, void *data)
 {
-    char *reason = NULL;
-    char *exe = NULL;
-    GList *list = NULL;
+    /* backtrace '\0' reason ['\0' exe] */
+    GString *arena = g_string_new(NULL);
+    const char *reason = NULL;
+    size_t reason_len = 0;
+    size_t exe_ofs = XORG_CRASH_INFO_NO_EXE;
+    size_t exe_len = 0;
     unsigned cnt = 0;
-    char *line = NULL;
-    while ((line = get_next_line(data)) != NULL)
+    const char *line;
+    size_t len;
+    while ((line = get_next_line(data, &len)) != NULL)
     {
-        char *p = skip_pfx(line);
+        const char *p = skip_pfx_len(line, &len);
+        const char *const end = p + len;
 
         /* ignore empty lines
          * [ 60244.273] (EE) 13: ? (?+0x29) [0x29]
          * [ 60244.273] (EE) <---
          * [ 60244.273] (EE) Segmentation fault at address 0x7f61d93f6160
          */
-        if (*p == '\0')
+        if (len == 0)
             continue;
 
         /* xorg-server-1.12.0/os/osinit.c:
@@ -199,57 +266,121 @@ struct xorg_crash_info *process_xorg_bt(char *(*get_next_line)(void *), void *da
          */
         if (*p < '0' || *p > '9')
         {
-            if (strstr(p, " at address ") || strstr(p, " sent by process "))
+            if (memmem(p, len, " at address ", strlen(" at address "))
+                || memmem(p, len, " sent by process ", strlen(" sent by process ")))
             {
-                overlapping_strcpy(line, p);
-                reason = line;
-                line = NULL;
+                /* The line is valid until the next call of get_next_line() */
+                reason = p;
+                reason_len = len;
             }
             /* Here you can place other cases of useful reason string */
             break;
         }
 
-        errno = 0;
-        char *end;
-        IGNORE_RESULT(strtoul(p, &end, 10));
-        if (errno || end == p || *end != ':')
+        const char *num_end = p;
+        while (num_end < end && *num_end >= '0' && *num_end <= '9')
+            ++num_end;
+        if (num_end == end || *num_end != ':')
             break;
 
         /* This looks like bt line */
 
         /* Guess Xorg server's executable name from it */
-        if (!exe)
+        if (exe_ofs == XORG_CRASH_INFO_NO_EXE)
         {
-            char *filename = skip_whitespace(end + 1);
-            char *filename_end = skip_non_whitespace(filename);
-            char sv = *filename_end;
-            *filename_end = '\0';
+            const char *filename = num_end + 1;
+            while (filename < end && isspace((unsigned char)*filename))
+                ++filename;
+            const char *filename_end = filename;
+            while (filename_end < end && !isspace((unsigned char)*filename_end))
+                ++filename_end;
+            const size_t filename_len = filename_end - filename;
             /* Does it look like "[/usr]/[s]bin/Xfoo" or [/usr]/libexec/Xfoo"? */
-            if (strstr(filename, "bin/X") || strstr(filename, "libexec/X"))
-                exe = xstrdup(filename);
-            *filename_end = sv;
+            if (memmem(filename, filename_len, "bin/X", strlen("bin/X"))
+                || memmem(filename, filename_len, "libexec/X", strlen("libexec/X")))
+            {
+                exe_ofs = arena->len + (filename - p);
+                exe_len = filename_len;
+            }
         }
 
-        /* Save it to list */
-        overlapping_strcpy(line, p);
-        list = g_list_prepend(list, line);
-        line = NULL;
+        /* Save it to the arena */
+        g_string_append_len(arena, p, len);
+        g_string_append_c(arena, '\n');
         if (++cnt > 255) /* prevent ridiculously large bts */
             break;
     }
-    free(line);
 
-    if (list)
+    if (cnt == 0)
     {
-        struct xorg_crash_info *crash_info = xmalloc(sizeof(struct xorg_crash_info));
+        g_string_free(arena, TRUE);
+        return NULL;
+    }
 
-        list = g_list_reverse(list);
-        crash_info->backtrace = list2lines(list); /* frees list */
-        crash_info->reason = (reason ? reason : xstrdup(DEFAULT_XORG_CRASH_REASON));
-        crash_info->exe = exe;
+    g_string_append_c(arena, '\0');
+    const size_t reason_ofs = arena->len;
+    if (reason)
+        g_string_append_len(arena, reason, reason_len);
+    else
+        g_string_append(arena, DEFAULT_XORG_CRASH_REASON);
 
-        return crash_info;
+    if (exe_ofs != XORG_CRASH_INFO_NO_EXE)
+    {
+        g_string_append_c(arena, '\0');
+        const size_t bt_exe_ofs = exe_ofs;
+        exe_ofs = arena->len;
+        /* The executable is a part of the backtrace already in the arena */
+        g_string_set_size(arena, exe_ofs + exe_len);
+        memcpy(arena->str + exe_ofs, arena->str + bt_exe_ofs, exe_len);
     }
-    return NULL;
 
+    return xorg_crash_info_from_arena(arena, reason_ofs, exe_ofs);
+}
+
+unsigned xorg_crash_collector_feed(struct xorg_crash_collector *collector, const char *line, size_t len)
+{
+    if (collector->count == 0)
+    {
+        if (!xorg_is_backtrace_start(line, len))
+            return 0;
+
+        if (collector->lines == NULL)
+            collector->lines = g_string_new(NULL);
+    }
+
+    g_string_append_len(collector->lines, line, len);
+    g_string_append_c(collector->lines, '\n');
+    return ++collector->count;
+}
+
+GList *xorg_crash_collector_finish(struct xorg_crash_collector *collector)
+{
+    GList *crash_info_list = NULL;
+    if (collector->lines == NULL)
+        return NULL;
+
+    struct xorg_log_region region = {
+        .pos = collector->lines->str,
+        .end = collector->lines->str + collector->lines->len,
+    };
+
+    const char *line;
+    size_t len;
+    while ((line = xorg_log_region_next_line(&region, &len)) != NULL)
+    {
+        if (xorg_is_backtrace_start(line, len))
+        {
+            struct xorg_crash_info *crash_info = process_xorg_bt(xorg_log_region_next_line, &region);
+            if (crash_info)
+                crash_info_list = g_list_append(crash_info_list, crash_info);
+            else
+                log_warning(_("Failed to parse Backtrace from log file"));
+        }
+    }
+
+    g_string_free(collector->lines, TRUE);
+    collector->lines = NULL;
+    collector->count = 0;
+
+    return crash_info_list;
 }
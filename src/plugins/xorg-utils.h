@@ -40,14 +40,27 @@ int abrt_xorg_signaled_sleep(int seconds);
 
 /*
  * Information about found xorg crash
+ *
+ * All strings are stored in a single allocation and the fields hold their
+ * offsets in it.
  */
 struct xorg_crash_info
 {
-    char *backtrace;
-    char *reason;
-    char *exe;
+    char *arena;        ///< NUL terminated strings of the crash
+    size_t backtrace;   ///< offset of the backtrace in the arena
+    size_t reason;      ///< offset of the crash reason in the arena
+    size_t exe;         ///< offset of the executable or XORG_CRASH_INFO_NO_EXE
 };
 
+#define XORG_CRASH_INFO_NO_EXE ((size_t)-1)
+
+/*
+ * Create xorg crash info data from given strings
+ *
+ * @param exe the executable or NULL if unknown
+ */
+struct xorg_crash_info *xorg_crash_info_new(const char *backtrace, const char *reason, const char *exe);
+
 /*
  * Free xorg crash info data
  */
@@ -67,6 +80,14 @@ void xorg_crash_info_free(struct xorg_crash_info *crash_info);
  */
 char *skip_pfx(char *str);
 
+/*
+ * Checks whether the line starts an Xorg backtrace
+ *
+ * @param line line from log file, doesn't have to be NUL terminated
+ * @param len length of the line
+ */
+bool xorg_is_backtrace_start(const char *line, size_t len);
+
 /*
  * Prints information about found xorg crash
  *
@@ -75,23 +96,51 @@ char *skip_pfx(char *str);
 void xorg_crash_info_print_crash(struct xorg_crash_info *crash_info);
 
 /*
- * Get next line from given stream (FILE *)
- * Use as wrapper for reading function
+ * Reading functions of process_xorg_bt()
  *
- * @param fd open FILE * as void *
- * @returns malloced and unlimited line without railing \n
+ * The functions return the next line without the trailing new line character
+ * and store its length in 'len'. The line is not NUL terminated and is valid
+ * only until the next call. NULL is returned at the end of input.
  */
-char *xorg_get_next_line_from_fd(void *fd);
+typedef const char *(*xorg_next_line_fn)(void *data, size_t *len);
+
+/*
+ * Lines of a memory region, e.g. of a mapped log file
+ */
+struct xorg_log_region
+{
+    const char *pos;
+    const char *end;
+};
+
+const char *xorg_log_region_next_line(void *region, size_t *len);
+
+/*
+ * Lines of a stream (FILE *), the lines are read to a reused buffer
+ */
+struct xorg_log_stream
+{
+    FILE *file;
+    char *buffer;
+    size_t size;
+};
+
+#define XORG_LOG_STREAM_INIT(f) { .file = (f), .buffer = NULL, .size = 0 }
+
+const char *xorg_log_stream_next_line(void *stream, size_t *len);
 
 /*
  * Process Xorg Backtrace
  * This function is called after the key word "Backtrace:" was found in log.
  *
+ * The lines are not copied, only the backtrace lines and the reason are
+ * appended to the arena of the returned crash info.
+ *
  * @param get_next_line function used for reading lines from data
  * @param data is used as get_nex_line function parameter
  * @returns extracted xorg crash data or NULL in case of error
  */
-struct xorg_crash_info *process_xorg_bt(char *(*get_next_line)(void *), void *data);
+struct xorg_crash_info *process_xorg_bt(xorg_next_line_fn get_next_line, void *data);
 
 /*
  * Saves Xorg crash details in the dump directory
@@ -112,6 +161,38 @@ int xorg_crash_info_save_in_dump_dir(struct xorg_crash_info *crash_info, struct
 void xorg_crash_info_create_dump_dir(struct xorg_crash_info *crash_info, const char *dump_location,
                                      bool world_readable);
 
+/*
+ * Collects the log lines of crashes for process_xorg_bt() when the lines come
+ * one by one and the end of the backtrace is not known in advance
+ */
+struct xorg_crash_collector
+{
+    GString *lines;     ///< lines starting with the first "Backtrace:" line
+    unsigned count;     ///< number of the collected lines
+};
+
+#define XORG_CRASH_COLLECTOR_INIT { .lines = NULL, .count = 0 }
+
+/* process_xorg_bt() reads at most 256 frames, so a longer sequence of lines
+ * following "Backtrace:" is not worth keeping */
+#define XORG_MAX_COLLECTED_LINES 300
+
+/*
+ * Copies the line to the collector; lines before the first "Backtrace:" line
+ * are ignored
+ *
+ * @param line line from log file, doesn't have to be NUL terminated
+ * @returns the number of collected lines
+ */
+unsigned xorg_crash_collector_feed(struct xorg_crash_collector *collector, const char *line, size_t len);
+
+/*
+ * Extracts the crashes from the collected lines and releases the lines
+ *
+ * @returns a list of struct xorg_crash_info
+ */
+GList *xorg_crash_collector_finish(struct xorg_crash_collector *collector);
+
 #ifdef __cplusplus
 }
 #endif
@@ -92,6 +92,21 @@ rlJournalStart
 
     rlPhaseEnd
 
+    rlPhaseStartTest "FindProblemByElementInTimeRange indexed element"
+
+        executable=`cat $crash_PATH/executable`
+
+        rlRun "dbus-send --system --type=method_call --print-reply --dest=org.freedesktop.problems /org/freedesktop/problems org.freedesktop.problems.FindProblemByElementInTimeRange string:executable string:${executable} int64:${time_from} int64:`date +%s` boolean:true &> dbus_reply_indexed.log"
+
+        rlAssertGrep "array" dbus_reply_indexed.log
+        rlAssertGrep "$crash_PATH" dbus_reply_indexed.log
+
+        rlRun "dbus-send --system --type=method_call --print-reply --dest=org.freedesktop.problems /org/freedesktop/problems org.freedesktop.problems.FindProblemByElementInTimeRange string:executable string:${executable} int64:0 int64:$((time_from - 1)) boolean:true &> dbus_reply_indexed_before.log"
+
+        rlAssertNotGrep "$crash_PATH" dbus_reply_indexed_before.log
+
+    rlPhaseEnd
+
     rlPhaseStartCleanup
         rlRun "abrt-cli rm $crash_PATH" 0 "Remove crash directory"
         rlBundleLogs abrt *.log
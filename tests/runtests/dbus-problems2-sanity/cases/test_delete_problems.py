@@ -1,7 +1,8 @@
 #!/usr/bin/python3
 
 import abrt_p2_testing
-from abrt_p2_testing import (wait_for_task_new_problem,
+from abrt_p2_testing import (wait_for_task_new_problem, wait_for_task_status,
+                             create_problem, Problems2Task,
                              DBUS_ERROR_BAD_ADDRESS,)
 
 
@@ -62,6 +63,34 @@ class TestDeleteProblemsSanity(abrt_p2_testing.TestCase):
                                    self.p2.DeleteProblems,
                                    ["/org/freedesktop/Problems2/Entry/FAKE"])
 
+    def test_delete_problems_task(self):
+        one = create_problem(self, self.p2, bus=self.bus, wait=True)
+        two = create_problem(self, self.p2, bus=self.bus, wait=True)
+
+        task_path = self.p2.DeleteProblemsTask([one, two])
+
+        # The entries disappear before their data are removed
+        p = self.p2.GetProblems(0, dict())
+
+        self.assertNotIn(one, p)
+        self.assertNotIn(two, p)
+
+        task = Problems2Task(self.bus, task_path)
+        if task.getproperty("Status") != 5:
+            wait_for_task_status(self, self.bus, task_path, 5)
+
+        details = task.getproperty("Details")
+        self.assertEqual(2, details["DeleteProblems.Total"])
+        self.assertEqual(2, details["DeleteProblems.Deleted"])
+
+        results, code = task.Finish()
+        self.assertEqual(0, code)
+        self.assertEqual(0, len(results["DeleteProblems.NotDeleted"]))
+
+        self.assertRaisesDBusError(DBUS_ERROR_BAD_ADDRESS,
+                                   self.p2.DeleteProblemsTask,
+                                   [one])
+
 
 if __name__ == "__main__":
     abrt_p2_testing.main(TestDeleteProblemsSanity)
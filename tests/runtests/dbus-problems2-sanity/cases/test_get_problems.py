@@ -3,8 +3,11 @@
 
 import time
 
+import dbus
+
 import abrt_p2_testing
-from abrt_p2_testing import (wait_for_task_status)
+from abrt_p2_testing import (wait_for_task_status,
+                             wait_for_task_new_problem)
 
 
 class TestGetProblems(abrt_p2_testing.TestCase):
@@ -61,6 +64,76 @@ class TestGetProblems(abrt_p2_testing.TestCase):
         new_problems = self.p2.GetProblems(0x1 | 0x2, dict())
         self.assertEquals(0, len(new_problems))
 
+    def test_get_problems_filtered(self):
+        description = {"analyzer": "problems2testsuite_analyzer",
+                       "type": "problems2testsuite_type",
+                       "reason": "Application has been killed",
+                       "backtrace": "die()",
+                       "executable": "/usr/bin/true",
+                       "duphash": "GET_PROBLEMS_TRUE",
+                       "uuid": "GET_PROBLEMS_TRUE"}
+
+        task_path = self.p2.NewProblem(description, 0x1)
+        true_problem = wait_for_task_new_problem(self, self.bus, task_path)
+
+        # LastOccurrence has one second resolution
+        time.sleep(1)
+
+        description["executable"] = "/usr/bin/false"
+        description["duphash"] = description["uuid"] = "GET_PROBLEMS_FALSE"
+        task_path = self.p2.NewProblem(description, 0x1)
+        false_problem = wait_for_task_new_problem(self, self.bus, task_path)
+
+        p = self.p2.GetProblems(0, {"executable": "/usr/bin/true"})
+        self.assertIn(true_problem, p)
+        self.assertNotIn(false_problem, p)
+
+        p = self.p2.GetProblems(0, {"type": "problems2testsuite_type",
+                                    "not_reported": True,
+                                    "since": dbus.UInt64(0)})
+        self.assertIn(true_problem, p)
+        self.assertIn(false_problem, p)
+
+        p = self.p2.GetProblems(0, {"until": dbus.UInt64(1)})
+        self.assertNotIn(true_problem, p)
+        self.assertNotIn(false_problem, p)
+
+        p = self.p2.GetProblems(0, {"type": "problems2testsuite_type",
+                                    "sort": "-time",
+                                    "limit": dbus.UInt32(1)})
+        self.assertEqual([false_problem], p)
+
+        p = self.p2.GetProblems(0, {"type": "problems2testsuite_type",
+                                    "sort": "-time",
+                                    "offset": dbus.UInt32(1),
+                                    "limit": dbus.UInt32(1)})
+        self.assertEqual([true_problem], p)
+
+        p = self.p2.GetProblems(0, {"foo": "bar"})
+        self.assertEqual(sorted(self.p2.GetProblems(0, dict())), sorted(p))
+
+        self.assertRaisesDBusError(
+            "org.freedesktop.DBus.Error.InvalidArgs: Option 'limit' must be of type 'u'",
+            self.p2.GetProblems, 0, {"limit": "bar"})
+
+        summary = self.p2.GetProblemsSummary(
+            0, {"problems": dbus.Array([true_problem, false_problem],
+                                       signature="o"),
+                "sort": "time"},
+            ["Executable", "Count"])
+        self.assertEqual(2, len(summary))
+        self.assertEqual(true_problem, summary[0]["Entry"])
+        self.assertEqual("/usr/bin/true", summary[0]["Executable"])
+        self.assertEqual(1, summary[0]["Count"])
+        self.assertEqual(false_problem, summary[1]["Entry"])
+        self.assertEqual("/usr/bin/false", summary[1]["Executable"])
+
+        self.assertRaisesDBusError(
+            "org.freedesktop.DBus.Error.InvalidArgs: Unknown property 'Foo'",
+            self.p2.GetProblemsSummary, 0, dict(), ["Foo"])
+
+        self.p2.DeleteProblems([true_problem, false_problem])
+
 
 if __name__ == "__main__":
     abrt_p2_testing.main(TestGetProblems)
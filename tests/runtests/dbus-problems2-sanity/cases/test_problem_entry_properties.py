@@ -137,6 +137,33 @@ class TestProblemEntryProperties(abrt_p2_testing.TestCase):
                          len(semantic_elements),
                          "No SemanticElements")
 
+    def test_problem_entry_properties_changed(self):
+        p2e = Problems2Entry(self.bus, self.p2_entry_path)
+
+        invalidations = []
+
+        def on_properties_changed(iface, changed, invalidated):
+            self.assertEqual(0, len(changed), "sent property values")
+            invalidations.append(invalidated)
+            self.interrupt_waiting()
+
+        p2e.getobjectproperties().connect_to_signal("PropertiesChanged",
+                                                    on_properties_changed)
+
+        p2e.SaveElements({"reason": "Changed reason"}, 0x0)
+        self.assertEqual("Changed reason",
+                         p2e.getproperty("Reason"),
+                         "the reason was read before the change notification")
+
+        self.wait_for_signals(["PropertiesChanged"])
+
+        self.assertEqual(1, len(invalidations), "PropertiesChanged not emitted")
+        self.assertIn("Reason", invalidations[0], "Reason not invalidated")
+        self.assertNotIn("Type", invalidations[0], "Type invalidated")
+        self.assertEqual("Changed reason",
+                         p2e.getproperty("Reason"),
+                         "the cached reason was not refreshed")
+
 
 if __name__ == "__main__":
     abrt_p2_testing.main(TestProblemEntryProperties)
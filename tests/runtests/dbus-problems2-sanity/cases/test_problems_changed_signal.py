@@ -0,0 +1,105 @@
+#!/usr/bin/python3
+# vim: set makeprg=python3-flake8\ %
+
+import os
+
+import abrt_p2_testing
+from abrt_p2_testing import (create_problem, get_session)
+
+
+class TestProblemsChangedSignal(abrt_p2_testing.TestCase):
+
+    def setUp(self):
+        self.p2.connect_to_signal("ProblemsChanged",
+                                  self.handle_problems_changed)
+
+        self.problems_changed_occurrences = []
+        self.p2_entry_paths = []
+
+        self.session = get_session(self)
+        self.session.SubscribeProblemsChanged(1000)
+
+    def tearDown(self):
+        self.session.UnsubscribeProblemsChanged()
+
+        if self.p2_entry_paths:
+            self.p2.DeleteProblems(self.p2_entry_paths)
+
+    def handle_problems_changed(self, new, changed, deleted, summary):
+        if "ProblemsChanged" not in self.signals:
+            return
+
+        self.interrupt_waiting(False)
+        self.problems_changed_occurrences.append((new, changed, deleted,
+                                                  summary))
+
+    def wait_for_new_problems(self, count):
+        new = set()
+        summary = dict()
+        for _ in range(0, count):
+            self.loop_counter += 1
+            self.wait_for_signals(["ProblemsChanged"])
+
+            for occurrence in self.problems_changed_occurrences:
+                new.update(occurrence[0])
+                summary.update((s["Entry"], s) for s in occurrence[3])
+
+            if len(new) >= count:
+                break
+
+        return new, summary
+
+    def test_batch_of_new_problems(self):
+        create_problem(self, self.p2, bus=self.bus, wait=False)
+        create_problem(self, self.p2, bus=self.bus, wait=False)
+
+        new, summary = self.wait_for_new_problems(2)
+        self.p2_entry_paths = list(new)
+
+        self.assertEqual(2, len(new), "ProblemsChanged missed new problems")
+
+        for entry_path in new:
+            self.assertIn(entry_path, summary)
+            self.assertEqual(os.geteuid(), summary[entry_path]["UID"])
+            self.assertEqual("problems2testsuite_type",
+                             summary[entry_path]["Type"])
+            self.assertEqual("Application has been killed",
+                             summary[entry_path]["Reason"])
+
+    def test_deleted_problems(self):
+        create_problem(self, self.p2, bus=self.bus, wait=False)
+
+        new, _ = self.wait_for_new_problems(1)
+        self.assertEqual(1, len(new), "ProblemsChanged missed a new problem")
+
+        self.problems_changed_occurrences = []
+        self.p2.DeleteProblems(list(new))
+
+        # Changes of the new problem might come in a separate signal
+        deleted = []
+        for _ in range(0, 3):
+            self.loop_counter += 1
+            self.wait_for_signals(["ProblemsChanged"])
+
+            deleted = [p for o in self.problems_changed_occurrences
+                       for p in o[2]]
+            if deleted:
+                break
+
+        self.assertEqual(list(new), deleted)
+
+    def test_unsubscribed(self):
+        self.session.UnsubscribeProblemsChanged()
+
+        new_path = create_problem(self, self.p2, bus=self.bus, wait=True)
+        self.p2_entry_paths = [new_path]
+
+        # This must timeout - the client is not subscribed
+        self.loop_counter += 1
+        self.wait_for_signals(["ProblemsChanged"], timeout=3000)
+
+        self.assertEqual(0, len(self.problems_changed_occurrences))
+
+
+if __name__ == "__main__":
+    abrt_p2_testing.main(TestProblemsChangedSignal)
@@ -82,6 +82,29 @@ class TestReadElements(abrt_p2_testing.TestCase):
         finally:
             os.close(fd)
 
+    def test_read_large_elements(self):
+        requested = { "reason" : dbus.types.String,
+                      "hugetext" : dbus.types.UnixFd }
+
+        p2e = Problems2Entry(self.bus, self.p2_entry_path)
+        elements = p2e.ReadElements(requested.keys(), 0x40)
+
+        for r, t in requested.items():
+            self.assertIn(r, elements)
+            self.assertEqual(t, type(elements[r]))
+
+        fd = elements["hugetext"].take()
+        try:
+            data = os.read(fd, len("ABRT test case huge file "))
+            self.assertEqual("ABRT test case huge file ", data.decode())
+        finally:
+            os.close(fd)
+
+        self.assertRaisesDBusError(
+            "org.freedesktop.DBus.Error.InvalidArgs: "
+            "Invalid arguments 'LARGE FD' ~ 'ALL NO FD'",
+            p2e.ReadElements, requested.keys(), 0x40 | 0x20)
+
     def test_read_byte_elements(self):
         exp = { "bytes" : dbus.types.Array(bytearray([0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0xA, 0xB, 0xC, 0xD, 0xE, 0xF]), "y") }
         p2e = Problems2Entry(self.bus, self.p2_entry_path)